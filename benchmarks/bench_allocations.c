@@ -0,0 +1,118 @@
+// Abstract Shader Engine - Jed Fakhfekh - https://github.com/ougi-washi
+
+// allocates live blocks and frees them in shuffled order, for a sweep of live counts and several passes each.
+// with AS_MEMORY_TRACKING on this times the allocation table, the cost per block should stay flat as the table fills
+// usage: bench_allocations [passes] [live blocks...], defaults to 5 passes at 1000 10000 100000 250000
+
+#include "as_memory.h"
+#include "as_utility.h"
+
+static u64 bench_random_state = 0x9E3779B97F4A7C15ull;
+
+static u64 bench_random()
+{
+	bench_random_state ^= bench_random_state << 13;
+	bench_random_state ^= bench_random_state >> 7;
+	bench_random_state ^= bench_random_state << 17;
+	return bench_random_state;
+}
+
+typedef struct bench_allocations_times
+{
+	f64 malloc_ns;
+	f64 realloc_ns;
+	f64 free_ns;
+} bench_allocations_times;
+
+// one pass, per block costs in nanoseconds
+static bench_allocations_times bench_allocations_pass(void** blocks, sz* order, const sz block_count)
+{
+	for (sz i = 0; i < block_count; i++) { order[i] = i; }
+	for (sz i = block_count - 1; i > 0; i--)
+	{
+		const sz j = (sz)(bench_random() % (i + 1));
+		const sz swap = order[i];
+		order[i] = order[j];
+		order[j] = swap;
+	}
+
+	const f64 start = get_monotonic_time();
+	for (sz i = 0; i < block_count; i++)
+	{
+		blocks[i] = AS_MALLOC(16 + (bench_random() & 63));
+	}
+	const f64 allocated = get_monotonic_time();
+	for (sz i = 0; i < block_count; i += 2)
+	{
+		blocks[order[i]] = AS_REALLOC(blocks[order[i]], 128);
+	}
+	const f64 reallocated = get_monotonic_time();
+	for (sz i = 0; i < block_count; i++)
+	{
+		AS_FREE(blocks[order[i]]);
+	}
+	const f64 freed = get_monotonic_time();
+
+	bench_allocations_times times = { 0 };
+	times.malloc_ns = (allocated - start) * 1e9 / (f64)block_count;
+	times.realloc_ns = (reallocated - allocated) * 1e9 / (f64)((block_count + 1) / 2);
+	times.free_ns = (freed - reallocated) * 1e9 / (f64)block_count;
+	return times;
+}
+
+#define BENCH_ALLOCATIONS_MAX_POINTS 16
+
+i32 main(i32 argc, char** argv)
+{
+	const u32 pass_count = argc > 1 ? (u32)atoi(argv[1]) : 5;
+	sz block_counts[BENCH_ALLOCATIONS_MAX_POINTS] = { 1000, 10000, 100000, 250000 };
+	u32 point_count = 4;
+	if (argc > 2)
+	{
+		point_count = 0;
+		for (i32 i = 2; i < argc && point_count < BENCH_ALLOCATIONS_MAX_POINTS; i++)
+		{
+			block_counts[point_count++] = (sz)atoll(argv[i]);
+		}
+	}
+	sz max_block_count = 0;
+	for (u32 i = 0; i < point_count; i++)
+	{
+		max_block_count = block_counts[i] > max_block_count ? block_counts[i] : max_block_count;
+	}
+#if AS_MEMORY_TRACKING
+	const b8 fits = max_block_count < MAX_ALLOCATIONS_COUNT;
+#else
+	const b8 fits = true;
+#endif
+	if (pass_count == 0 || max_block_count == 0 || !fits)
+	{
+		printf("usage: bench_allocations [passes] [live blocks...], live blocks stay under the table capacity\n");
+		return 1;
+	}
+
+	// raw malloc so the bookkeeping of the benchmark itself is not in the table
+	void** blocks = (void**)malloc(max_block_count * sizeof(void*));
+	sz* order = (sz*)malloc(max_block_count * sizeof(sz));
+	if (!blocks || !order) { return 1; }
+
+	printf("bench_allocations: tracking=%d passes=%u, best pass per live count, ns per block\n", AS_MEMORY_TRACKING, pass_count);
+	printf("  %10s %10s %10s %14s\n", "live", "malloc", "realloc", "shuffled free");
+	for (u32 point = 0; point < point_count; point++)
+	{
+		bench_allocations_times best = { 0 };
+		for (u32 pass = 0; pass < pass_count; pass++)
+		{
+			const bench_allocations_times times = bench_allocations_pass(blocks, order, block_counts[point]);
+			if (pass == 0 || times.malloc_ns + times.realloc_ns + times.free_ns < best.malloc_ns + best.realloc_ns + best.free_ns)
+			{
+				best = times;
+			}
+		}
+		printf("  %10zu %10.1f %10.1f %14.1f\n", (size_t)block_counts[point], best.malloc_ns, best.realloc_ns, best.free_ns);
+	}
+
+	free(order);
+	free(blocks);
+	return 0;
+}
@@ -0,0 +1,91 @@
+// Abstract Shader Engine - Jed Fakhfekh - https://github.com/ougi-washi
+
+// draws a grid of cubes headless for a number of frames and prints the frame times,
+// the game thread time of as_engine_draw and the interval between two read back frames, then the render queue stats
+// needs a vulkan device (lavapipe works), run it from the binaries directory like the engine for the resources paths
+// usage: bench_frames [objects] [frames] [width] [height]
+
+#include "as_engine.h"
+#include "core/as_render_queue.h"
+
+#define BENCH_FRAMES_WARMUP 30 // frames left out of the results, pipelines and uploads happen there
+
+typedef struct bench_frames_readback
+{
+	as_histogram interval; // microseconds between two delivered frames
+	f64 last_time;
+	u64 count;
+} bench_frames_readback;
+
+static void bench_frames_on_readback(void* user_data, const u8* pixels, const u32 width, const u32 height, const u64 frame_index)
+{
+	bench_frames_readback* readback = (bench_frames_readback*)user_data;
+	const f64 now = get_monotonic_time();
+	if (readback->count++ >= BENCH_FRAMES_WARMUP)
+	{
+		as_histogram_record(&readback->interval, (u64)((now - readback->last_time) * 1e6));
+	}
+	readback->last_time = now;
+}
+
+static void bench_frames_print(const char* label, as_histogram* histogram)
+{
+	const as_histogram_summary summary = as_histogram_summarize(histogram);
+	printf("  %-22s p50 %6llu us, p95 %6llu us, p99 %6llu us, max %6llu us over %lld frames\n", label, (unsigned long long)summary.p50,
+		(unsigned long long)summary.p95, (unsigned long long)summary.p99, (unsigned long long)summary.max, (long long)summary.count);
+}
+
+i32 main(i32 argc, char** argv)
+{
+	const u32 object_count = argc > 1 ? (u32)atoi(argv[1]) : 1000;
+	const u64 frame_count = argc > 2 ? (u64)atoll(argv[2]) : 600;
+	const u32 width = argc > 3 ? (u32)atoi(argv[3]) : 1280;
+	const u32 height = argc > 4 ? (u32)atoi(argv[4]) : 720;
+	if (frame_count <= BENCH_FRAMES_WARMUP)
+	{
+		printf("usage: bench_frames [objects] [frames, more than %d] [width] [height]\n", BENCH_FRAMES_WARMUP);
+		return 1;
+	}
+
+	static bench_frames_readback readback = { 0 };
+	if (!as_engine_init_headless(width, height, frame_count, bench_frames_on_readback, &readback))
+	{
+		return 1;
+	}
+
+	as_scene* scene = as_scene_create(as_engine_get_render(), AS_PATH_DEFAULT_SCENE);
+	as_engine_set_scene(scene);
+	as_camera* camera = as_camera_create(AS_VEC_PTR(as_vec3, -40.f, -40.f, 30.f), AS_VEC_PTR(as_vec3, 0.f, 0.f, 0.f));
+	as_camera_set_view(camera, AS_CAMERA_FREE);
+	as_shader* shader = as_shader_create(AS_PATH_DEFAULT_VERT_SHADER, AS_PATH_EMPTY_GRAY_FRAG_SHADER);
+	as_shape* cube = as_generate_cube();
+	as_asset_register(cube, AS_ASSET_TYPE_SHAPE);
+	const u32 row_size = (u32)ceil(sqrt((f64)object_count));
+	for (u32 i = 0; i < object_count; i++)
+	{
+		as_object* object = as_object_create(cube, shader);
+		as_object_set_translation(object, AS_VEC_PTR(as_vec3, (f32)(i % row_size) * 2.f, (f32)(i / row_size) * 2.f, 0.f));
+	}
+
+	static as_histogram draw_time = { 0 }; // microseconds
+	u64 frame = 0;
+	while (as_engine_should_loop())
+	{
+		const f64 start = get_monotonic_time();
+		as_engine_draw();
+		if (frame++ >= BENCH_FRAMES_WARMUP)
+		{
+			as_histogram_record(&draw_time, (u64)((get_monotonic_time() - start) * 1e6));
+		}
+	}
+	as_rq_wait_queue(as_engine_get_render_queue());
+
+	printf("bench_frames: %u objects, %llu frames, %ux%u, frame latency %u\n", object_count, (unsigned long long)frame_count,
+		width, height, as_engine_get_frame_latency());
+	bench_frames_print("as_engine_draw", &draw_time);
+	bench_frames_print("read back interval", &readback.interval);
+	as_rq_log_stats(as_engine_get_render_queue());
+
+	as_engine_clear();
+	return 0;
+}
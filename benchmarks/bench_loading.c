@@ -0,0 +1,129 @@
+// Abstract Shader Engine - Jed Fakhfekh - https://github.com/ougi-washi
+
+// draws a few cubes headless, then creates a burst of objects in one game frame with the synchronous as_object_create
+// and keeps drawing while their uploads stream in on the background lane. prints the game thread time of as_engine_draw
+// and the interval between two read back frames, before and during the burst, and how many frames the burst spanned.
+// needs a vulkan device (lavapipe works), run it from the binaries directory like the engine for the resources paths
+// usage: bench_loading [objects in the burst] [frames] [width] [height]
+
+#include "as_engine.h"
+#include "core/as_render_queue.h"
+
+#define BENCH_LOADING_WARMUP 30 // frames left out of the results, pipelines and uploads happen there
+#define BENCH_LOADING_BURST_FRAME 90 // the game frame creating the burst
+#define BENCH_LOADING_STEADY_OBJECTS 16
+
+typedef enum bench_loading_phase
+{
+	BENCH_LOADING_PHASE_STEADY	= 0x00,
+	BENCH_LOADING_PHASE_BURST	= 0x01, // until the background lane drained
+	BENCH_LOADING_PHASE_COUNT	= 0x02
+} bench_loading_phase;
+
+static as_histogram draw_times[BENCH_LOADING_PHASE_COUNT] = { 0 }; // microseconds
+static as_histogram readback_intervals[BENCH_LOADING_PHASE_COUNT] = { 0 }; // microseconds between two delivered frames
+static volatile i64 phase = BENCH_LOADING_PHASE_STEADY; // read on the render thread by the read back
+static f64 last_readback_time = 0.;
+static u64 readback_count = 0;
+
+static void bench_loading_on_readback(void* user_data, const u8* pixels, const u32 width, const u32 height, const u64 frame_index)
+{
+	const f64 now = get_monotonic_time();
+	if (readback_count++ >= BENCH_LOADING_WARMUP)
+	{
+		as_histogram_record(&readback_intervals[AS_ATOMIC_LOAD_I64(&phase)], (u64)((now - last_readback_time) * 1e6));
+	}
+	last_readback_time = now;
+}
+
+static void bench_loading_print(const char* label, as_histogram* histogram)
+{
+	const as_histogram_summary summary = as_histogram_summarize(histogram);
+	printf("  %-34s p50 %6llu us, p99 %6llu us, max %6llu us over %lld frames\n", label, (unsigned long long)summary.p50,
+		(unsigned long long)summary.p99, (unsigned long long)summary.max, (long long)summary.count);
+}
+
+i32 main(i32 argc, char** argv)
+{
+	const u32 burst_count = argc > 1 ? (u32)atoi(argv[1]) : 2000;
+	const u64 frame_count = argc > 2 ? (u64)atoll(argv[2]) : 600;
+	const u32 width = argc > 3 ? (u32)atoi(argv[3]) : 1280;
+	const u32 height = argc > 4 ? (u32)atoi(argv[4]) : 720;
+	if (burst_count == 0 || frame_count <= BENCH_LOADING_BURST_FRAME)
+	{
+		printf("usage: bench_loading [objects in the burst] [frames, more than %d] [width] [height]\n", BENCH_LOADING_BURST_FRAME);
+		return 1;
+	}
+
+	if (!as_engine_init_headless(width, height, frame_count, bench_loading_on_readback, NULL))
+	{
+		return 1;
+	}
+
+	as_scene* scene = as_scene_create(as_engine_get_render(), AS_PATH_DEFAULT_SCENE);
+	as_engine_set_scene(scene);
+	as_camera* camera = as_camera_create(AS_VEC_PTR(as_vec3, -40.f, -40.f, 30.f), AS_VEC_PTR(as_vec3, 0.f, 0.f, 0.f));
+	as_camera_set_view(camera, AS_CAMERA_FREE);
+	as_shader* shader = as_shader_create(AS_PATH_DEFAULT_VERT_SHADER, AS_PATH_EMPTY_GRAY_FRAG_SHADER);
+	as_shape* cube = as_generate_cube();
+	as_asset_register(cube, AS_ASSET_TYPE_SHAPE);
+	const u32 row_size = (u32)ceil(sqrt((f64)(burst_count + BENCH_LOADING_STEADY_OBJECTS)));
+	u32 object_count = 0;
+	for (; object_count < BENCH_LOADING_STEADY_OBJECTS; object_count++)
+	{
+		as_object* object = as_object_create(cube, shader);
+		as_object_set_translation(object, AS_VEC_PTR(as_vec3, (f32)(object_count % row_size) * 2.f, (f32)(object_count / row_size) * 2.f, 0.f));
+	}
+
+	as_render_queue* render_queue = as_engine_get_render_queue();
+	u64 frame = 0;
+	u64 burst_end_frame = 0;
+	f64 burst_start_time = 0.;
+	f64 burst_time = 0.;
+	while (as_engine_should_loop())
+	{
+		if (frame == BENCH_LOADING_BURST_FRAME)
+		{
+			burst_start_time = get_monotonic_time();
+			AS_ATOMIC_STORE_I64(&phase, BENCH_LOADING_PHASE_BURST);
+			for (; object_count < BENCH_LOADING_STEADY_OBJECTS + burst_count; object_count++)
+			{
+				as_object* object = as_object_create(cube, shader);
+				as_object_set_translation(object, AS_VEC_PTR(as_vec3, (f32)(object_count % row_size) * 2.f, (f32)(object_count / row_size) * 2.f, 0.f));
+			}
+		}
+		const f64 start = get_monotonic_time();
+		as_engine_draw();
+		if (frame >= BENCH_LOADING_WARMUP)
+		{
+			as_histogram_record(&draw_times[AS_ATOMIC_LOAD_I64(&phase)], (u64)((get_monotonic_time() - start) * 1e6));
+		}
+		if (AS_ATOMIC_LOAD_I64(&phase) == BENCH_LOADING_PHASE_BURST && as_rq_get_lane_size(render_queue, AS_RENDER_LANE_BACKGROUND) == 0)
+		{
+			burst_time = get_monotonic_time() - burst_start_time;
+			burst_end_frame = frame;
+			AS_ATOMIC_STORE_I64(&phase, BENCH_LOADING_PHASE_STEADY);
+		}
+		frame++;
+	}
+	as_rq_wait_queue(render_queue);
+
+	printf("bench_loading: %u objects in the burst at frame %d, %llu frames, %ux%u, frame latency %u\n", burst_count, BENCH_LOADING_BURST_FRAME,
+		(unsigned long long)frame_count, width, height, as_engine_get_frame_latency());
+	if (burst_end_frame)
+	{
+		printf("  burst uploaded in %.1f ms over %llu frames\n", burst_time * 1e3, (unsigned long long)(burst_end_frame - BENCH_LOADING_BURST_FRAME + 1));
+	}
+	else
+	{
+		printf("  burst still uploading after the last frame, run more frames\n");
+	}
+	bench_loading_print("as_engine_draw, steady", &draw_times[BENCH_LOADING_PHASE_STEADY]);
+	bench_loading_print("as_engine_draw, during the burst", &draw_times[BENCH_LOADING_PHASE_BURST]);
+	bench_loading_print("read back interval, steady", &readback_intervals[BENCH_LOADING_PHASE_STEADY]);
+	bench_loading_print("read back interval, during the burst", &readback_intervals[BENCH_LOADING_PHASE_BURST]);
+	as_rq_log_stats(render_queue);
+
+	as_engine_clear();
+	return 0;
+}
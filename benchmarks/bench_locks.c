@@ -0,0 +1,141 @@
+// Abstract Shader Engine - Jed Fakhfekh - https://github.com/ougi-washi
+
+// threads increment a shared counter inside a critical section, once with AS_WAIT_AND_LOCK and once with as_mutex
+// the counter is read, some work is done and it is written back, so a lost increment means the lock failed.
+// both variants run the same non inlined section, after a warm-up round, in alternating order over several rounds,
+// and the median round is reported: a single cold run mostly measures the cpu clocking up, not the lock.
+// usage: bench_locks [threads] [sections per thread] [work iterations per section] [rounds]
+
+#include "as_threads.h"
+#include "as_utility.h"
+
+#define BENCH_LOCKS_MAX_THREADS 16
+#define BENCH_LOCKS_MAX_ROUNDS 31
+
+typedef struct bench_locks_shared
+{
+	AS_DECLARE_TYPE;
+	u64 counter;
+} bench_locks_shared;
+
+static bench_locks_shared shared = { 0 };
+static as_mutex shared_mutex = AS_MUTEX_INITIALIZER;
+static volatile u64 bench_locks_sink = 0; // the work of both variants goes through it so neither is optimised away
+static b8 is_using_mutex = false;
+static i32 section_count = 0;
+static i32 work_count = 0;
+
+#if defined(_MSC_VER)
+#define BENCH_NOINLINE __declspec(noinline)
+#else
+#define BENCH_NOINLINE __attribute__((noinline))
+#endif
+
+static BENCH_NOINLINE void bench_locks_section()
+{
+	const u64 counter = shared.counter;
+	u64 work = 0;
+	for (i32 i = 0; i < work_count; i++)
+	{
+		work += bench_locks_sink ^ (u64)i;
+	}
+	bench_locks_sink = work;
+	shared.counter = counter + 1;
+}
+
+static void* bench_locks_thread(void* arg)
+{
+	for (i32 i = 0; i < section_count; i++)
+	{
+		if (is_using_mutex)
+		{
+			as_mutex_lock(&shared_mutex);
+			bench_locks_section();
+			as_mutex_unlock(&shared_mutex);
+		}
+		else
+		{
+			AS_WAIT_AND_LOCK(&shared);
+			bench_locks_section();
+			AS_UNLOCK(&shared);
+		}
+	}
+	return NULL;
+}
+
+// ns per section, negative when an increment was lost
+static f64 bench_locks_run(const b8 use_mutex, const u32 thread_count)
+{
+	is_using_mutex = use_mutex;
+	shared.counter = 0;
+	as_thread threads[BENCH_LOCKS_MAX_THREADS];
+	const f64 start = get_monotonic_time();
+	for (u32 i = 0; i < thread_count; i++) { threads[i] = as_thread_create(bench_locks_thread, NULL); }
+	for (u32 i = 0; i < thread_count; i++) { as_thread_join(threads[i]); }
+	const f64 elapsed = get_monotonic_time() - start;
+
+	const u64 expected = (u64)thread_count * (u64)section_count;
+	return shared.counter == expected ? elapsed * 1e9 / (f64)expected : -1.;
+}
+
+static i32 bench_locks_compare(const void* a, const void* b)
+{
+	const f64 lhs = *(const f64*)a;
+	const f64 rhs = *(const f64*)b;
+	return lhs < rhs ? -1 : lhs > rhs ? 1 : 0;
+}
+
+// median over the rounds, the variants swap order every round
+static b8 bench_locks_measure(const char* name, const u32 thread_count, const u32 round_count)
+{
+	f64 spinlock_ns[BENCH_LOCKS_MAX_ROUNDS];
+	f64 mutex_ns[BENCH_LOCKS_MAX_ROUNDS];
+	b8 is_exclusive = true;
+	bench_locks_run(false, thread_count); // warm-up
+	bench_locks_run(true, thread_count);
+	for (u32 round = 0; round < round_count; round++)
+	{
+		const b8 is_mutex_first = (round & 1) != 0;
+		const f64 first = bench_locks_run(is_mutex_first, thread_count);
+		const f64 second = bench_locks_run(!is_mutex_first, thread_count);
+		spinlock_ns[round] = is_mutex_first ? second : first;
+		mutex_ns[round] = is_mutex_first ? first : second;
+		is_exclusive &= first >= 0. && second >= 0.;
+	}
+	qsort(spinlock_ns, round_count, sizeof(f64), bench_locks_compare);
+	qsort(mutex_ns, round_count, sizeof(f64), bench_locks_compare);
+	printf("  %-14s %2u thread(s): as_spinlock %8.1f ns (%.1f-%.1f), as_mutex %8.1f ns (%.1f-%.1f) per section%s\n", name, thread_count,
+		spinlock_ns[round_count / 2], spinlock_ns[0], spinlock_ns[round_count - 1],
+		mutex_ns[round_count / 2], mutex_ns[0], mutex_ns[round_count - 1], is_exclusive ? "" : ", LOST INCREMENTS");
+	return is_exclusive;
+}
+
+i32 main(i32 argc, char** argv)
+{
+	const u32 thread_count = argc > 1 ? (u32)atoi(argv[1]) : 4;
+	section_count = argc > 2 ? atoi(argv[2]) : 20000;
+	const i32 section_work_count = argc > 3 ? atoi(argv[3]) : 2000;
+	const u32 round_count = argc > 4 ? (u32)atoi(argv[4]) : 7;
+	if (thread_count == 0 || thread_count > BENCH_LOCKS_MAX_THREADS || section_count <= 0 || section_work_count < 0
+		|| round_count == 0 || round_count > BENCH_LOCKS_MAX_ROUNDS)
+	{
+		printf("usage: bench_locks [threads 1-%d] [sections per thread] [work iterations per section] [rounds 1-%d]\n",
+			BENCH_LOCKS_MAX_THREADS, BENCH_LOCKS_MAX_ROUNDS);
+		return 1;
+	}
+
+	const i32 core_count = as_get_cpu_cores();
+	printf("bench_locks: %d sections per thread, %u rounds, median (min-max), %d core(s)\n", section_count, round_count, core_count);
+	if ((i32)thread_count > core_count)
+	{
+		printf("  more threads than cores, a preempted lock holder makes the contended rows measure the scheduler\n");
+	}
+	b8 is_exclusive = true;
+	work_count = 0; // lock and unlock alone
+	is_exclusive &= bench_locks_measure("no work", 1, round_count);
+	is_exclusive &= bench_locks_measure("no work", thread_count, round_count);
+	work_count = section_work_count;
+	is_exclusive &= bench_locks_measure("work", 1, round_count);
+	is_exclusive &= bench_locks_measure("work", thread_count, round_count);
+	return is_exclusive ? 0 : 1;
+}
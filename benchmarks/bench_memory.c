@@ -0,0 +1,74 @@
+// Abstract Shader Engine - Jed Fakhfekh - https://github.com/ougi-washi
+
+// AS_MALLOC_TAGGED/AS_FREE pairs from several threads, prints the cost of a pair and checks the tag stats add up
+// usage: bench_memory [threads] [pairs per thread] [block size]
+
+#include "as_memory.h"
+#include "as_threads.h"
+#include "as_utility.h"
+
+typedef struct bench_memory_job
+{
+	i64 pairs;
+	sz block_size;
+	f64 seconds;
+} bench_memory_job;
+
+static void* bench_memory_thread(void* arg)
+{
+	bench_memory_job* job = (bench_memory_job*)arg;
+	void* blocks[16] = { 0 };
+	const f64 start = get_monotonic_time();
+	for (i64 i = 0; i < job->pairs; i++)
+	{
+		// keep a few blocks alive so frees do not always hit the block that was just allocated
+		const u32 slot = (u32)(i & 15);
+		if (blocks[slot]) { AS_FREE(blocks[slot]); }
+		blocks[slot] = AS_MALLOC_TAGGED(job->block_size, "bench", AS_MEMORY_TAG_CONTENT);
+	}
+	for (u32 i = 0; i < 16; i++)
+	{
+		if (blocks[i]) { AS_FREE(blocks[i]); }
+	}
+	job->seconds = get_monotonic_time() - start;
+	return NULL;
+}
+
+i32 main(i32 argc, char** argv)
+{
+	const u32 thread_count = argc > 1 ? (u32)atoi(argv[1]) : 4;
+	const i64 pairs = argc > 2 ? atoll(argv[2]) : 1000000;
+	const sz block_size = argc > 3 ? (sz)atoll(argv[3]) : 64;
+	if (thread_count == 0 || thread_count > 64 || pairs <= 0 || block_size == 0)
+	{
+		printf("usage: bench_memory [threads 1-64] [pairs per thread] [block size]\n");
+		return 1;
+	}
+
+	const as_memory_tag_stats before = as_memory_get_tag_stats(AS_MEMORY_TAG_CONTENT);
+	as_thread threads[64];
+	bench_memory_job jobs[64];
+	for (u32 i = 0; i < thread_count; i++)
+	{
+		jobs[i] = (bench_memory_job){ .pairs = pairs, .block_size = block_size };
+		threads[i] = as_thread_create(bench_memory_thread, &jobs[i]);
+	}
+	f64 slowest = 0.;
+	for (u32 i = 0; i < thread_count; i++)
+	{
+		as_thread_join(threads[i]);
+		slowest = jobs[i].seconds > slowest ? jobs[i].seconds : slowest;
+	}
+	const as_memory_tag_stats after = as_memory_get_tag_stats(AS_MEMORY_TAG_CONTENT);
+
+	const i64 expected_count = (i64)thread_count * pairs;
+	const b8 is_consistent = after.current_bytes == before.current_bytes && after.live_count == before.live_count
+		&& after.total_count - before.total_count == expected_count;
+	printf("bench_memory: tracking=%d threads=%u pairs=%lld size=%zu\n", AS_MEMORY_TRACKING, thread_count, (long long)pairs, (size_t)block_size);
+	printf("  %.1f ns per malloc/free pair per thread, %.2f M pairs/s total\n",
+		slowest * 1e9 / (f64)pairs, (f64)expected_count / slowest * 1e-6);
+	printf("  stats %s: total +%lld (expected %lld), current %lld -> %lld, peak %lld\n", is_consistent ? "ok" : "MISMATCH",
+		(long long)(after.total_count - before.total_count), (long long)expected_count,
+		(long long)before.current_bytes, (long long)after.current_bytes, (long long)after.peak_bytes);
+	return is_consistent ? 0 : 1;
+}
@@ -0,0 +1,261 @@
+// Abstract Shader Engine - Jed Fakhfekh - https://github.com/ougi-washi
+
+// producers submit small commands to a render queue without a render, the queue thread runs them
+// prints commands per second and the submit to execute latency for 1, 2, 4, 8... producers, for the render queue and
+// for the queue it replaced (fixed 4 KB slots in a static array behind the queue lock, copied from the tree before it),
+// then how fast a sleeping queue thread wakes, how long waiting for the queue takes and what an idle queue costs in cpu time,
+// for the futex wakes of the render queue and for the sleep and poll loops of the old queue
+// usage: bench_render_queue [commands per producer] [max producers] [argument bytes]
+
+#include "core/as_render_queue.h"
+#include "as_threads.h"
+#include "as_utility.h"
+#include <string.h>
+#if !PLATFORM_WINDOWS
+#include <sys/resource.h>
+#endif
+
+#define BENCH_RQ_MAX_PRODUCERS 16
+#define BENCH_RQ_MAX_ARG_SIZE 1024
+#define BENCH_RQ_WAKE_SAMPLES 1000
+#define BENCH_RQ_WAKE_SPACING (2. / 1000.) // seconds between two wake samples, long enough for the queue thread to fall asleep
+#define BENCH_RQ_DRAIN_BURST 64
+#define BENCH_RQ_DRAIN_SAMPLES 200
+#define BENCH_RQ_IDLE_TIME 2. // seconds
+#define BENCH_OLD_RQ_SIZE 1024
+#define BENCH_OLD_RQ_MAX_ARG_SIZE 512
+#define BENCH_OLD_RQ_WAIT_TIME 1./100000.
+#define BENCH_OLD_RQ_REST_TIME 1./1000000.
+
+typedef struct bench_rq_arg
+{
+	f64 submit_time;
+	u8 payload[BENCH_RQ_MAX_ARG_SIZE - sizeof(f64)];
+} bench_rq_arg;
+
+// the render queue before the byte ring, same layout, lock and consumer loop
+typedef struct bench_old_rq_command
+{
+	void (*func_ptr)(void*);
+	void* arg[BENCH_OLD_RQ_MAX_ARG_SIZE];
+	u8 executed : 1;
+} bench_old_rq_command;
+AS_STATIC_ARRAY_DECLARE(bench_old_rq_commands, BENCH_OLD_RQ_SIZE, bench_old_rq_command);
+
+typedef struct bench_old_rq
+{
+	b8 is_running;
+	as_thread thread;
+	bench_old_rq_commands commands;
+	AS_DECLARE_TYPE;
+} bench_old_rq;
+
+static bench_old_rq old_queue = { 0 };
+
+static void* bench_old_rq_thread_run(void* arg)
+{
+	while (old_queue.is_running)
+	{
+		sz queue_size = 0;
+		AS_STATIC_ARRAY_VALID_SIZE(old_queue.commands, queue_size);
+		if (queue_size > 0)
+		{
+			AS_WAIT_AND_LOCK(&old_queue);
+			AS_STATIC_ARRAY_FOR_EACH_VALID(old_queue.commands, command_index,
+			{
+				bench_old_rq_command* command = AS_STATIC_ARRAY_GET(old_queue.commands, command_index);
+				if (!command->executed && command->func_ptr)
+				{
+					command->executed = true;
+					command->func_ptr(command->arg);
+				}
+				AS_STATIC_ARRAY_REMOVE(old_queue.commands, command_index);
+			});
+			AS_UNLOCK(&old_queue);
+		}
+		else
+		{
+			sleep_seconds(BENCH_OLD_RQ_REST_TIME);
+		}
+	}
+	return NULL;
+}
+
+static sz bench_old_rq_get_size()
+{
+	sz current_size = 0;
+	AS_STATIC_ARRAY_VALID_SIZE(old_queue.commands, current_size);
+	return current_size;
+}
+
+static void bench_old_rq_submit(void func_ptr(void*), void* arg, const u64 arg_size)
+{
+	AS_WAIT_AND_LOCK(&old_queue);
+	bench_old_rq_command command = { 0 };
+	command.func_ptr = func_ptr;
+	memcpy(command.arg, arg, arg_size);
+	sz command_index = -1;
+	AS_STATIC_ARRAY_ADD_DATA(old_queue.commands, &command, sizeof(command), command_index);
+	AS_UNLOCK(&old_queue);
+}
+
+static void bench_old_rq_wait()
+{
+	while (bench_old_rq_get_size() > 0) { sleep_seconds(BENCH_OLD_RQ_WAIT_TIME); }
+}
+
+// the old queue thread polls even when idle, it only runs while the old queue is measured
+static void bench_old_rq_start()
+{
+	old_queue.is_running = true;
+	old_queue.thread = as_thread_create(bench_old_rq_thread_run, NULL);
+}
+
+static void bench_old_rq_stop()
+{
+	bench_old_rq_wait();
+	old_queue.is_running = false;
+	as_thread_join(old_queue.thread);
+}
+
+static as_render_queue* render_queue = NULL;
+static b8 is_old_queue = false;
+static as_histogram latency_histogram = { 0 }; // microseconds
+static i64 command_count = 0;
+static sz arg_size = 32;
+static sz max_pending = 0; // producers hold back at half the old queue, a full queue would time its overflow instead of the queue
+
+static void bench_rq_submit(void func_ptr(void*), void* arg, const u64 arg_size)
+{
+	if (is_old_queue) { bench_old_rq_submit(func_ptr, arg, arg_size); }
+	else { as_rq_submit(render_queue, func_ptr, arg, arg_size); }
+}
+
+static sz bench_rq_get_size()
+{
+	return is_old_queue ? bench_old_rq_get_size() : as_rq_get_queue_size(render_queue);
+}
+
+static void bench_rq_wait()
+{
+	if (is_old_queue) { bench_old_rq_wait(); }
+	else { as_rq_wait_queue(render_queue); }
+}
+
+static void bench_rq_command(void* arg)
+{
+	f64 submit_time = 0.;
+	memcpy(&submit_time, arg, sizeof(f64));
+	as_histogram_record(&latency_histogram, (u64)((get_monotonic_time() - submit_time) * 1e6));
+}
+
+static void* bench_rq_producer(void* arg)
+{
+	bench_rq_arg command_arg = { 0 };
+	for (i64 i = 0; i < command_count; i++)
+	{
+		while (bench_rq_get_size() >= max_pending) { as_thread_yield(); }
+		command_arg.submit_time = get_monotonic_time();
+		bench_rq_submit(bench_rq_command, &command_arg, arg_size);
+	}
+	return NULL;
+}
+
+static void bench_rq_throughput(const b8 is_old, const u32 producer_count)
+{
+	is_old_queue = is_old;
+	if (is_old) { bench_old_rq_start(); }
+	as_histogram_reset(&latency_histogram);
+	as_thread threads[BENCH_RQ_MAX_PRODUCERS];
+	const f64 start = get_monotonic_time();
+	for (u32 i = 0; i < producer_count; i++) { threads[i] = as_thread_create(bench_rq_producer, NULL); }
+	for (u32 i = 0; i < producer_count; i++) { as_thread_join(threads[i]); }
+	bench_rq_wait();
+	const f64 elapsed = get_monotonic_time() - start;
+
+	const as_histogram_summary latency = as_histogram_summarize(&latency_histogram);
+	printf("  %-12s %2u producer(s): %6.2f M commands/s, latency p50 %llu us, p99 %llu us, max %llu us, ran %lld/%lld\n",
+		is_old ? "fixed slots" : "render queue", producer_count, (f64)command_count * producer_count / elapsed * 1e-6, (unsigned long long)latency.p50,
+		(unsigned long long)latency.p99, (unsigned long long)latency.max, (long long)latency.count, (long long)command_count * producer_count);
+	if (is_old) { bench_old_rq_stop(); }
+}
+
+static void bench_rq_empty_command(void* arg) {}
+
+static f64 bench_rq_get_cpu_time()
+{
+#if PLATFORM_WINDOWS
+	FILETIME creation_time, exit_time, kernel_time, user_time;
+	GetProcessTimes(GetCurrentProcess(), &creation_time, &exit_time, &kernel_time, &user_time);
+	const u64 kernel = ((u64)kernel_time.dwHighDateTime << 32) | kernel_time.dwLowDateTime;
+	const u64 user = ((u64)user_time.dwHighDateTime << 32) | user_time.dwLowDateTime;
+	return (f64)(kernel + user) * 1e-7;
+#else
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return (f64)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) + (f64)(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+}
+
+static void bench_rq_wake(const b8 is_old)
+{
+	// one command at a time with the queue idle in between, so each sample pays for waking the queue thread
+	is_old_queue = is_old;
+	if (is_old) { bench_old_rq_start(); }
+	const char* name = is_old ? "polling" : "futex";
+	as_histogram_reset(&latency_histogram);
+	bench_rq_arg command_arg = { 0 };
+	for (u32 i = 0; i < BENCH_RQ_WAKE_SAMPLES; i++)
+	{
+		sleep_seconds(BENCH_RQ_WAKE_SPACING);
+		command_arg.submit_time = get_monotonic_time();
+		bench_rq_submit(bench_rq_command, &command_arg, sizeof(f64));
+	}
+	bench_rq_wait();
+	const as_histogram_summary latency = as_histogram_summarize(&latency_histogram);
+	printf("  %-8s wake from idle: p50 %llu us, p99 %llu us, max %llu us over %lld commands\n", name, (unsigned long long)latency.p50,
+		(unsigned long long)latency.p99, (unsigned long long)latency.max, (long long)latency.count);
+
+	f64 wait_time = 0.;
+	for (u32 i = 0; i < BENCH_RQ_DRAIN_SAMPLES; i++)
+	{
+		for (u32 j = 0; j < BENCH_RQ_DRAIN_BURST; j++) { bench_rq_submit(bench_rq_empty_command, NULL, 0); }
+		const f64 start = get_monotonic_time();
+		bench_rq_wait();
+		wait_time += get_monotonic_time() - start;
+		sleep_seconds(BENCH_RQ_WAKE_SPACING);
+	}
+	printf("  %-8s wait for the queue after %d commands: %.1f us average\n", name, BENCH_RQ_DRAIN_BURST, wait_time * 1e6 / BENCH_RQ_DRAIN_SAMPLES);
+
+	const f64 cpu_start = bench_rq_get_cpu_time();
+	sleep_seconds(BENCH_RQ_IDLE_TIME);
+	printf("  %-8s idle queue: %.1f ms of cpu time over %.0f s\n", name, (bench_rq_get_cpu_time() - cpu_start) * 1e3, BENCH_RQ_IDLE_TIME);
+	if (is_old) { bench_old_rq_stop(); }
+}
+
+i32 main(i32 argc, char** argv)
+{
+	command_count = argc > 1 ? atoll(argv[1]) : 200000;
+	const u32 max_producers = argc > 2 ? (u32)atoi(argv[2]) : 8;
+	arg_size = argc > 3 ? (sz)atoll(argv[3]) : 32;
+	if (command_count <= 0 || max_producers == 0 || max_producers > BENCH_RQ_MAX_PRODUCERS || arg_size < sizeof(f64) || arg_size > BENCH_RQ_MAX_ARG_SIZE)
+	{
+		printf("usage: bench_render_queue [commands per producer] [max producers 1-%d] [argument bytes %zu-%d]\n",
+			BENCH_RQ_MAX_PRODUCERS, sizeof(f64), BENCH_RQ_MAX_ARG_SIZE);
+		return 1;
+	}
+
+	max_pending = BENCH_OLD_RQ_SIZE / 2; // the same for both queues, the byte ring would hold more, which only adds latency
+	render_queue = as_rq_create(NULL);
+	printf("bench_render_queue: %lld commands per producer, %zu argument bytes, at most %zu pending\n",
+		(long long)command_count, (size_t)arg_size, (size_t)max_pending);
+	for (u32 producer_count = 1; producer_count <= max_producers; producer_count *= 2)
+	{
+		bench_rq_throughput(true, producer_count);
+		bench_rq_throughput(false, producer_count);
+	}
+	bench_rq_wake(true);
+	bench_rq_wake(false);
+	as_rq_destroy(render_queue);
+	return 0;
+}
@@ -0,0 +1,49 @@
+// Abstract Shader Engine - Jed Fakhfekh - https://github.com/ougi-washi
+
+// replays a render queue capture on a headless render made for it, without the engine, and prints how many commands
+// per second the queue went through, what the capture made again and how many frames were read back.
+// captures come from the capture_render_queue console command, or as_rq_capture_start, of any run.
+// needs a vulkan device (lavapipe works), run it from the binaries directory like the engine for the resources paths
+// usage: bench_replay <capture> [width] [height] [recorded, 1 to keep the captured gaps]
+
+#include "core/as_render_queue.h"
+
+static volatile i64 readback_count = 0; // written on the render thread
+
+static void bench_replay_on_readback(void* user_data, const u8* pixels, const u32 width, const u32 height, const u64 frame_index)
+{
+	AS_ATOMIC_ADD_I64(&readback_count, 1);
+}
+
+i32 main(i32 argc, char** argv)
+{
+	const char* path = argc > 1 ? argv[1] : NULL;
+	const u32 width = argc > 2 ? (u32)atoi(argv[2]) : 1280;
+	const u32 height = argc > 3 ? (u32)atoi(argv[3]) : 720;
+	const as_rq_replay_timing timing = argc > 4 && atoi(argv[4]) ? AS_RQ_REPLAY_TIMING_RECORDED : AS_RQ_REPLAY_TIMING_NONE;
+	if (!path || width == 0 || height == 0)
+	{
+		printf("usage: bench_replay <capture> [width] [height] [recorded, 1 to keep the captured gaps]\n");
+		return 1;
+	}
+
+	as_render* render = as_render_create_headless(width, height, bench_replay_on_readback, NULL);
+	if (!render || AS_IS_INVALID(render))
+	{
+		printf("bench_replay: could not create the headless render\n");
+		return 1;
+	}
+	as_render_queue* render_queue = as_rq_create(render);
+	const as_rq_replay_result result = as_rq_replay(render_queue, NULL, path, timing);
+
+	printf("bench_replay: %s, %ux%u, %s timing\n", path, width, height, timing == AS_RQ_REPLAY_TIMING_RECORDED ? "recorded" : "no");
+	printf("  %zu commands in %.3f s, %.0f commands/s\n", result.command_count, result.duration,
+		result.duration > 0. ? (f64)result.command_count / result.duration : 0.);
+	printf("  %zu textures, shaders, shapes and objects made again, %zu commands skipped\n", result.binding_count, result.skipped_count);
+	printf("  %lld frames read back\n", (long long)AS_ATOMIC_LOAD_I64(&readback_count));
+	as_rq_log_stats(render_queue);
+
+	as_rq_destroy(render_queue);
+	as_render_destroy(render);
+	return result.command_count > 0 ? 0 : 1;
+}
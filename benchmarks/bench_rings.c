@@ -0,0 +1,282 @@
+// Abstract Shader Engine - Jed Fakhfekh - https://github.com/ougi-washi
+
+// times the rings against the code they replaced, both copied from the tree before the rings:
+// - input history: as_input_add/as_input_is_pressed on the AS_RING against AS_ARRAY_INSERT_AT(0) + AS_ARRAY_REMOVE_AT(last)
+// - render commands: an AS_MPSC_RING of commands against the AS_STATIC_ARRAY queue guarded by AS_WAIT_AND_LOCK,
+//   same command layout (a 4 KB argument), same consumer loops, every producer's order is checked
+// usage: bench_rings [input events] [commands per producer] [producers]
+
+#include "as_array.h"
+#include "as_threads.h"
+#include "as_utility.h"
+#include "core/as_input.h"
+#include "defines/as_keys.h"
+#include <string.h>
+
+#define BENCH_RING_MAX_PRODUCERS 16
+
+// input history before the ring
+
+AS_ARRAY_DECLARE(bench_old_input_keys_128, 128, as_input_key);
+typedef struct bench_old_input_buffer
+{
+	bench_old_input_keys_128 keys;
+	void (*on_add)(const as_input_key*);
+} bench_old_input_buffer;
+
+static void bench_old_input_add(bench_old_input_buffer* buffer, const i32 key, const i32 action)
+{
+	as_input_key new_key = { 0 };
+	new_key.key = key;
+	new_key.action = action;
+
+	AS_ARRAY_INSERT_AT(buffer->keys, 0, new_key);
+	if (AS_ARRAY_GET_SIZE(buffer->keys) > AS_MAX_INPUT_BUFFER_SIZE)
+	{
+		AS_ARRAY_REMOVE_AT(buffer->keys, AS_ARRAY_GET_LAST_INDEX(buffer->keys));
+	}
+	if (buffer->on_add)
+	{
+		buffer->on_add(AS_ARRAY_GET(buffer->keys, 0));
+	}
+}
+
+static bool bench_old_input_is_pressed(bench_old_input_buffer* buffer, const i32 key)
+{
+	for (sz i = 0; i < buffer->keys.size; i++)
+	{
+		as_input_key* current_key = AS_ARRAY_GET(buffer->keys, i);
+		if (current_key && current_key->key == key)
+		{
+			return (current_key->action == AS_PRESS || current_key->action == AS_REPEAT);
+		}
+	}
+	return false;
+}
+
+typedef struct bench_input_times
+{
+	f64 add_ns;
+	f64 lookup_ns;
+	i64 pressed_count; // both versions have to agree
+} bench_input_times;
+
+// adds the events, then looks up as many keys in the full history, the history is read newest first in both
+static bench_input_times bench_input_run(const b8 is_old, const i64 event_count)
+{
+	static bench_old_input_buffer old_buffer = { 0 };
+	as_input_buffer* buffer = as_input_create();
+	old_buffer.keys.size = 0;
+	bench_input_times times = { 0 };
+
+	const f64 start = get_monotonic_time();
+	for (i64 i = 0; i < event_count; i++)
+	{
+		const i32 key = (i32)(i % 48);
+		const i32 action = (i & 1) ? AS_PRESS : AS_RELEASE;
+		if (is_old) { bench_old_input_add(&old_buffer, key, action); }
+		else { as_input_add(buffer, key, action); }
+	}
+	const f64 added = get_monotonic_time();
+	for (i64 i = 0; i < event_count; i++)
+	{
+		const i32 key = (i32)(i % 64); // some keys are not in the history and scan all of it
+		times.pressed_count += is_old ? bench_old_input_is_pressed(&old_buffer, key) : as_input_is_pressed(buffer, key);
+	}
+	const f64 looked_up = get_monotonic_time();
+
+	times.add_ns = (added - start) * 1e9 / (f64)event_count;
+	times.lookup_ns = (looked_up - added) * 1e9 / (f64)event_count;
+	as_input_destory(buffer);
+	return times;
+}
+
+// render commands, the layout of as_render_command at the time
+
+#define BENCH_RQ_SIZE 1024
+#define BENCH_RQ_MAX_ARG_SIZE 512
+#define BENCH_RQ_WAIT_TIME 1./100000.
+#define BENCH_RQ_REST_TIME 1./1000000.
+
+typedef struct bench_old_render_command
+{
+	void (*func_ptr)(void*);
+	void* arg[BENCH_RQ_MAX_ARG_SIZE];
+	u8 executed : 1;
+} bench_old_render_command;
+AS_STATIC_ARRAY_DECLARE(bench_old_render_commands, BENCH_RQ_SIZE, bench_old_render_command);
+
+typedef struct bench_old_render_queue
+{
+	bench_old_render_commands commands;
+	AS_DECLARE_TYPE;
+} bench_old_render_queue;
+
+typedef struct bench_render_command
+{
+	void (*func_ptr)(void*);
+	void* arg[BENCH_RQ_MAX_ARG_SIZE];
+} bench_render_command;
+AS_MPSC_RING_DECLARE(bench_render_commands, BENCH_RQ_SIZE, bench_render_command);
+
+typedef struct bench_command_arg
+{
+	i64 producer;
+	i64 value;
+} bench_command_arg;
+
+static bench_old_render_queue old_queue = { 0 };
+static bench_render_commands ring_queue = { 0 };
+static b8 is_old_queue = false;
+static i64 commands_per_producer = 0;
+static i64 expected_values[BENCH_RING_MAX_PRODUCERS] = { 0 };
+static i64 executed_count = 0;
+static b8 is_ordered = true;
+
+// runs on the consumer only
+static void bench_command_func(void* arg)
+{
+	const bench_command_arg* command_arg = (const bench_command_arg*)arg;
+	is_ordered &= command_arg->value == expected_values[command_arg->producer]++;
+	executed_count++;
+}
+
+static void* bench_command_producer(void* arg)
+{
+	const i64 producer = (i64)(uintptr_t)arg;
+	for (i64 i = 0; i < commands_per_producer; i++)
+	{
+		const bench_command_arg command_arg = { producer, i };
+		if (is_old_queue)
+		{
+			// the old as_rq_submit, which overflowed when full, here it waits instead so no command is lost
+			bench_old_render_command command = { 0 };
+			command.func_ptr = bench_command_func;
+			memcpy(command.arg, &command_arg, sizeof(command_arg));
+			for (;;)
+			{
+				AS_WAIT_AND_LOCK(&old_queue);
+				if (AS_STATIC_ARRAY_COUNT(old_queue.commands) < bench_old_render_commands_max) { break; }
+				AS_UNLOCK(&old_queue);
+				sleep_seconds(BENCH_RQ_WAIT_TIME);
+			}
+			sz command_index = -1;
+			AS_STATIC_ARRAY_ADD_DATA(old_queue.commands, &command, sizeof(command), command_index);
+			AS_UNLOCK(&old_queue);
+		}
+		else
+		{
+			// as_rq_submit once it moved to the ring
+			bench_render_command command = { 0 };
+			command.func_ptr = bench_command_func;
+			memcpy(command.arg, &command_arg, sizeof(command_arg));
+			bool pushed = false;
+			AS_MPSC_RING_PUSH(ring_queue, command, pushed);
+			while (!pushed)
+			{
+				sleep_seconds(BENCH_RQ_WAIT_TIME);
+				AS_MPSC_RING_PUSH(ring_queue, command, pushed);
+			}
+		}
+	}
+	return NULL;
+}
+
+// the consumer loop of as_render_queue_thread_run for each version
+static void bench_command_consume(const i64 total)
+{
+	while (executed_count < total)
+	{
+		if (is_old_queue)
+		{
+			sz queue_size = 0;
+			AS_STATIC_ARRAY_VALID_SIZE(old_queue.commands, queue_size);
+			if (queue_size > 0)
+			{
+				AS_WAIT_AND_LOCK(&old_queue);
+				AS_STATIC_ARRAY_FOR_EACH_VALID(old_queue.commands, command_index,
+				{
+					bench_old_render_command* command = AS_STATIC_ARRAY_GET(old_queue.commands, command_index);
+					if (!command->executed && command->func_ptr)
+					{
+						command->executed = true;
+						command->func_ptr(command->arg);
+					}
+					AS_STATIC_ARRAY_REMOVE(old_queue.commands, command_index);
+				});
+				AS_UNLOCK(&old_queue);
+			}
+			else
+			{
+				sleep_seconds(BENCH_RQ_REST_TIME);
+			}
+		}
+		else if (!AS_MPSC_RING_IS_EMPTY(ring_queue))
+		{
+			bench_render_command* command = NULL;
+			for (sz processed = 0; processed < BENCH_RQ_SIZE && (command = AS_MPSC_RING_FRONT(ring_queue)); processed++)
+			{
+				if (command->func_ptr)
+				{
+					command->func_ptr(command->arg);
+				}
+				AS_MPSC_RING_POP_FRONT(ring_queue);
+			}
+		}
+		else
+		{
+			sleep_seconds(BENCH_RQ_REST_TIME);
+		}
+	}
+}
+
+static b8 bench_command_run(const b8 is_old, const u32 producer_count)
+{
+	is_old_queue = is_old;
+	memset(expected_values, 0, sizeof(expected_values));
+	executed_count = 0;
+	is_ordered = true;
+	as_thread threads[BENCH_RING_MAX_PRODUCERS];
+	const f64 start = get_monotonic_time();
+	for (u32 i = 0; i < producer_count; i++)
+	{
+		threads[i] = as_thread_create(bench_command_producer, (void*)(uintptr_t)i);
+	}
+	const i64 total = commands_per_producer * (i64)producer_count;
+	bench_command_consume(total);
+	const f64 elapsed = get_monotonic_time() - start;
+	for (u32 i = 0; i < producer_count; i++) { as_thread_join(threads[i]); }
+
+	printf("  %-22s %2u producer(s): %8.1f ms, %7.1f ns per command, order %s\n", is_old ? "static array + lock" : "mpsc ring",
+		producer_count, elapsed * 1e3, elapsed * 1e9 / (f64)total, is_ordered ? "ok" : "BROKEN");
+	return is_ordered;
+}
+
+i32 main(i32 argc, char** argv)
+{
+	const i64 event_count = argc > 1 ? atoll(argv[1]) : 4000000;
+	commands_per_producer = argc > 2 ? atoll(argv[2]) : 200000;
+	const u32 producer_count = argc > 3 ? (u32)atoi(argv[3]) : 4;
+	if (event_count <= 0 || commands_per_producer <= 0 || producer_count == 0 || producer_count > BENCH_RING_MAX_PRODUCERS)
+	{
+		printf("usage: bench_rings [input events] [commands per producer] [producers 1-%d]\n", BENCH_RING_MAX_PRODUCERS);
+		return 1;
+	}
+
+	printf("bench_rings: input history of %d events, %lld events\n", AS_MAX_INPUT_BUFFER_SIZE, (long long)event_count);
+	bench_input_run(false, event_count / 10); // warm-up
+	const bench_input_times old_times = bench_input_run(true, event_count);
+	const bench_input_times ring_times = bench_input_run(false, event_count);
+	printf("  %-22s add %6.1f ns, is_pressed %6.1f ns\n", "insert_at(0) array", old_times.add_ns, old_times.lookup_ns);
+	printf("  %-22s add %6.1f ns, is_pressed %6.1f ns, lookups %s\n", "ring", ring_times.add_ns, ring_times.lookup_ns,
+		old_times.pressed_count == ring_times.pressed_count ? "agree" : "DISAGREE");
+
+	printf("bench_rings: render commands of %zu bytes, capacity %d, %lld per producer\n",
+		sizeof(bench_render_command), BENCH_RQ_SIZE, (long long)commands_per_producer);
+	b8 is_ok = old_times.pressed_count == ring_times.pressed_count;
+	is_ok &= bench_command_run(true, 1);
+	is_ok &= bench_command_run(false, 1);
+	is_ok &= bench_command_run(true, producer_count);
+	is_ok &= bench_command_run(false, producer_count);
+	return is_ok ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+// Abstract Shader Engine - Jed Fakhfekh - https://github.com/ougi-washi
+
+// a game thread ticks at a fixed rate and wakes a render thread after each tick, like as_engine_draw wakes the queue thread,
+// while load threads keep every core busy. prints how late the game thread wakes from its tick sleep and how long the
+// render thread takes to wake once signaled, first with plain threads, then adding names, core pinning and real time policies.
+// names change nothing for the scheduler, they are measured so the row can be compared with the default one.
+// usage: bench_threads [ticks] [load threads, 0 for one per core] [ticks per second]
+
+#include "as_threads.h"
+#include "as_utility.h"
+
+#define BENCH_THREADS_MAX_LOAD 64
+#define BENCH_THREADS_RENDER_PRIORITY 2
+#define BENCH_THREADS_GAME_PRIORITY 1
+
+typedef enum bench_threads_setup
+{
+	BENCH_THREADS_SETUP_DEFAULT		= 0x00,
+	BENCH_THREADS_SETUP_NAMED		= 0x01,
+	BENCH_THREADS_SETUP_PINNED		= 0x02, // named too
+	BENCH_THREADS_SETUP_REAL_TIME	= 0x03, // named and pinned too
+	BENCH_THREADS_SETUP_COUNT		= 0x04
+} bench_threads_setup;
+
+static const char* bench_threads_setup_names[BENCH_THREADS_SETUP_COUNT] = { "default", "named", "pinned", "real time" };
+
+static as_histogram game_histogram = { 0 }; // microseconds past the tick
+static as_histogram render_histogram = { 0 }; // microseconds from the signal to the render thread running
+static u32 render_epoch = 0;
+static volatile f64 signal_time = 0.;
+static volatile b8 is_running = false;
+static volatile b8 is_loading = false;
+static volatile u64 bench_threads_sink = 0;
+static i64 tick_count = 0;
+static f64 tick_period = 0.;
+
+static void* bench_threads_load(void* arg)
+{
+	u64 work = 0;
+	while (is_loading)
+	{
+		for (u32 i = 0; i < 1000; i++) { work += work ^ i; }
+	}
+	bench_threads_sink = work;
+	return NULL;
+}
+
+static void* bench_threads_render(void* arg)
+{
+	u32 epoch = AS_ATOMIC_LOAD_ACQUIRE_I32(&render_epoch);
+	while (is_running)
+	{
+		as_wait_on_address(&render_epoch, epoch);
+		const u32 new_epoch = AS_ATOMIC_LOAD_ACQUIRE_I32(&render_epoch);
+		if (new_epoch == epoch) { continue; } // spurious
+		epoch = new_epoch;
+		if (is_running)
+		{
+			as_histogram_record(&render_histogram, (u64)((get_monotonic_time() - signal_time) * 1e6));
+		}
+	}
+	return NULL;
+}
+
+static void* bench_threads_game(void* arg)
+{
+	const f64 start = get_monotonic_time();
+	for (i64 i = 1; i <= tick_count; i++)
+	{
+		const f64 tick_time = start + (f64)i * tick_period;
+		const f64 now = get_monotonic_time();
+		if (tick_time > now) { sleep_seconds(tick_time - now); }
+		const f64 woken_time = get_monotonic_time();
+		as_histogram_record(&game_histogram, woken_time > tick_time ? (u64)((woken_time - tick_time) * 1e6) : 0);
+
+		signal_time = get_monotonic_time();
+		AS_ATOMIC_ADD_I32(&render_epoch, 1);
+		as_wake_address_one(&render_epoch);
+	}
+	return NULL;
+}
+
+// false when the real time policy was refused
+static b8 bench_threads_apply(as_thread thread, const bench_threads_setup setup, const char* name, const i32 core, const i32 priority)
+{
+	if (setup >= BENCH_THREADS_SETUP_NAMED) { as_thread_set_name(thread, name); }
+	if (setup >= BENCH_THREADS_SETUP_PINNED) { as_thread_set_affinity(thread, 1ull << core); }
+	if (setup >= BENCH_THREADS_SETUP_REAL_TIME) { return as_thread_set_policy(thread, AS_THREAD_POLICY_FIFO, priority); }
+	return true;
+}
+
+static void bench_threads_run(const bench_threads_setup setup, const u32 load_count)
+{
+	as_histogram_reset(&game_histogram);
+	as_histogram_reset(&render_histogram);
+	is_loading = true;
+	as_thread load_threads[BENCH_THREADS_MAX_LOAD];
+	for (u32 i = 0; i < load_count; i++) { load_threads[i] = as_thread_create(bench_threads_load, NULL); }
+
+	// the render thread first so it is waiting before the first tick
+	is_running = true;
+	const i32 core_count = as_get_cpu_cores();
+	as_thread render_thread = as_thread_create(bench_threads_render, NULL);
+	b8 is_applied = bench_threads_apply(render_thread, setup, "as_render", 1 % core_count, BENCH_THREADS_RENDER_PRIORITY);
+	sleep_seconds(tick_period);
+	as_thread game_thread = as_thread_create(bench_threads_game, NULL);
+	is_applied &= bench_threads_apply(game_thread, setup, "as_game", 0, BENCH_THREADS_GAME_PRIORITY);
+	as_thread_join(game_thread);
+
+	is_running = false;
+	AS_ATOMIC_ADD_I32(&render_epoch, 1);
+	as_wake_address_one(&render_epoch);
+	as_thread_join(render_thread);
+	is_loading = false;
+	for (u32 i = 0; i < load_count; i++) { as_thread_join(load_threads[i]); }
+
+	const as_histogram_summary game = as_histogram_summarize(&game_histogram);
+	const as_histogram_summary render = as_histogram_summarize(&render_histogram);
+	printf("  %-10s game tick late p50 %5llu p99 %5llu max %6llu us, render wake p50 %5llu p99 %5llu max %6llu us%s\n",
+		bench_threads_setup_names[setup], (unsigned long long)game.p50, (unsigned long long)game.p99, (unsigned long long)game.max,
+		(unsigned long long)render.p50, (unsigned long long)render.p99, (unsigned long long)render.max,
+		is_applied ? "" : " (policy refused, same as pinned)");
+}
+
+i32 main(i32 argc, char** argv)
+{
+	tick_count = argc > 1 ? atoll(argv[1]) : 2000;
+	const i32 core_count = as_get_cpu_cores();
+	u32 load_count = argc > 2 ? (u32)atoi(argv[2]) : 0;
+	load_count = load_count == 0 ? (u32)core_count : load_count;
+	const f64 tick_rate = argc > 3 ? atof(argv[3]) : 240.;
+	if (tick_count <= 0 || load_count > BENCH_THREADS_MAX_LOAD || tick_rate <= 0.)
+	{
+		printf("usage: bench_threads [ticks] [load threads 0-%d, 0 for one per core] [ticks per second]\n", BENCH_THREADS_MAX_LOAD);
+		return 1;
+	}
+	tick_period = 1. / tick_rate;
+
+	printf("bench_threads: %lld ticks at %.0f Hz, %u load thread(s), %d core(s)\n", (long long)tick_count, tick_rate, load_count, core_count);
+	for (i32 setup = 0; setup < BENCH_THREADS_SETUP_COUNT; setup++)
+	{
+		bench_threads_run((bench_threads_setup)setup, load_count);
+	}
+	return 0;
+}
@@ -89,62 +89,286 @@ AS_ARRAY_DECLARE(char1024, 1024, char);
 
 // This array does not change from order to not lose track of the ptr. 
 // Effective for big iterations that would take a while as another thread edits the array
-// This tends to be slower than normal array because the data gets de-fragmented and cache misses may happen often when parsing.
-// However, this is not meant for performance.
+// Free slots are chained in a free list and occupancy is a bitmap with a live count, so add, remove and size are O(1).
+// Slots past high_water were never used, a zeroed array is a valid empty array.
+#define AS_STATIC_ARRAY_WORDS(_capacity) (((_capacity) + 63) / 64)
 #define AS_STATIC_ARRAY_DECLARE(_name, _capacity, _type)     \
     typedef struct {                                        \
         _type data[_capacity];                              \
-        b8 valid[_capacity];                                \
+        u64 valid[AS_STATIC_ARRAY_WORDS(_capacity)];        \
+        u32 next_free[_capacity];                           \
+        u32 free_head; /* index + 1, 0 when empty */        \
+        u32 high_water;                                     \
+        u32 count;                                          \
     } _name;                                                \
 static const sz _name##_max = _capacity;
 
 #define AS_STATIC_ARRAY_SIZE(_array) AS_ARRAY_SIZE((_array).data)
+#define AS_STATIC_ARRAY_COUNT(_array) ((sz)(_array).count)
+#define AS_STATIC_ARRAY_CLEAR(_array)                                       \
+    do { memset((_array).valid, 0, sizeof((_array).valid));                 \
+        (_array).free_head = 0;                                             \
+        (_array).high_water = 0;                                            \
+        (_array).count = 0; } while(0)
 
 #define AS_STATIC_ARRAY_GET(_array, _index)                                          \
     (((_index) >= 0 && (_index) < AS_STATIC_ARRAY_SIZE(_array)) ? &((_array).data[_index]) : NULL)
 
 #define AS_STATIC_ARRAY_IS_VALID(_array, _index)                                          \
-    (((_index) >= 0 && (_index) < AS_STATIC_ARRAY_SIZE(_array)) ? ((_array).valid[_index]) : false)
+    (((_index) >= 0 && (_index) < AS_STATIC_ARRAY_SIZE(_array)) ? (((_array).valid[(_index) / 64] >> ((_index) % 64)) & 1) != 0 : false)
 
 #define AS_STATIC_ARRAY_VALID_SIZE(_array, _output_size)                    \
-    _output_size = 0;                                                       \
-    for (sz _index = 0 ; _index < AS_STATIC_ARRAY_SIZE(_array) ; _index++)  \
-    {if (AS_STATIC_ARRAY_IS_VALID(_array, _index)) { _output_size++; }}
-
-#define AS_STATIC_ARRAY_ADD(_array, _out_index)                     \
-    do {                                                            \
-        _out_index = -1;                                            \
-        for (sz _i = 0; _i < AS_ARRAY_SIZE((_array).data); ++_i) {  \
-            if ((_array).valid[_i] == false) {                      \
-                (_array).valid[_i] = true;                          \
-                _out_index = _i;                                    \
-                break;                                              \
-            }                                                       \
-        }                                                           \
+    _output_size = AS_STATIC_ARRAY_COUNT(_array);
+
+#define AS_STATIC_ARRAY_ADD(_array, _out_index)                             \
+    do {                                                                    \
+        sz _slot = (sz)-1;                                                  \
+        if ((_array).free_head > 0) {                                       \
+            _slot = (_array).free_head - 1;                                 \
+            (_array).free_head = (_array).next_free[_slot]; }               \
+        else if ((_array).high_water < AS_STATIC_ARRAY_SIZE(_array)) {      \
+            _slot = (_array).high_water++; }                                \
+        if (_slot != (sz)-1) {                                              \
+            (_array).valid[_slot / 64] |= 1ull << (_slot % 64);             \
+            (_array).count++; }                                             \
+        _out_index = _slot;                                                 \
     } while (0)
 
-#define AS_STATIC_ARRAY_FIND_PTR(_array, _ptr, _out_index)          \
-    do { _out_index = -1;                                           \
-        for (sz _i = 0; _i < AS_ARRAY_SIZE((_array).data); ++_i) {  \
-                if (&(_array).data[_i] == _ptr)                     \
-                {   _out_index = _i;                                \
-                    break; }                                        \
-            }                                                       \
-        } while(0)
+#define AS_STATIC_ARRAY_FIND_PTR(_array, _ptr, _out_index)                                          \
+    do { _out_index = -1;                                                                           \
+        if ((_ptr) >= (_array).data && (_ptr) < (_array).data + AS_STATIC_ARRAY_SIZE(_array)) {     \
+            _out_index = (sz)((_ptr) - (_array).data); }                                            \
+    } while(0)
 
 #define AS_STATIC_ARRAY_ADD_DATA(_array, _data, _size, _out_index)  \
     do{ AS_STATIC_ARRAY_ADD(_array, _out_index);                    \
     void* _added_data = AS_STATIC_ARRAY_GET(_array, _out_index);    \
-    memcpy(_added_data, _data, _size);} while(0)
+    if (_added_data) { memcpy(_added_data, _data, _size); }         \
+    else { AS_LOG(LV_ERROR, "Array overflow"); } } while(0)
 
+// an array that becomes empty restarts from slot 0 so the next batch keeps its insertion order
 #define AS_STATIC_ARRAY_REMOVE(_array, _index)                                  \
     do {                                                                        \
         if ((_index) >= 0 && (_index) < AS_ARRAY_SIZE((_array).data)) {         \
-            (_array).valid[_index] = false; }                                   \
+            if (AS_STATIC_ARRAY_IS_VALID(_array, _index)) {                     \
+                (_array).valid[(_index) / 64] &= ~(1ull << ((_index) % 64));    \
+                (_array).next_free[_index] = (_array).free_head;                \
+                (_array).free_head = (u32)(_index) + 1;                         \
+                if (--(_array).count == 0) {                                    \
+                    (_array).free_head = 0;                                     \
+                    (_array).high_water = 0; } } }                              \
 	    else { AS_LOG(LV_ERROR, "Array index out of bounds"); }                 \
     } while(0)
 
 #define AS_STATIC_ARRAY_REMOVE_PTR(_array, _ptr)                                \
     do { sz _out_index = -1;                                                    \
          AS_STATIC_ARRAY_FIND_PTR(_array, _ptr, _out_index);                    \
-         AS_STATIC_ARRAY_REMOVE(_array, _out_index); } while(0)
\ No newline at end of file
+         AS_STATIC_ARRAY_REMOVE(_array, _out_index); } while(0)
+
+// visits valid slots only, skipping empty 64 slot words, removing the current slot inside _exec is allowed
+#define AS_STATIC_ARRAY_FOR_EACH_VALID(_array, _index, _exec)                                   \
+for (sz _word = 0; _word < AS_STATIC_ARRAY_WORDS((_array).high_water); ++_word) {               \
+    u64 _bits = (_array).valid[_word];                                                          \
+    while (_bits) {                                                                             \
+        const sz _index = _word * 64 + as_ctz64(_bits);                                         \
+        _bits &= _bits - 1;                                                                     \
+        { _exec }                                                                               \
+    }                                                                                           \
+}
+
+// Heap backed array that grows geometrically, use it when the capacity is not known at compile time.
+// Pointers to elements are only stable until the next reserve, store indices or use a slab if needed.
+#define AS_VECTOR_DECLARE(_name, _type)                     \
+    typedef struct {                                        \
+        _type* data;                                        \
+        sz size;                                            \
+        sz capacity;                                        \
+    } _name;
+
+#define AS_VECTOR_MIN_CAPACITY 8
+
+extern b8 as_vector_reserve_fn(void** data, sz* capacity, const sz element_size, const sz min_capacity);
+extern void as_vector_shrink_fn(void** data, sz* capacity, const sz element_size, const sz size);
+extern void as_vector_free_fn(void** data, sz* size, sz* capacity);
+extern b8 as_vector_out_of_bounds_fn(const sz index, const sz size, const char* file, const u32 line);
+
+#define AS_VECTOR_RESERVE(_vector, _capacity) \
+    as_vector_reserve_fn((void**)&(_vector).data, &(_vector).capacity, sizeof(*(_vector).data), (_capacity))
+
+#define AS_VECTOR_SHRINK(_vector) \
+    as_vector_shrink_fn((void**)&(_vector).data, &(_vector).capacity, sizeof(*(_vector).data), (_vector).size)
+
+#define AS_VECTOR_FREE(_vector) \
+    as_vector_free_fn((void**)&(_vector).data, &(_vector).size, &(_vector).capacity)
+
+// returns a zeroed element at the back of the vector, NULL if the allocation failed
+#define AS_VECTOR_INCREMENT(_vector)                                                                    \
+    (AS_VECTOR_RESERVE(_vector, (_vector).size + 1) ?                                                   \
+        (_vector).data + (memset(&(_vector).data[(_vector).size], 0, sizeof(*(_vector).data)), (_vector).size++) : NULL)
+
+#define AS_VECTOR_PUSH_BACK(_vector, _element)                                  \
+    if (AS_VECTOR_RESERVE(_vector, (_vector).size + 1)) {                       \
+        (_vector).data[(_vector).size++] = _element; }                          \
+    else { AS_LOG(LV_ERROR,"Vector allocation failed"); }
+
+#if defined(_DEBUG) || defined(DEBUG)
+#define AS_VECTOR_GET(_vector, _index)                                                              \
+    ((((_index) >= 0 && (_index) < (_vector).size)                                                  \
+        || as_vector_out_of_bounds_fn((_index), (_vector).size, __FILE__, __LINE__)) ? &((_vector).data[_index]) : NULL)
+#else
+#define AS_VECTOR_GET(_vector, _index) (&((_vector).data[_index]))
+#endif
+
+// moves the last element into the removed slot, O(1) but does not keep the order
+#define AS_VECTOR_SWAP_REMOVE(_vector, _index)                                                          \
+    if ((_index) >= 0 && (_index) < (_vector).size) {                                                   \
+        (_vector).data[(_index)] = (_vector).data[--(_vector).size]; }                                  \
+    else { AS_LOG(LV_ERROR,"Vector index out of bounds"); }
+
+#define AS_VECTOR_REMOVE_AT(_vector, _index)                                                            \
+    if ((_index) >= 0 && (_index) < (_vector).size) {                                                   \
+        memmove(&(_vector).data[(_index)], &(_vector).data[(_index) + 1],                               \
+            ((_vector).size - (_index) - 1) * sizeof(*(_vector).data));                                 \
+        --(_vector).size; }                                                                             \
+    else { AS_LOG(LV_ERROR,"Vector index out of bounds"); }
+
+#define AS_VECTOR_FOR_EACH(_vector, _type, _it, _exec)  \
+for (sz _i = 0; _i < (_vector).size; ++_i) {            \
+    _type* _it = &((_vector).data[_i]);                 \
+    if (_it){ _exec };                                  \
+}
+
+#define AS_VECTOR_GET_SIZE(_vector) (_vector).size
+#define AS_VECTOR_GET_CAPACITY(_vector) (_vector).capacity
+#define AS_VECTOR_GET_LAST_INDEX(_vector) ((_vector).size - 1)
+#define AS_VECTOR_CLEAR(_vector) { (_vector).size = 0; }
+
+
+// Lock-free bounded ring buffers, the capacity must be a power of two.
+// AS_RING has one producer and one consumer, AS_MPSC_RING accepts any number of producers and one consumer.
+// head and tail sit on their own cache line so the producers and the consumer do not share it.
+// A zeroed ring is a valid empty ring. The atomics come from as_threads.h, include it where these are used.
+#define AS_CACHE_LINE_SIZE 64
+#define AS_RING_CHECK_CAPACITY(_name, _capacity) \
+    typedef char _name##_capacity_must_be_power_of_two[(((_capacity) & ((_capacity) - 1)) == 0 && (_capacity) > 0) ? 1 : -1];
+
+#define AS_RING_DECLARE(_name, _capacity, _type)                            \
+    AS_RING_CHECK_CAPACITY(_name, _capacity)                                \
+    typedef struct {                                                        \
+        volatile i64 head; /* written by the producer */                    \
+        u8 head_padding[AS_CACHE_LINE_SIZE - sizeof(i64)];                  \
+        volatile i64 tail; /* written by the consumer */                    \
+        u8 tail_padding[AS_CACHE_LINE_SIZE - sizeof(i64)];                  \
+        _type data[_capacity];                                              \
+    } _name;
+
+#define AS_RING_CAPACITY(_ring) (AS_ARRAY_SIZE((_ring).data))
+#define AS_RING_MASK(_ring) ((i64)AS_RING_CAPACITY(_ring) - 1)
+#define AS_RING_GET_SIZE(_ring) ((sz)(AS_ATOMIC_LOAD_ACQUIRE_I64(&(_ring).head) - AS_ATOMIC_LOAD_ACQUIRE_I64(&(_ring).tail)))
+#define AS_RING_IS_EMPTY(_ring) (AS_RING_GET_SIZE(_ring) == 0)
+
+// producer side, _out_pushed is false when the ring is full
+#define AS_RING_PUSH(_ring, _element, _out_pushed)                                          \
+    do { const i64 _head = (_ring).head;                                                    \
+        _out_pushed = _head - AS_ATOMIC_LOAD_ACQUIRE_I64(&(_ring).tail) < (i64)AS_RING_CAPACITY(_ring); \
+        if (_out_pushed) {                                                                  \
+            (_ring).data[_head & AS_RING_MASK(_ring)] = (_element);                         \
+            AS_ATOMIC_STORE_RELEASE_I64(&(_ring).head, _head + 1); }                        \
+    } while(0)
+
+// consumer side, FRONT returns NULL when empty and the element stays owned by the ring until POP_FRONT
+#define AS_RING_FRONT(_ring) \
+    ((_ring).tail < AS_ATOMIC_LOAD_ACQUIRE_I64(&(_ring).head) ? &(_ring).data[(_ring).tail & AS_RING_MASK(_ring)] : NULL)
+#define AS_RING_POP_FRONT(_ring) AS_ATOMIC_STORE_RELEASE_I64(&(_ring).tail, (_ring).tail + 1)
+#define AS_RING_POP(_ring, _out_element, _out_popped)                                       \
+    do { const i64 _tail = (_ring).tail;                                                    \
+        _out_popped = _tail < AS_ATOMIC_LOAD_ACQUIRE_I64(&(_ring).head);                    \
+        if (_out_popped) {                                                                  \
+            (_out_element) = (_ring).data[_tail & AS_RING_MASK(_ring)];                     \
+            AS_ATOMIC_STORE_RELEASE_I64(&(_ring).tail, _tail + 1); }                        \
+    } while(0)
+// consumer side, _index 0 is the oldest element and must be below the size
+#define AS_RING_AT(_ring, _index) (&(_ring).data[((_ring).tail + (i64)(_index)) & AS_RING_MASK(_ring)])
+
+// every slot carries a sequence (Vyukov), stored relative to the slot index so zeroed memory reads as empty:
+// lap when free for the lap, lap + 1 once written, lap + capacity once consumed
+#define AS_MPSC_RING_DECLARE(_name, _capacity, _type)                       \
+    AS_RING_CHECK_CAPACITY(_name, _capacity)                                \
+    typedef struct {                                                        \
+        volatile i64 head; /* claimed by the producers */                   \
+        u8 head_padding[AS_CACHE_LINE_SIZE - sizeof(i64)];                  \
+        volatile i64 tail; /* written by the consumer */                    \
+        u8 tail_padding[AS_CACHE_LINE_SIZE - sizeof(i64)];                  \
+        struct { volatile i64 sequence; _type value; } slots[_capacity];    \
+    } _name;
+
+#define AS_MPSC_RING_CAPACITY(_ring) (AS_ARRAY_SIZE((_ring).slots))
+#define AS_MPSC_RING_MASK(_ring) ((i64)AS_MPSC_RING_CAPACITY(_ring) - 1)
+#define AS_MPSC_RING_GET_SIZE(_ring) AS_RING_GET_SIZE(_ring)
+#define AS_MPSC_RING_IS_EMPTY(_ring) AS_RING_IS_EMPTY(_ring)
+
+// any thread, _out_pushed is false when the ring is full
+#define AS_MPSC_RING_PUSH(_ring, _element, _out_pushed)                                     \
+    do { _out_pushed = false;                                                               \
+        i64 _pos = AS_ATOMIC_LOAD_ACQUIRE_I64(&(_ring).head);                               \
+        for (;;) {                                                                          \
+            const i64 _slot = _pos & AS_MPSC_RING_MASK(_ring);                              \
+            const i64 _lap = _pos - _slot;                                                  \
+            const i64 _sequence = AS_ATOMIC_LOAD_ACQUIRE_I64(&(_ring).slots[_slot].sequence); \
+            if (_sequence == _lap) {                                                        \
+                if (AS_ATOMIC_CAS_I64(&(_ring).head, _pos, _pos + 1)) {                     \
+                    (_ring).slots[_slot].value = (_element);                                \
+                    AS_ATOMIC_STORE_RELEASE_I64(&(_ring).slots[_slot].sequence, _lap + 1);  \
+                    _out_pushed = true;                                                     \
+                    break; }                                                                \
+                _pos = AS_ATOMIC_LOAD_ACQUIRE_I64(&(_ring).head); }                         \
+            else if (_sequence < _lap) { break; } /* previous lap not consumed, full */     \
+            else { _pos = AS_ATOMIC_LOAD_ACQUIRE_I64(&(_ring).head); }                      \
+        }                                                                                   \
+    } while(0)
+
+// consumer side, FRONT returns NULL until the oldest claimed slot is fully written
+#define AS_MPSC_RING_FRONT(_ring)                                                                   \
+    (AS_ATOMIC_LOAD_ACQUIRE_I64(&(_ring).slots[(_ring).tail & AS_MPSC_RING_MASK(_ring)].sequence)   \
+        == ((_ring).tail & ~AS_MPSC_RING_MASK(_ring)) + 1                                           \
+        ? &(_ring).slots[(_ring).tail & AS_MPSC_RING_MASK(_ring)].value : NULL)
+#define AS_MPSC_RING_POP_FRONT(_ring)                                                               \
+    do { const i64 _tail = (_ring).tail;                                                            \
+        AS_ATOMIC_STORE_RELEASE_I64(&(_ring).slots[_tail & AS_MPSC_RING_MASK(_ring)].sequence,      \
+            (_tail & ~AS_MPSC_RING_MASK(_ring)) + (i64)AS_MPSC_RING_CAPACITY(_ring));               \
+        AS_ATOMIC_STORE_RELEASE_I64(&(_ring).tail, _tail + 1);                                      \
+    } while(0)
+
+// MPSC ring of variable size packets, a producer claims header + payload with one CAS on head and commits it,
+// the consumer reads the packets back in claim order and zeroes them so an uncommitted header always reads as 0.
+// A packet that would cross the end of the buffer is preceded by a padding packet filling the end.
+#define AS_BYTE_RING_ALIGNMENT 16
+#define AS_BYTE_RING_ALIGN(_size) (((_size) + AS_BYTE_RING_ALIGNMENT - 1) & ~(sz)(AS_BYTE_RING_ALIGNMENT - 1))
+
+typedef struct as_byte_ring_packet
+{
+    volatile i64 is_committed;
+    u32 size; // header included, aligned
+    u32 payload_size;
+} as_byte_ring_packet;
+
+typedef struct as_mpsc_byte_ring
+{
+    volatile i64 head; /* claimed by the producers, in bytes */
+    u8 head_padding[AS_CACHE_LINE_SIZE - sizeof(i64)];
+    volatile i64 tail; /* written by the consumer, in bytes */
+    u8 tail_padding[AS_CACHE_LINE_SIZE - sizeof(i64)];
+    u8* data;
+    sz capacity; // power of two
+} as_mpsc_byte_ring;
+
+extern b8 as_mpsc_byte_ring_init(as_mpsc_byte_ring* ring, const sz capacity);
+extern void as_mpsc_byte_ring_destroy(as_mpsc_byte_ring* ring);
+// any thread, returns where to write payload_size bytes or NULL when the ring is full, then call commit on it.
+// out_end_position (can be NULL) is where the packet ends in the ring, it was consumed once tail reached it
+extern void* as_mpsc_byte_ring_reserve(as_mpsc_byte_ring* ring, const sz payload_size, i64* out_end_position);
+extern void as_mpsc_byte_ring_commit(void* payload);
+// consumer side, front returns NULL until the oldest claimed packet is committed
+extern void* as_mpsc_byte_ring_front(as_mpsc_byte_ring* ring, sz* out_payload_size);
+extern void as_mpsc_byte_ring_pop_front(as_mpsc_byte_ring* ring);
+#define AS_MPSC_BYTE_RING_GET_USED_BYTES(_ring) ((sz)(AS_ATOMIC_LOAD_ACQUIRE_I64(&(_ring).head) - AS_ATOMIC_LOAD_ACQUIRE_I64(&(_ring).tail)))
@@ -8,14 +8,23 @@
 #include "core/as_ui.h"
 #include "defines/as_global.h"
 #include "as_memory.h"
+#include "as_jobs.h"
+#include "as_future.h"
 
-extern void as_engine_init();
+extern b8 as_engine_init(); // false when the window or the render could not be created, nothing else can be called then
+// no window nor input, as_engine_should_loop stops after frame_count frames (0 never stops), readback_func can be NULL
+extern b8 as_engine_init_headless(const u32 width, const u32 height, const u64 frame_count, as_render_readback_func readback_func, void* readback_user_data);
 extern void as_engine_clear();
 extern bool as_engine_should_loop();
 extern void as_engine_draw(); // generally at the end of the engine loop
+// 0 waits for the render thread every frame, 1 or 2 let it draw the previous frames from snapshots while the game thread ticks
+extern void as_engine_set_frame_latency(const u32 frame_latency);
+extern u32 as_engine_get_frame_latency();
 extern void as_engine_set_scene(as_scene* scene);
 extern as_render* as_engine_get_render();
+extern struct as_render_queue* as_engine_get_render_queue(); // mostly to read its stats
 extern struct as_content* as_engine_get_content();
+extern as_job_system* as_engine_get_job_system(); // for fine grained tasks instead of new threads
 extern void as_engine_reset_scene();
 
 extern f64 as_get_time();
@@ -24,7 +33,13 @@ extern f64 as_get_delta_time();
 extern as_texture* as_texture_create(const char* texture_path);
 extern as_shader* as_shader_create(const char* vertex_shader_path, const char* fragment_shader_path);
 extern as_object* as_object_create(as_shape* shape, as_shader* shader);
+// same as the above but the returned future completes with the texture/shader/object once the render thread uploaded it,
+// the caller owns a reference and releases it with as_future_release
+extern as_future* as_texture_create_async(const char* texture_path);
+extern as_future* as_shader_create_async(const char* vertex_shader_path, const char* fragment_shader_path);
+extern as_future* as_object_create_async(as_shape* shape, as_shader* shader);
 extern as_object* as_object_create_with_tick(as_shape* shape, as_shader* shader, void tick_func_ptr(as_object*, const f64));
+extern void as_object_delete(as_object* object); // the object must not be ticking anymore
 extern as_camera* as_camera_create(const as_vec3* position, const as_vec3* target);
 extern as_screen_object* as_screen_object_create(const char* fragment_shader_path);
 extern void as_camera_set_view(as_camera* camera, const as_camera_type type);
@@ -0,0 +1,45 @@
+// Abstract Shader Engine - Jed Fakhfekh - https://github.com/ougi-washi
+
+#pragma once
+
+#include "as_types.h"
+#include "as_threads.h"
+#include "as_memory.h"
+
+#define AS_FUTURE_MAX_CONTINUATIONS 4
+
+typedef enum as_future_state
+{
+	AS_FUTURE_PENDING	= 0x00,
+	AS_FUTURE_READY		= 0x01,
+} as_future_state;
+
+// runs on the thread completing the future (the render thread for render queue futures), keep it short
+typedef void (*as_future_continuation)(void* arg, void* result);
+
+// completion handle of an asynchronous operation, reference counted since the producer and the caller both hold it
+typedef struct as_future
+{
+	u32 state; // as_future_state, waited on with as_wait_on_address
+	volatile i64 ref_count;
+	void* result;
+	as_spinlock continuations_lock;
+	as_future_continuation continuations[AS_FUTURE_MAX_CONTINUATIONS];
+	void* continuation_args[AS_FUTURE_MAX_CONTINUATIONS];
+	u32 continuation_count;
+} as_future;
+
+extern as_slab as_futures_slab;
+
+extern as_future* as_future_create(); // pending, with one reference for the caller
+extern as_future* as_future_create_ready(void* result); // for operations that completed right away
+extern void as_future_retain(as_future* future);
+extern void as_future_release(as_future* future);
+
+extern void as_future_complete(as_future* future, void* result);
+extern b8 as_future_is_ready(as_future* future);
+extern void* as_future_get_result(as_future* future); // NULL while pending
+// negative timeout waits forever, returns whether the future is ready
+extern b8 as_future_wait(as_future* future, const f64 timeout_seconds);
+// runs func right away when the future is already ready, false when there is no room left for it
+extern b8 as_future_then(as_future* future, as_future_continuation func, void* arg);
@@ -0,0 +1,85 @@
+// Abstract Shader Engine - Jed Fakhfekh - https://github.com/ougi-washi
+
+#pragma once
+
+#include "as_types.h"
+#include "as_array.h"
+#include "as_threads.h"
+
+#define AS_JOB_DEQUE_SIZE 4096 // per worker, a push on a full deque runs the job right away
+#define AS_JOB_INJECT_SIZE 1024 // jobs submitted from threads that are not workers
+#define AS_MAX_JOB_WORKERS 64
+#define AS_JOB_IDLE_SPIN_COUNT 64 // failed searches before an idle worker goes to sleep
+
+typedef void (*as_job_func)(void* arg);
+typedef void (*as_job_range_func)(void* arg, const sz begin, const sz end);
+
+// counts the jobs that are not done yet, zero it (or use AS_WAIT_GROUP_INITIALIZER) before adding jobs
+typedef struct as_wait_group
+{
+	volatile i64 pending;
+} as_wait_group;
+#define AS_WAIT_GROUP_INITIALIZER { 0 }
+
+typedef struct as_job
+{
+	as_job_func func;
+	as_job_range_func range_func; // used instead of func for parallel for batches
+	void* arg;
+	sz begin;
+	sz end;
+	as_wait_group* wait_group;
+} as_job;
+
+// Chase-Lev deque, the owner pushes and pops at the bottom, other workers steal from the top
+AS_RING_CHECK_CAPACITY(as_job_deque, AS_JOB_DEQUE_SIZE)
+typedef struct as_job_deque
+{
+	volatile i64 top;
+	u8 top_padding[AS_CACHE_LINE_SIZE - sizeof(i64)];
+	volatile i64 bottom;
+	u8 bottom_padding[AS_CACHE_LINE_SIZE - sizeof(i64)];
+	as_job jobs[AS_JOB_DEQUE_SIZE];
+} as_job_deque;
+
+AS_MPSC_RING_DECLARE(as_job_inject_ring, AS_JOB_INJECT_SIZE, as_job);
+
+typedef struct as_job_worker
+{
+	as_job_deque deque;
+	struct as_job_system* system;
+	as_thread thread;
+	u32 index;
+} as_job_worker;
+
+// worker 0 is the thread that created the system, it runs jobs while it waits on them
+typedef struct as_job_system
+{
+	as_job_worker* workers;
+	u32 worker_count;
+	as_job_inject_ring inject;
+	as_spinlock inject_consumer_lock; // the inject ring has one consumer at a time
+	u32 wake_epoch;
+	volatile i64 sleeping_workers;
+	volatile b8 is_running;
+	AS_DECLARE_TYPE;
+} as_job_system;
+
+// worker_count includes the calling thread, 0 uses one worker per cpu core
+extern as_job_system* as_job_system_create(const u32 worker_count);
+extern void as_job_system_destroy(as_job_system* system);
+extern u32 as_job_system_get_worker_count(as_job_system* system);
+// index of the calling thread in the system, -1 when it is not one of its workers
+extern i32 as_job_system_get_worker_index(as_job_system* system);
+
+extern void as_job_submit(as_job_system* system, as_job_func func, void* arg, as_wait_group* wait_group);
+// runs func over [0, count) split in batches of batch_size (0 picks one), returns when all batches are done
+extern void as_job_parallel_for(as_job_system* system, const sz count, const sz batch_size, as_job_range_func func, void* arg);
+// runs one pending job on the calling thread, false if there was nothing to run
+extern b8 as_job_run_pending(as_job_system* system);
+
+extern void as_wait_group_add(as_wait_group* wait_group, const i64 count);
+extern void as_wait_group_done(as_wait_group* wait_group);
+extern b8 as_wait_group_is_done(as_wait_group* wait_group);
+// runs other jobs while waiting, so workers can wait on the jobs they submitted
+extern void as_wait_group_wait(as_job_system* system, as_wait_group* wait_group);
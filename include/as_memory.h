@@ -5,46 +5,282 @@
 #pragma warning(disable: 6308)
 
 #include "as_types.h"
+#include "as_threads.h"
 #include <stdio.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
 
+// set from cmake with AS_MEMORY_TRACKING, when off AS_MALLOC/AS_FREE skip the allocations table, its lock and the call sites.
+// the per tag counters are still updated (relaxed, per thread) so the tag stats and AS_LOG_MEMORY keep working
+#ifndef AS_MEMORY_TRACKING
+#define AS_MEMORY_TRACKING 1
+#endif
+
+// allocations from this size are mapped from the OS, they come back as zero pages that are only committed when touched
+#define AS_MEMORY_LARGE_ALLOCATION_SIZE (256 * 1024)
+
+// memory tags, every allocation is accounted to one of them
+typedef enum as_memory_tag
+{
+	AS_MEMORY_TAG_NONE,
+	AS_MEMORY_TAG_RENDER,
+	AS_MEMORY_TAG_SHADER,
+	AS_MEMORY_TAG_SCENE,
+	AS_MEMORY_TAG_CONTENT,
+	AS_MEMORY_TAG_QUEUE,
+	AS_MEMORY_TAG_IO,
+	AS_MEMORY_TAG_COUNT
+} as_memory_tag;
+
+typedef struct as_memory_tag_stats
+{
+	i64 current_bytes;
+	i64 peak_bytes; // highest current_bytes ever reached, updated by every allocation
+	i64 live_count;
+	i64 total_count;
+	i64 frame_allocated_bytes; // churn of the frame in progress
+	i64 frame_freed_bytes;
+	i64 last_frame_allocated_bytes; // churn of the last completed frame
+	i64 last_frame_freed_bytes;
+} as_memory_tag_stats;
+
+typedef enum as_memory_dump_format
+{
+	AS_MEMORY_DUMP_JSON,
+	AS_MEMORY_DUMP_CSV
+} as_memory_dump_format;
+
+extern const char* as_memory_tag_to_string(const as_memory_tag tag);
+extern as_memory_tag_stats as_memory_get_tag_stats(const as_memory_tag tag);
+extern void as_memory_end_frame();
+extern void as_memory_log_tag_stats();
+extern b8 as_memory_dump_stats(const char* path, const as_memory_dump_format format);
+
+// per frame allocation counters, frames are closed by as_memory_end_frame
+typedef struct as_memory_frame_stats
+{
+	i64 frame_index;
+	i64 allocation_count; // in the frame in progress
+	i64 free_count;
+	i64 allocated_bytes;
+	i64 last_allocation_count; // in the last completed frame
+	i64 last_free_count;
+	i64 last_allocated_bytes;
+	i64 worst_allocation_count; // worst completed frame after the warm-up
+	i64 worst_frame_index;
+} as_memory_frame_stats;
+
+// call sites that allocated after the warm-up, only recorded when tracking is on
+#define AS_MEMORY_MAX_FRAME_OFFENDERS 256
+typedef struct as_memory_frame_offender
+{
+	const char* file;
+	const char* type;
+	u32 line;
+	u64 count;
+	u64 bytes;
+	i64 first_frame;
+} as_memory_frame_offender;
+
+extern as_memory_frame_stats as_memory_get_frame_stats();
+extern void as_memory_set_strict_mode(const b8 enabled, const i64 warmup_frames); // logs every new call site allocating after warmup_frames
+extern void as_memory_log_frame_offenders(const u32 max_count);
+
+#if AS_MEMORY_TRACKING
 #define MAX_ALLOCATIONS_COUNT 257400
+#define AS_ALLOCATIONS_TABLE_BITS 19
+#define AS_ALLOCATIONS_TABLE_SIZE (1 << AS_ALLOCATIONS_TABLE_BITS) // keeps the load factor under 0.5 at MAX_ALLOCATIONS_COUNT
 
 typedef struct as_allocation
 {
 	void* ptr;
 	size_t size;
-	char file[256];
-	u16 line;
-	char type[128];
+	const char* file; // __FILE__ and type names are string literals, only the pointers are kept
+	const char* type;
+	u32 line;
+	as_memory_tag tag;
 } as_allocation;
 
-#define AS_INIT_ALLOCATION(_allocation)				\
-_allocation.ptr = NULL;								\
-_allocation.size = 0;								\
-strcpy(allocations[allocations_count].file, "");	\
-_allocation.line = 0;								\
-strcpy(allocations[allocations_count].type, _type);
-
-#define AS_DECLARE_ALLOCATION(_allocation)			\
-as_allocation _allocation;							\
-AS_INIT_ALLOCATION(_allocation);
-
 extern u32 allocations_count;
 extern u64 allocated_memory;
-extern as_allocation allocations[];
+extern as_allocation allocations[]; // open addressing table keyed by ptr, empty slots have a NULL ptr
 
-extern void* as_malloc_fn(const size_t _size, const char* _file, const u32 _line, const char* _type);
+extern void* as_malloc_fn(const size_t _size, const char* _file, const u32 _line, const char* _type, const as_memory_tag _tag);
 extern void* as_realloc_fn(void* _ptr, const size_t _size, const char* _file, const u32 _line);
 extern void as_free_fn(void* _ptr);
 extern char* as_allocation_to_string(as_allocation* _allocation);
 extern void as_log_memory();
 
-#define AS_MALLOC(_size) (as_malloc_fn(_size, __FILE__, __LINE__, ""))
-#define AS_MALLOC_WITH_TYPE(_size, _type) (as_malloc_fn(_size, __FILE__, __LINE__, _type))
+#define AS_MALLOC(_size) (as_malloc_fn(_size, __FILE__, __LINE__, "", AS_MEMORY_TAG_NONE))
+#define AS_MALLOC_WITH_TYPE(_size, _type) (as_malloc_fn(_size, __FILE__, __LINE__, _type, AS_MEMORY_TAG_NONE))
+#define AS_MALLOC_TAGGED(_size, _type, _tag) (as_malloc_fn(_size, __FILE__, __LINE__, _type, _tag))
 #define AS_REALLOC(_ptr, _size) (as_realloc_fn(_ptr, _size, __FILE__, __LINE__))
 #define AS_FREE(_ptr) (as_free_fn(_ptr))
 #define AS_LOG_MEMORY() (as_log_memory())
+#else
+extern void* as_malloc_untracked_fn(const size_t _size, const as_memory_tag _tag);
+extern void* as_realloc_untracked_fn(void* _ptr, const size_t _size);
+extern void as_free_untracked_fn(void* _ptr);
+
+#define AS_MALLOC(_size) (as_malloc_untracked_fn(_size, AS_MEMORY_TAG_NONE))
+#define AS_MALLOC_WITH_TYPE(_size, _type) (as_malloc_untracked_fn(_size, AS_MEMORY_TAG_NONE))
+#define AS_MALLOC_TAGGED(_size, _type, _tag) (as_malloc_untracked_fn(_size, _tag))
+#define AS_REALLOC(_ptr, _size) (as_realloc_untracked_fn(_ptr, _size))
+#define AS_FREE(_ptr) (as_free_untracked_fn(_ptr))
+#define AS_LOG_MEMORY() (as_memory_log_tag_stats()) // no allocations table to list, logs the tag stats instead
+#endif
 
 #define AS_MALLOC_SINGLE(_type) (_type*)AS_MALLOC(sizeof(_type))
+#define AS_MALLOC_SINGLE_TAGGED(_type, _tag) (_type*)AS_MALLOC_TAGGED(sizeof(_type), #_type, _tag)
+
+// arena, linear allocator for short lived data, freed all at once by a reset or down to a mark
+#define AS_ARENA_DEFAULT_ALIGNMENT 16
+#define AS_ARENA_FRAME_SIZE (64 * 1024 * 1024) // has to fit a file pool and a shader binary pool
+
+typedef struct as_arena
+{
+	u8* data;
+	sz capacity;
+	sz offset;
+	sz peak;
+} as_arena;
+
+typedef sz as_arena_mark;
+
+extern as_arena* as_arena_create(const sz capacity, const as_memory_tag tag);
+extern void as_arena_destroy(as_arena* arena);
+extern void* as_arena_alloc(as_arena* arena, const sz size, const sz alignment);
+extern as_arena_mark as_arena_get_mark(const as_arena* arena);
+extern void as_arena_rewind(as_arena* arena, const as_arena_mark mark);
+extern void as_arena_reset(as_arena* arena);
+
+// one frame arena per thread, created on first use, the render thread resets its own after drawing each frame
+extern as_arena* as_arena_get_frame();
+extern void as_arena_destroy_frame();
+
+#define AS_ARENA_ALLOC(_arena, _size) (as_arena_alloc(_arena, _size, AS_ARENA_DEFAULT_ALIGNMENT))
+#define AS_ARENA_ALLOC_SINGLE(_arena, _type) (_type*)AS_ARENA_ALLOC(_arena, sizeof(_type))
+#define AS_ARENA_ALLOC_ARRAY(_arena, _type, _count) (_type*)AS_ARENA_ALLOC(_arena, sizeof(_type) * (_count))
+
+// slab, pages of fixed size items with a free list, for engine objects that are created and destroyed often
+#define AS_SLAB_PAGE_SIZE (1024 * 1024)
+#define AS_SLAB_MAX_ITEMS_PER_PAGE 64 // one bit per item in the page live mask
+
+typedef struct as_slab_page
+{
+	struct as_slab_page* next;
+	u8* data;
+	u64 live_mask;
+	sz live_count;
+} as_slab_page;
+
+// every item is preceded by its page and slot so freeing does not have to search the pages,
+// the free list also lives in the headers so freed items keep their content (and obj_flag)
+typedef struct as_slab_item_header
+{
+	as_slab_page* page;
+	struct as_slab_item_header* next_free;
+	sz slot;
+} as_slab_item_header;
+#define AS_SLAB_ITEM_OFFSET ((sizeof(as_slab_item_header) + AS_ARENA_DEFAULT_ALIGNMENT - 1) & ~(sz)(AS_ARENA_DEFAULT_ALIGNMENT - 1))
+
+typedef struct as_slab
+{
+	const char* name;
+	sz item_size;
+	sz item_stride;
+	sz items_per_page;
+	as_slab_page* pages;
+	as_slab_item_header* free_list;
+	sz page_count;
+	sz live_count;
+	sz peak_count;
+	as_memory_tag tag;
+	as_mutex mutex;
+} as_slab;
+
+typedef struct as_slab_stats
+{
+	sz live_count;
+	sz peak_count;
+	sz capacity;
+	sz page_count;
+	sz empty_page_count;
+	f32 occupancy; // live items over capacity
+	f32 fragmentation; // free slots stranded in pages that still hold live items, over capacity
+} as_slab_stats;
+
+#define AS_SLAB_INITIALIZER(_type, _tag) { #_type, sizeof(_type), 0, 0, NULL, NULL, 0, 0, 0, _tag, AS_MUTEX_INITIALIZER }
+
+extern void* as_slab_alloc(as_slab* slab);
+extern void as_slab_free(as_slab* slab, void* ptr);
+extern b8 as_slab_owns(as_slab* slab, const void* ptr); // walks the pages, not meant for hot paths
+extern void as_slab_destroy(as_slab* slab);
+extern as_slab_stats as_slab_get_stats(as_slab* slab);
+extern void as_slab_log_stats(as_slab* slab);
+
+#define AS_SLAB_ALLOC_SINGLE(_slab, _type) (_type*)as_slab_alloc(_slab)
+
+// iterates live items page by page, the slab must not be modified while iterating
+#define AS_SLAB_FOR_EACH(_slab, _type, _it, _exec)                                              \
+for (as_slab_page* _page = (_slab)->pages; _page; _page = _page->next) {                        \
+	for (sz _slot = 0; _slot < (_slab)->items_per_page; _slot++) {                              \
+		if (!(_page->live_mask & (1ull << _slot))) { continue; }                                \
+		_type* _it = (_type*)(_page->data + _slot * (_slab)->item_stride + AS_SLAB_ITEM_OFFSET);        \
+		{ _exec };                                                                              \
+	}                                                                                           \
+}
+
+// generational handles, index into the table slots and the generation the slot had when the handle was made,
+// a handle to a removed item stops resolving instead of pointing to whatever reused the slot
+typedef struct as_handle
+{
+	u32 index;
+	u32 generation; // 0 is never issued
+} as_handle;
+#define AS_HANDLE_INVALID ((as_handle){ 0, 0 })
+#define AS_HANDLE_IS_NULL(_handle) ((_handle).generation == 0)
+
+typedef struct as_handle_slot
+{
+	u32 generation;
+	u32 dense_index;
+	u32 next_free; // slot index + 1, 0 ends the free list
+} as_handle_slot;
+AS_VECTOR_DECLARE(as_handle_slots, as_handle_slot);
+AS_VECTOR_DECLARE(as_handle_items, void*);
+AS_VECTOR_DECLARE(as_handle_indices, u32);
+
+// items are kept dense (swap-remove) for iteration, the table stores pointers so the items themselves never move
+typedef struct as_handle_table
+{
+	const char* name;
+	as_handle_slots slots;
+	as_handle_items items;
+	as_handle_indices dense_slots; // slot index of each dense item
+	u32 free_head; // slot index + 1
+	as_mutex mutex;
+} as_handle_table;
+#define AS_HANDLE_TABLE_INITIALIZER(_name) { _name, { 0 }, { 0 }, { 0 }, 0, AS_MUTEX_INITIALIZER }
+
+extern as_handle as_handle_table_add(as_handle_table* table, void* item);
+extern void* as_handle_table_get(as_handle_table* table, const as_handle handle);
+extern sz as_handle_table_get_dense_index(as_handle_table* table, const as_handle handle); // -1 if stale
+// returns the removed item or NULL if the handle is stale, out_moved receives the item that took its dense index (NULL if none)
+extern void* as_handle_table_remove(as_handle_table* table, const as_handle handle, void** out_moved);
+// reorders the dense items by compare (called with two items), handles keep resolving. insertion sort, so cheap when the order
+// changed little since the last call. on_moved (can be NULL) gets every item whose dense index changed, under the table lock
+extern void as_handle_table_sort(as_handle_table* table, i32 compare(const void*, const void*), void on_moved(void*, const sz));
+extern void as_handle_table_destroy(as_handle_table* table);
+
+#define AS_HANDLE_TABLE_GET_SIZE(_table) ((_table).items.size)
+#define AS_HANDLE_TABLE_GET_AT(_table, _type, _dense_index) ((_type*)(_table).items.data[_dense_index])
+#define AS_HANDLE_TABLE_GET(_table, _type, _handle) ((_type*)as_handle_table_get(_table, _handle))
+
+// dense iteration, the table must not be modified while iterating
+#define AS_HANDLE_TABLE_FOR_EACH(_table, _type, _it, _exec)                 \
+for (sz _i = 0; _i < (_table).items.size; ++_i) {                           \
+	_type* _it = (_type*)(_table).items.data[_i];                           \
+	{ _exec };                                                              \
+}
@@ -11,7 +11,7 @@ typedef HANDLE as_thread;
 typedef DWORD as_thread_id;
 #elif PLATFORM_LINUX || PLATFORM_UNIX
 #include <stdlib.h>
-#include <pthreads.h>
+#include <pthread.h>
 typedef pthread_t as_thread;
 typedef pid_t as_thread_id;
 #endif
@@ -23,8 +23,28 @@ extern as_thread_id as_thread_get_id();
 extern void as_thread_terminate(as_thread thread);
 extern i32 as_get_cpu_cores();
 extern i32 as_thread_get_priority(as_thread thread);
-extern void as_thread_set_priority(as_thread thread, const i32 priority);
+extern void as_thread_set_priority(as_thread thread, const i32 priority); // within the current policy, SCHED_OTHER ignores it on linux
 extern void as_thread_detach(as_thread thread);
+extern void as_thread_yield();
+
+typedef enum as_thread_policy
+{
+	AS_THREAD_POLICY_DEFAULT		= 0x00,
+	AS_THREAD_POLICY_FIFO			= 0x01, // real time, runs until it blocks or yields
+	AS_THREAD_POLICY_ROUND_ROBIN	= 0x02, // real time, time sliced with threads of the same priority
+} as_thread_policy;
+
+#define AS_THREAD_NAME_SIZE 16 // linux limit, including the null terminator
+extern void as_thread_set_name(as_thread thread, const char* name); // shown by debuggers, perf and htop
+extern b8 as_thread_set_affinity(as_thread thread, const u64 core_mask); // bit n allows core n, 0 allows every core
+// real time policies need CAP_SYS_NICE (or rtprio limits) on linux, windows maps them to the top priority levels
+extern b8 as_thread_set_policy(as_thread thread, const as_thread_policy policy, const i32 priority);
+
+// sleeps while *address == expected (futex / WaitOnAddress), it can wake up spuriously so callers loop
+extern void as_wait_on_address(u32* address, const u32 expected);
+extern void as_wait_on_address_for(u32* address, const u32 expected, const f64 timeout_seconds);
+extern void as_wake_address_one(u32* address);
+extern void as_wake_address_all(u32* address);
 
 
 #if PLATFORM_WINDOWS
@@ -49,3 +69,61 @@ bool as_mutex_init(as_mutex* mutex);
 bool as_mutex_lock(as_mutex* mutex);
 bool as_mutex_unlock(as_mutex* mutex);
 bool as_mutex_destroy(as_mutex* mutex);
+
+// atomics, sequentially consistent, on naturally aligned 64-bit integers
+#if PLATFORM_WINDOWS
+#define AS_ATOMIC_LOAD_I64(_ptr)                        InterlockedCompareExchange64((volatile LONG64*)(_ptr), 0, 0)
+#define AS_ATOMIC_STORE_I64(_ptr, _value)               InterlockedExchange64((volatile LONG64*)(_ptr), (LONG64)(_value))
+#define AS_ATOMIC_EXCHANGE_I64(_ptr, _value)            InterlockedExchange64((volatile LONG64*)(_ptr), (LONG64)(_value))
+#define AS_ATOMIC_ADD_I64(_ptr, _value)                 InterlockedExchangeAdd64((volatile LONG64*)(_ptr), (LONG64)(_value))
+#define AS_ATOMIC_CAS_I64(_ptr, _expected, _desired)    (InterlockedCompareExchange64((volatile LONG64*)(_ptr), (LONG64)(_desired), (LONG64)(_expected)) == (LONG64)(_expected))
+// x64 loads are acquire and stores are release, volatile (/volatile:ms) keeps the compiler from reordering around them
+#define AS_ATOMIC_LOAD_ACQUIRE_I64(_ptr)                (*(volatile LONG64*)(_ptr))
+#define AS_ATOMIC_STORE_RELEASE_I64(_ptr, _value)       (*(volatile LONG64*)(_ptr) = (LONG64)(_value))
+#define AS_ATOMIC_LOAD_RELAXED_I64(_ptr)                (*(volatile LONG64*)(_ptr))
+#define AS_ATOMIC_STORE_RELAXED_I64(_ptr, _value)       (*(volatile LONG64*)(_ptr) = (LONG64)(_value))
+#define AS_ATOMIC_LOAD_RELAXED_I32(_ptr)                (*(volatile LONG*)(_ptr))
+#define AS_ATOMIC_LOAD_ACQUIRE_I32(_ptr)                (*(volatile LONG*)(_ptr))
+#define AS_ATOMIC_ADD_I32(_ptr, _value)                 InterlockedExchangeAdd((volatile LONG*)(_ptr), (LONG)(_value))
+#define AS_ATOMIC_EXCHANGE_I32(_ptr, _value)            InterlockedExchange((volatile LONG*)(_ptr), (LONG)(_value))
+#define AS_ATOMIC_CAS_I32(_ptr, _expected, _desired)    (InterlockedCompareExchange((volatile LONG*)(_ptr), (LONG)(_desired), (LONG)(_expected)) == (LONG)(_expected))
+#define AS_CPU_PAUSE()                                  YieldProcessor()
+#elif PLATFORM_LINUX || PLATFORM_UNIX
+#define AS_ATOMIC_LOAD_I64(_ptr)                        __atomic_load_n((_ptr), __ATOMIC_SEQ_CST)
+#define AS_ATOMIC_STORE_I64(_ptr, _value)               __atomic_store_n((_ptr), (_value), __ATOMIC_SEQ_CST)
+#define AS_ATOMIC_EXCHANGE_I64(_ptr, _value)            __atomic_exchange_n((_ptr), (_value), __ATOMIC_SEQ_CST)
+#define AS_ATOMIC_ADD_I64(_ptr, _value)                 __atomic_fetch_add((_ptr), (_value), __ATOMIC_SEQ_CST)
+#define AS_ATOMIC_CAS_I64(_ptr, _expected, _desired)    __sync_bool_compare_and_swap((_ptr), (_expected), (_desired))
+#define AS_ATOMIC_LOAD_ACQUIRE_I64(_ptr)                __atomic_load_n((_ptr), __ATOMIC_ACQUIRE)
+#define AS_ATOMIC_STORE_RELEASE_I64(_ptr, _value)       __atomic_store_n((_ptr), (_value), __ATOMIC_RELEASE)
+#define AS_ATOMIC_LOAD_RELAXED_I64(_ptr)                __atomic_load_n((_ptr), __ATOMIC_RELAXED)
+#define AS_ATOMIC_STORE_RELAXED_I64(_ptr, _value)       __atomic_store_n((_ptr), (_value), __ATOMIC_RELAXED)
+#define AS_ATOMIC_LOAD_RELAXED_I32(_ptr)                __atomic_load_n((_ptr), __ATOMIC_RELAXED)
+#define AS_ATOMIC_LOAD_ACQUIRE_I32(_ptr)                __atomic_load_n((_ptr), __ATOMIC_ACQUIRE)
+#define AS_ATOMIC_ADD_I32(_ptr, _value)                 __atomic_fetch_add((_ptr), (_value), __ATOMIC_SEQ_CST)
+#define AS_ATOMIC_EXCHANGE_I32(_ptr, _value)            __atomic_exchange_n((_ptr), (_value), __ATOMIC_SEQ_CST)
+#define AS_ATOMIC_CAS_I32(_ptr, _expected, _desired)    __sync_bool_compare_and_swap((_ptr), (_expected), (_desired))
+#if defined(__x86_64__) || defined(__i386__)
+#define AS_CPU_PAUSE()                                  __builtin_ia32_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+#define AS_CPU_PAUSE()                                  __asm__ __volatile__("yield")
+#else
+#define AS_CPU_PAUSE()                                  do {} while (0)
+#endif
+#endif
+
+// test and test-and-set lock, spins with exponential backoff then sleeps on the lock word (futex / WaitOnAddress)
+// it has no owner, so it can be unlocked from another thread and unlocking an unlocked lock does nothing
+#define AS_SPINLOCK_SPIN_ROUNDS     16
+#define AS_SPINLOCK_MAX_BACKOFF     64 // in pauses
+extern b8 as_spinlock_try_lock(as_spinlock* lock);
+extern void as_spinlock_lock(as_spinlock* lock);
+extern void as_spinlock_unlock(as_spinlock* lock);
+extern b8 as_spinlock_is_locked(as_spinlock* lock);
+
+// object locking, on the obj_lock that AS_DECLARE_TYPE adds to every flagged struct
+#define AS_WAIT_AND_LOCK(_obj)  as_spinlock_lock(&(_obj)->obj_lock)
+#define AS_TRY_LOCK(_obj)       as_spinlock_try_lock(&(_obj)->obj_lock)
+#define AS_UNLOCK(_obj)         as_spinlock_unlock(&(_obj)->obj_lock)
+#define AS_IS_LOCKED(_obj)      as_spinlock_is_locked(&(_obj)->obj_lock)
+#define AS_IS_UNLOCKED(_obj)    (AS_IS_VALID(_obj) && !AS_IS_LOCKED(_obj))
@@ -60,6 +60,24 @@ typedef bool		b8;
 #error "Unknown platform"
 #endif
 
+#if PLATFORM_WINDOWS
+#define AS_THREAD_LOCAL __declspec(thread)
+#else
+#define AS_THREAD_LOCAL __thread
+#endif
+
+// Bit scanning, as_ctz64 and as_clz64 expect a non zero value
+#if PLATFORM_WINDOWS
+#include <intrin.h>
+static inline u32 as_ctz64(const u64 value) { unsigned long index = 0; _BitScanForward64(&index, value); return (u32)index; }
+static inline u32 as_clz64(const u64 value) { unsigned long index = 0; _BitScanReverse64(&index, value); return 63 - (u32)index; }
+static inline u32 as_popcount64(const u64 value) { return (u32)__popcnt64(value); }
+#else
+static inline u32 as_ctz64(const u64 value) { return (u32)__builtin_ctzll(value); }
+static inline u32 as_clz64(const u64 value) { return (u32)__builtin_clzll(value); }
+static inline u32 as_popcount64(const u64 value) { return (u32)__builtin_popcountll(value); }
+#endif
+
 // Variables Management
 #define AS_INIT(_type, _struct)						\
 memset(_struct, 0, sizeof(_type));
@@ -77,6 +95,7 @@ memset(_struct, 0, sizeof(_type) * _array_size);
 HANDLE printf_mutex;
 #elif PLATFORM_LINUX || PLATFORM_UNIX
 #include <unistd.h>
+#include <pthread.h>
 #include <sys/syscall.h>
 pthread_mutex_t printf_mutex = PTHREAD_MUTEX_INITIALIZER;
 #endif
@@ -86,7 +105,7 @@ pthread_mutex_t printf_mutex = PTHREAD_MUTEX_INITIALIZER;
 #define END_LOG() ReleaseMutex(printf_mutex);
 #elif PLATFORM_LINUX || PLATFORM_UNIX
 #define START_LOG() pthread_mutex_lock(&printf_mutex);
-#deifne END_LOG() pthread_mutex_unlock(&printf_mutex);
+#define END_LOG() pthread_mutex_unlock(&printf_mutex);
 #endif
 
 typedef enum log_level { LV_LOG = 0, LV_WARNING = 1, LV_ERROR = 2 } log_level;
@@ -128,29 +147,24 @@ typedef enum as_flag
 {
 	AS_INVALID			= 0x00,
 	AS_VALID			= 0x01,
-	AS_LOCKED			= 0x02,
-	AS_DIRTY			= 0x03,
-	AS_MAX				= 0x04,
+	AS_DIRTY			= 0x02,
+	AS_MAX				= 0x03,
 } as_flag;
 
-#define AS_DECLARE_TYPE as_flag obj_flag
+// lock word, 0 unlocked, 1 locked, 2 locked with sleeping waiters (see as_spinlock_lock in as_threads)
+typedef struct as_spinlock { u32 state; } as_spinlock;
+#define AS_SPINLOCK_INITIALIZER { 0 }
+
+// the lock lives next to the flag so locking never changes the validity of an object
+#define AS_DECLARE_TYPE as_flag obj_flag; as_spinlock obj_lock
 
 #define AS_IS_VALID(_obj)      	((_obj) && (u8)(_obj)->obj_flag >= AS_VALID && (u8)(_obj)->obj_flag < AS_MAX)
 #define AS_IS_INVALID(_obj)    	(!(&((_obj)->obj_flag)) || !AS_IS_VALID(_obj))
-#define AS_IS_LOCKED(_obj)     	((u8)(_obj)->obj_flag == AS_LOCKED)
-#define AS_IS_UNLOCKED(_obj)   	((u8)(_obj)->obj_flag == AS_VALID)
 #define AS_IS_DIRTY(_obj)   	((u8)(_obj)->obj_flag == AS_DIRTY)
 
 #define AS_SET_VALID(_obj)     	if(AS_IS_INVALID(_obj))	(_obj)->obj_flag = AS_VALID
 #define AS_SET_INVALID(_obj)	(_obj)->obj_flag = AS_INVALID
-#define AS_LOCK(_obj)    	    if(AS_IS_UNLOCKED(_obj))	(_obj)->obj_flag = AS_LOCKED
-#define AS_UNLOCK(_obj)  	    if(AS_IS_LOCKED(_obj))		(_obj)->obj_flag = AS_VALID
 #define AS_SET_DIRTY(_obj)  	(_obj)->obj_flag = AS_DIRTY
 
-#define AS_WAIT_AND_LOCK(_obj) 																\
-do{ u64 loop_counter = 0; 																		\
-while (AS_IS_LOCKED(_obj) && loop_counter < 1000000000) { loop_counter++; };					\
-AS_LOCK(_obj); } while(0)
-
 // This is a dummy type to avoid compilation errors when using void pointers
 typedef struct as_flagged_struct { AS_DECLARE_TYPE; } as_flagged_struct;
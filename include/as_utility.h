@@ -32,6 +32,62 @@ typedef struct as_file_pool
 extern as_file_handle* as_fp_make_handle(as_file_pool* file_pool);
 extern void as_fp_remove_handle(as_file_pool* file_pool, as_file_handle* handle);
 
+// string keyed hash map, open addressing with linear probing, keys are copied and their hash is kept next to them
+#define AS_STRING_MAP_MIN_CAPACITY 16
+#define AS_STRING_MAP_MAX_LOAD 0.7
+
+typedef struct as_string_map_entry
+{
+	u64 hash; // 0 empty, 1 removed
+	char* key;
+	void* value;
+} as_string_map_entry;
+
+typedef struct as_string_map
+{
+	as_string_map_entry* entries;
+	sz capacity; // power of two
+	sz size;
+	sz removed_count;
+} as_string_map;
+
+extern u64 as_string_hash(const char* str);
+extern b8 as_string_map_set(as_string_map* map, const char* key, void* value); // replaces the value of an existing key
+extern void* as_string_map_get(const as_string_map* map, const char* key);
+extern b8 as_string_map_remove(as_string_map* map, const char* key);
+extern void as_string_map_destroy(as_string_map* map);
+
+#define AS_STRING_MAP_FOR_EACH(_map, _entry, _exec)                                 \
+for (sz _i = 0; _i < (_map).capacity; ++_i) {                                       \
+	const as_string_map_entry* _entry = &(_map).entries[_i];                        \
+	if (_entry->hash > 1) { _exec };                                                \
+}
+
+// log linear histogram, exact below 4 then 4 buckets per power of two, so a percentile reads at most 25% above the real value.
+// any thread can record, readers get approximate values while it is being recorded
+#define AS_HISTOGRAM_BUCKETS_COUNT 256
+
+typedef struct as_histogram
+{
+	volatile i64 buckets[AS_HISTOGRAM_BUCKETS_COUNT];
+	volatile i64 count;
+	volatile i64 max;
+} as_histogram;
+
+typedef struct as_histogram_summary
+{
+	i64 count;
+	u64 p50;
+	u64 p95;
+	u64 p99;
+	u64 max;
+} as_histogram_summary;
+
+extern void as_histogram_record(as_histogram* histogram, const u64 value);
+extern u64 as_histogram_get_percentile(as_histogram* histogram, const f64 percentile); // percentile in [0, 1]
+extern as_histogram_summary as_histogram_summarize(as_histogram* histogram);
+extern void as_histogram_reset(as_histogram* histogram);
+
 // conversions
 extern void as_i32_to_str(const i32 integer, char* out_str);
 
@@ -50,6 +106,7 @@ extern void as_util_ensure_directory_exists(const char* path);
 extern clock_t get_current_time();
 extern f64 calculate_delta_time(clock_t start, clock_t end);
 extern void sleep_seconds(const f64 seconds);
+extern f64 get_monotonic_time(); // seconds from an arbitrary point, for measuring durations
 
 void as_serialize_to_file(void* data, const sz size, const char* path);
 #define AS_SERIALIZE_TO_FILE(_type, _data, _path) as_serialize_to_file(_data, sizeof(_type), _path)
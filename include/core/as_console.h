@@ -3,6 +3,7 @@
 #pragma once
 #include "as_threads.h"
 #include "as_array.h"
+#include "as_utility.h"
 
 #define AS_COMMAND_MAX_NAME 128
 #define AS_COMMAND_MAX_DESC 1024
@@ -22,8 +23,11 @@ typedef struct as_console
 	b8 is_running;
 	as_thread thread;
 	as_command_mapping_128 mappings;
+	as_string_map mappings_by_name; // as_command_mapping*
 }as_console;
 
 extern as_console* as_console_create();
 extern void as_console_destroy(as_console* console);
 extern as_command_mapping_128* as_console_get_mappings(as_console* console);
+extern as_command_mapping* as_console_add_mapping(as_console* console, const as_command_mapping* mapping);
+extern as_command_mapping* as_console_find_command_mapping(as_console* console, const char* command_name);
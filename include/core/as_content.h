@@ -23,12 +23,12 @@ typedef struct as_asset
 	void (*destory_func_ptr)(void*);
 	bool free_on_destruction;
 } as_asset;
-AS_ARRAY_DECLARE(as_assets_1024, 1024, as_asset);
+AS_VECTOR_DECLARE(as_assets, as_asset);
 
 typedef struct as_content
 {
 	AS_DECLARE_TYPE;
-	as_assets_1024 assets;
+	as_assets assets;
 } as_content;
 
 extern as_content* as_content_create();
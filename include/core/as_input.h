@@ -4,6 +4,7 @@
 
 #include "as_types.h"
 #include "as_array.h"
+#include "as_threads.h"
 
 #define AS_MAX_INPUT_BUFFER_SIZE 64
 
@@ -12,11 +13,11 @@ typedef struct as_input_key
     i32 key;
     i32 action;
 } as_input_key;
-AS_ARRAY_DECLARE(as_input_keys_128, 128, as_input_key);
+AS_RING_DECLARE(as_input_keys, AS_MAX_INPUT_BUFFER_SIZE, as_input_key); // history of the last events, the oldest is dropped
 
 typedef struct as_input_buffer
 {
-    as_input_keys_128 keys;
+    as_input_keys keys;
 	void (*on_add)(const as_input_key*);
     AS_DECLARE_TYPE;
 } as_input_buffer;
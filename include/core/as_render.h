@@ -6,6 +6,7 @@
 #include "as_array.h"
 #include "as_utility.h"
 #include "as_threads.h"
+#include "as_memory.h"
 #include "core/as_shapes.h"
 #include "defines/as_global.h"
 #include <vulkan/vulkan.h>
@@ -80,6 +81,7 @@ typedef struct as_texture
 	AS_DECLARE_TYPE;
 
 	VkDevice* device;
+	struct as_render* render; // its vulkan objects are retired there once destroyed
 
 	VkImage image;
 	VkDeviceMemory memory;
@@ -87,8 +89,9 @@ typedef struct as_texture
 	VkSampler sampler;
 
 	char filename[AS_MAX_PATH_SIZE];
+	as_handle handle; // in its textures pool, or in as_textures_table when made outside of a pool
 } as_texture;
-AS_ARRAY_DECLARE(as_textures_pool, AS_MAX_TEXTURE_POOL_SIZE, as_texture);
+typedef as_handle_table as_textures_pool; // as_texture*, textures live in as_textures_slab
 
 typedef struct as_shader_uniform
 {
@@ -119,6 +122,7 @@ typedef struct as_shader
 	char filename_fragment[AS_MAX_PATH_SIZE];
 
 	u64 refresh_frame; // this will define whether or not to use the graphics_pipeline
+	as_handle handle; // in as_shaders_table
 	
 }as_shader;
 
@@ -137,10 +141,10 @@ typedef struct as_object // TODO: Get GPU data out so they can loop faster in th
 	VkDeviceMemory index_buffer_memory;
 	u32 indices_size;
 
-	i32 scene_gpu_index; // index of the object in the GPU scene 
+	i32 scene_gpu_index; // index of the object in the GPU scene, same as its dense index in the scene objects
+	as_handle handle; // in the scene objects
 	
 } as_object;
-AS_ARRAY_DECLARE(as_scene_objects, AS_MAX_SCENE_OBJECTS, as_object);
 
 typedef struct as_light
 {
@@ -190,7 +194,7 @@ typedef struct as_scene_gpu_buffer
 typedef struct as_scene
 {
 	char path[AS_MAX_PATH_SIZE];
-	as_scene_objects objects;
+	as_handle_table objects; // as_object*, objects live in as_objects_slab so their address is stable
 	as_scene_lights lights;
 	as_scene_cameras cameras; // main camera is index 0
 
@@ -233,6 +237,61 @@ typedef struct as_screen_object
 } as_screen_object;
 AS_ARRAY_DECLARE(as_screen_objects_group, AS_MAX_SCREEN_OBJECTS, as_screen_object);
 
+#define AS_RENDER_MAX_FRAME_LATENCY 2 // frames the render thread may run behind the game thread
+#define AS_RENDER_SNAPSHOTS_COUNT (AS_RENDER_MAX_FRAME_LATENCY + 1) // one more for the frame the game thread is building
+#define AS_RENDER_SNAPSHOT_MAX_OBJECTS 4096
+
+// what a frame needs from the game thread, captured at the end of its tick so the render thread never reads live scene data
+typedef struct as_render_snapshot
+{
+	as_object* objects[AS_RENDER_SNAPSHOT_MAX_OBJECTS]; // draw list, in GPU index order
+	as_handle objects_handles[AS_RENDER_SNAPSHOT_MAX_OBJECTS]; // objects removed since the capture are skipped
+	as_mat4 objects_transforms[AS_MAX_GPU_OBJECT_TRANSFORMS_SIZE];
+	sz objects_size;
+	as_camera camera;
+	as_screen_object* ui_objects[AS_MAX_SCREEN_OBJECTS];
+	as_mat4 ui_data[AS_MAX_SCREEN_OBJECTS];
+	u32 ui_custom_data[AS_MAX_SCREEN_OBJECTS][AS_MAX_GPU_SCREEN_OBJECT_CUSTOM_DATA_SIZE];
+	sz ui_size;
+	u64 frame_index;
+} as_render_snapshot;
+
+// gpu objects released once the frames that may still use them are done, instead of waiting for the device idle
+typedef enum as_retired_type
+{
+	AS_RETIRED_BUFFER,
+	AS_RETIRED_MEMORY,
+	AS_RETIRED_PIPELINE,
+	AS_RETIRED_PIPELINE_LAYOUT,
+	AS_RETIRED_DESCRIPTOR_POOL,
+	AS_RETIRED_DESCRIPTOR_SET_LAYOUT,
+	AS_RETIRED_IMAGE,
+	AS_RETIRED_IMAGE_VIEW,
+	AS_RETIRED_SAMPLER,
+} as_retired_type;
+
+typedef struct as_retired
+{
+	as_retired_type type;
+	u64 frame; // frame_counter when retired, only the frames before it can use the object
+	union
+	{
+		VkBuffer buffer;
+		VkDeviceMemory memory;
+		VkPipeline pipeline;
+		VkPipelineLayout pipeline_layout;
+		VkDescriptorPool descriptor_pool;
+		VkDescriptorSetLayout descriptor_set_layout;
+		VkImage image;
+		VkImageView image_view;
+		VkSampler sampler;
+	};
+} as_retired;
+AS_VECTOR_DECLARE(as_retired_list, as_retired);
+
+// render thread, pixels are BGRA (the swap chain format) and only valid during the call
+typedef void (*as_render_readback_func)(void* user_data, const u8* pixels, const u32 width, const u32 height, const u64 frame_index);
+
 typedef struct as_render
 {
 	VkInstance instance;
@@ -267,9 +326,22 @@ typedef struct as_render
 	VkDeviceMemory depth_image_memory;
 	VkImageView depth_image_view;
 
+	// headless renders into a ring of MAX_FRAMES_IN_FLIGHT offscreen images (swap_chain_images) instead of a swap chain
+	bool is_headless;
+	VkDeviceMemories32 offscreen_images_memory;
+	VkBuffers32 readback_buffers;
+	VkDeviceMemories32 readback_memories;
+	voids32 readback_mapped;
+	u64 readback_frames[MAX_FRAMES_IN_FLIGHT]; // frame counter + 1 of the copy pending in each slot, 0 for none
+	as_render_readback_func readback_func;
+	void* readback_user_data;
+
 	u64 current_frame; // this one is for rendering, do not use
 	u64 frame_counter; // use this for frame tracking
 
+	as_retired_list retired; // textures are also destroyed outside of the render thread, so it has its own lock
+	as_spinlock retired_lock;
+
 	// move somewhere else maybe
 	f64 time;
 	f64 last_frame_time;
@@ -280,9 +352,16 @@ typedef struct as_render
 } as_render;
 
 extern as_render* as_render_create(void* display_context);
+// no window, surface nor swap chain, so it also runs on cpu devices (lavapipe, swiftshader).
+// frames are not capped to AS_TARGET_FPS, readback_func (can be NULL) gets each frame once the gpu is done with it
+extern as_render* as_render_create_headless(const u32 width, const u32 height, as_render_readback_func readback_func, void* readback_user_data);
+// render thread timing, call them through as_rq_render_start/end_draw_loop, the engine paces the game thread on its own
 extern void as_render_start_draw_loop(as_render* render);
 extern void as_render_end_draw_loop(as_render* render);
-extern void as_render_draw_frame(as_render* render, void* display_context, as_camera* camera, as_scene* scene, as_screen_objects_group* screen_objects_group);
+// draws from the snapshot when there is one, from the live camera, scene and screen objects otherwise
+extern void as_render_draw_frame(as_render* render, void* display_context, as_camera* camera, as_scene* scene, as_screen_objects_group* screen_objects_group, const as_render_snapshot* snapshot);
+// game thread, the scene is locked while its objects are copied
+extern void as_render_snapshot_capture(as_render_snapshot* snapshot, as_camera* camera, as_scene* scene, as_screen_objects_group* screen_objects_group);
 extern void as_render_destroy(as_render* render);
 extern u64 as_render_get_frame_count(as_render* render);
 extern u64* as_render_get_frame_count_ptr(as_render* render);
@@ -303,10 +382,14 @@ extern as_vec2 as_screen_object_get_position(const as_screen_object* screen_obje
 extern as_vec2 as_screen_object_get_rotation(const as_screen_object* screen_object);
 extern as_vec2 as_screen_object_get_extent(const as_screen_object* screen_object);
 
+extern as_slab as_textures_slab; // textures made outside of a textures pool
+extern as_handle_table as_textures_table;
 extern as_texture* as_texture_make(const char* path);
+extern as_texture* as_texture_get(as_textures_pool* textures_pool, const as_handle handle); // NULL pool looks up as_textures_table
 extern void as_texture_init(as_texture* texture, const char* path);
 extern bool as_texture_update(as_render* render, as_texture* texture);
 extern void as_texture_destroy(as_texture* texture);
+extern void as_texture_free(as_texture* texture);
 extern as_textures_pool* as_textures_pool_create();
 extern void as_textures_pool_destroy(as_textures_pool* textures_pool);
 extern as_texture* as_texture_get_from_pool(as_textures_pool* textures_pool);
@@ -316,10 +399,14 @@ extern void as_shader_create_graphics_pipeline(as_shader* shader);
 extern sz as_shader_add_uniform_float(as_shader_uniforms* uniforms, f32* value);
 extern sz as_shader_add_uniform_texture(as_shader_uniforms* uniforms, as_texture* texture);
 extern sz as_shader_add_scene_gpu(as_shader_uniforms* uniforms, as_scene_gpu_buffer* scene_gpu_buffer);
+extern as_slab as_shaders_slab;
+extern as_handle_table as_shaders_table;
 extern as_shader* as_shader_make(as_render* render, const char* vertex_shader_path, const char* fragment_shader_path);
+extern as_shader* as_shader_get(const as_handle handle);
 extern void as_shader_set_uniforms(as_render* render, as_shader* shader, as_shader_uniforms* uniforms);
 extern void as_shader_update(as_render* render, as_shader* shader);
 extern void as_shader_destroy(as_render* render, as_shader* shader);
+extern void as_shader_free(as_shader* shader); // releases the memory only, use as_shader_destroy for GPU resources
 
 extern as_camera* as_camera_make(as_scene* scene, const as_vec3* position, const as_vec3* target);
 extern as_camera* as_camera_get_main(as_scene* scene);
@@ -327,7 +414,9 @@ extern void as_camera_set_main(as_scene* scene, as_camera* camera);
 extern void as_camera_set_position(as_camera* camera, const as_vec3* position);
 extern void as_camera_set_target(as_camera* camera, const as_vec3* target);
 
+extern as_slab as_objects_slab;
 extern as_object* as_object_consturct(as_render* render, as_scene* scene);
+extern as_object* as_object_get(as_scene* scene, const as_handle handle);
 extern void as_object_update(as_render* render, as_object* object, as_shape* shape, as_shader* shader);
 extern void as_object_set_instance_count(as_object* object, const u32 instance_count);
 extern void as_object_set_translation(as_object* object, const as_vec3* translation);
@@ -339,6 +428,7 @@ extern void as_object_set_scale(as_object* object, const as_vec3* scale);
 extern const as_mat4* as_object_get_transform(const as_object* object);
 extern as_vec3 as_object_get_translation(const as_object* object);
 extern void as_object_destroy(as_render* render, as_object* object);
+extern void as_object_remove(as_render* render, as_scene* scene, as_object* object); // only the object moved into its slot gets a new GPU index
 
 extern as_scene* as_scene_create(as_render* render, const char* scene_path);
 extern as_scene* as_scene_load(as_render* render, const char* scene_path);
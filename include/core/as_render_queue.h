@@ -4,27 +4,139 @@
 
 #include "as_types.h"
 #include "as_threads.h"
+#include "as_future.h"
 #include "core/as_render.h"
 
-#define AS_RENDER_QUEUE_WAIT_TIME 1./100000. 
-#define AS_RENDER_QUEUE_REST_TIME 1./1000000. // wait 1ms when there is nothing to process
-#define AS_RENDER_QUEUE_SIZE 1024
-#define AS_RENDER_QUEUE_MAX_WAIT_ITERATION 1000000
-#define AS_RENDER_QUEUE_MAX_ARG_SIZE 512
+#define AS_RENDER_QUEUE_MAX_WAIT_TIME 10. // seconds a producer waits for the queue to drain or to have room before giving up
+#define AS_RENDER_QUEUE_IDLE_SPIN_COUNT 256 // empty checks before the queue thread goes to sleep
+#define AS_RENDER_QUEUE_IDLE_PAUSE_COUNT 64 // of those, the ones that pause, the others yield to producers sharing the core
+#define AS_RENDER_QUEUE_SIZE 1024 // most commands executed in one batch
+#define AS_RENDER_QUEUE_BYTES (1024 * 1024) // per lane, power of two, commands take a header and their argument bytes
+#define AS_RENDER_QUEUE_FRAME_BYTES (64 * 1024) // the frame lane only holds a few frames
+#define AS_RENDER_QUEUE_BACKGROUND_BUDGET (4. / 1000.) // seconds of background commands between two frames
+#define AS_RENDER_QUEUE_BACKGROUND_IDLE_TIME (1. / 20.) // without a frame for this long, background commands are not throttled
+#define AS_RENDER_QUEUE_MAX_ARG_SIZE 4096 // in bytes
+#define AS_RENDER_QUEUE_KEYS_SIZE 4096 // power of two, most keyed commands pending at once, the extra ones are not coalesced
+#define AS_RENDER_QUEUE_STATS_COMMANDS_SIZE 64 // power of two, command functions timed separately, the extra ones are not timed
+#define AS_RENDER_QUEUE_STATS_LOG_PERIOD 0. // seconds between two stats logs from the queue thread, 0 for never
+#define AS_RENDER_QUEUE_CAPTURE_MAGIC "ASRQCAP3" // 8 bytes starting a capture file
+#define AS_RENDER_QUEUE_CAPTURE_BINDINGS_SIZE 1024 // power of two, starting size of the capture bindings table, it grows past three quarters
+// the queue thread records and presents the frames, real time policies are opt-in (see as_thread_set_policy)
+#define AS_RENDER_THREAD_POLICY AS_THREAD_POLICY_DEFAULT
+#define AS_RENDER_THREAD_PRIORITY 2 // windows level for the default policy, 1-99 for the real time ones
+#define AS_RENDER_THREAD_CORE_MASK 0 // 0 lets it run on any core
 
+// the queue thread always runs the frame lane first, then the normal lane, then the background lane within its budget.
+// the order is only kept inside a lane, a command must not depend on an earlier one of a lane that runs after its own.
+// synchronous uploads are the exception: until the last one retired, normal submissions follow it in the background lane
+typedef enum as_render_lane
+{
+	AS_RENDER_LANE_FRAME		= 0x00, // frame submission, overtakes everything else
+	AS_RENDER_LANE_NORMAL		= 0x01, // default, in submission order
+	AS_RENDER_LANE_BACKGROUND	= 0x02, // uploads, the asynchronous ones are waited on through their futures
+	AS_RENDER_LANE_COUNT		= 0x03
+} as_render_lane;
+
+// identifies one submission, its lane in the high byte and where its command ends in the lane ring below it.
+// the commands of a lane retire in order, so a ticket is retired once the lane ring tail went past it, 0 is no submission
+typedef u64 as_rq_ticket;
+#define AS_RQ_TICKET_LANE_SHIFT 56
+#define AS_RQ_TICKET_MAKE(_lane, _position) (((as_rq_ticket)(_lane) << AS_RQ_TICKET_LANE_SHIFT) | (as_rq_ticket)(_position))
+#define AS_RQ_TICKET_GET_LANE(_ticket) ((as_render_lane)((_ticket) >> AS_RQ_TICKET_LANE_SHIFT))
+#define AS_RQ_TICKET_GET_POSITION(_ticket) ((i64)((_ticket) & ((1ull << AS_RQ_TICKET_LANE_SHIFT) - 1)))
+
+// followed in the ring by exactly arg_size bytes of argument, passed to func_ptr
 typedef struct as_render_command
 {
 	void (*func_ptr)(void*);
-	void* arg[AS_RENDER_QUEUE_MAX_ARG_SIZE];
-	u8 executed : 1;
+	as_future* future; // completed with future_result once func_ptr ran, NULL for fire and forget commands
+	void* future_result;
+	void* key_target; // with func_ptr, the key of a coalescing command, NULL for the others
+	u64 arg_size;
+	f64 submit_time;
 } as_render_command;
-AS_STATIC_ARRAY_DECLARE(as_render_commands, AS_RENDER_QUEUE_SIZE, as_render_command);
+#define AS_RENDER_COMMAND_GET_ARG(_command) ((void*)((as_render_command*)(_command) + 1))
+
+// pending commands of one key, the queue thread skips a keyed command while a newer one of its key is pending
+typedef struct as_render_command_key
+{
+	void (*func_ptr)(void*); // NULL for an empty slot
+	void* target;
+	u32 pending_count;
+} as_render_command_key;
+
+// timings of one command function, in nanoseconds
+typedef struct as_rq_command_stats
+{
+	void (*func_ptr)(void*); // NULL for an empty slot
+	as_histogram execution_time;
+	as_histogram latency; // from the submission to the start of the execution
+} as_rq_command_stats;
+
+typedef struct as_rq_stats
+{
+	as_rq_command_stats commands[AS_RENDER_QUEUE_STATS_COMMANDS_SIZE]; // open addressing on func_ptr, only the queue thread adds
+	as_histogram queue_depth; // commands pending in all the lanes, sampled at each submission
+	as_histogram producer_wait; // nanoseconds a producer blocked on the queue to drain, to have room or to retire a ticket
+	f64 log_period;
+	f64 last_log_time;
+} as_rq_stats;
+
+typedef enum as_rq_replay_timing
+{
+	AS_RQ_REPLAY_TIMING_NONE		= 0x00, // submits as fast as the queue takes them, to measure its throughput
+	AS_RQ_REPLAY_TIMING_RECORDED	= 0x01, // keeps the captured gaps between the submissions
+} as_rq_replay_timing;
+
+typedef struct as_rq_replay_result
+{
+	sz command_count; // submitted again
+	sz skipped_count; // destroying commands and commands without a name
+	sz binding_count; // textures, shaders, shapes, objects and screen objects made for the replay
+	f64 duration; // seconds from the first submission until the queue drained
+} as_rq_replay_result;
+
+// a pointer met in a captured argument and the id written in its place, the textures, shaders and objects
+// also keep their handle so an address reused by a new one gets a new id
+typedef struct as_rq_capture_binding
+{
+	const void* ptr; // NULL for an empty slot
+	u32 kind;
+	u32 id;
+	as_handle handle;
+} as_rq_capture_binding;
+AS_VECTOR_DECLARE(as_rq_capture_bindings, as_rq_capture_binding); // open addressing on (ptr, kind), capacity is a power of two
+AS_VECTOR_DECLARE(as_rq_capture_bytes, u8);
 
 typedef struct as_render_queue
 {
 	bool is_running;
 	as_thread thread;
-	as_render_commands commands;
+	as_mpsc_byte_ring lanes[AS_RENDER_LANE_COUNT]; // any thread submits, the queue thread consumes
+	volatile i64 submitted_counts[AS_RENDER_LANE_COUNT];
+	volatile i64 executed_counts[AS_RENDER_LANE_COUNT];
+	f64 background_time; // spent on background commands since the last frame command
+	f64 last_frame_time;
+	// futex words, the queue thread sleeps on work_epoch and producers waiting for it sleep on progress_epoch
+	u32 work_epoch;
+	u32 progress_epoch;
+	volatile i64 is_consumer_sleeping;
+	volatile i64 drain_waiters; // in as_rq_wait_queue and as_rq_wait_lane, woken when a lane runs empty
+	volatile i64 room_waiters; // on a full ring, woken when a command was consumed
+	volatile i64 ticket_waiters; // in as_rq_wait_ticket, woken when a command was consumed
+	volatile i64 follow_ticket; // last synchronous upload or normal submission sent after one, in the background lane
+	as_render_command_key keys[AS_RENDER_QUEUE_KEYS_SIZE]; // open addressing on (func_ptr, target)
+	u32 key_count;
+	as_spinlock keys_lock;
+	volatile i64 coalesced_count; // keyed commands skipped since a newer one replaced them
+	as_rq_stats stats;
+	FILE* capture_file; // NULL when not capturing
+	as_mutex capture_mutex;
+	f64 capture_start_time;
+	sz capture_count;
+	as_rq_capture_bindings capture_bindings; // the ids written so far, capture_mutex held
+	u32 capture_binding_count;
+	as_rq_capture_bytes capture_bytes; // records being written, one met while writing another is appended, written first and cut off
 	as_render* render;
 	AS_DECLARE_TYPE;
 } as_render_queue;
@@ -32,25 +144,70 @@ typedef struct as_render_queue
 extern as_render_queue* as_rq_create(as_render* render);
 extern void as_rq_destroy(as_render_queue* render_queue);
 extern sz as_rq_get_queue_size(as_render_queue* render_queue);
+extern sz as_rq_get_lane_size(as_render_queue* render_queue, const as_render_lane lane);
 extern void as_rq_wait_queue(as_render_queue* render_queue);
-extern void as_rq_submit(as_render_queue* render_queue, void func_ptr(void*), void* arg, const u64 arg_size);
+extern void as_rq_wait_lane(as_render_queue* render_queue, const as_render_lane lane);
+// the returned ticket is 0 if the command was dropped
+extern as_rq_ticket as_rq_submit(as_render_queue* render_queue, void func_ptr(void*), void* arg, const u64 arg_size);
+extern as_rq_ticket as_rq_submit_to_lane(as_render_queue* render_queue, const as_render_lane lane, void func_ptr(void*), void* arg, const u64 arg_size);
+// ticket of the latest submission to the lane, waiting on it covers everything submitted to the lane so far
+extern as_rq_ticket as_rq_get_last_ticket(as_render_queue* render_queue, const as_render_lane lane);
+extern b8 as_rq_is_ticket_retired(as_render_queue* render_queue, const as_rq_ticket ticket);
+// false if the ticket did not retire in time
+extern b8 as_rq_wait_ticket(as_render_queue* render_queue, const as_rq_ticket ticket);
+// replaces the pending command with the same func_ptr and key_target, for idempotent work on one target (rebuilds, uploads).
+// no ticket since a replaced command retires before the one doing its work, wait on a later ticket of the normal lane instead
+extern void as_rq_submit_keyed(as_render_queue* render_queue, void func_ptr(void*), void* key_target, void* arg, const u64 arg_size);
+extern sz as_rq_get_coalesced_count(as_render_queue* render_queue);
+// the returned future completes with result after func_ptr ran on the render thread (with NULL if the command was dropped), release it when done
+extern as_future* as_rq_submit_async(as_render_queue* render_queue, void func_ptr(void*), void* arg, const u64 arg_size, void* result);
+extern as_future* as_rq_submit_async_to_lane(as_render_queue* render_queue, const as_render_lane lane, void func_ptr(void*), void* arg, const u64 arg_size, void* result);
+
+// the histograms are recorded while the queue runs, read them with as_histogram_summarize
+extern as_rq_stats* as_rq_get_stats(as_render_queue* render_queue);
+extern as_rq_command_stats* as_rq_get_command_stats(as_render_queue* render_queue, void func_ptr(void*)); // NULL until one of them ran
+extern const char* as_rq_get_command_name(void func_ptr(void*)); // for the commands submitted by this file, NULL for the others
+extern void as_rq_reset_stats(as_render_queue* render_queue);
+extern void as_rq_set_stats_log_period(as_render_queue* render_queue, const f64 seconds); // 0 stops the periodic log
+extern void as_rq_log_stats(as_render_queue* render_queue);
+extern b8 as_rq_dump_stats(as_render_queue* render_queue, const char* path, const as_memory_dump_format format);
+
+// writes every submitted command to path with its time since the capture started and its argument, the pointers of the
+// argument written as ids. the first command using an id is preceded by what the id stands for: a texture by its path,
+// a shader by its paths and textures, a shape by its vertices, an object by its shape, shader and transform...
+// cameras, snapshots and uniforms are written by value with each command. see as_rq_replay
+extern b8 as_rq_capture_start(as_render_queue* render_queue, const char* path);
+extern void as_rq_capture_stop(as_render_queue* render_queue);
+// submits a capture again on the render of the queue, from any run, and waits for it. the textures, shaders, shapes,
+// objects and screen objects of the capture are made again for the replay (uploaded first when they already were when
+// the capture met them) in one scene and one screen objects group, and destroyed once it is done.
+// display_context is the one of the render, NULL for a headless render. commands destroying objects are skipped
+extern as_rq_replay_result as_rq_replay(as_render_queue* render_queue, void* display_context, const char* path, const as_rq_replay_timing timing);
 
 extern void as_rq_render_start_draw_loop(as_render_queue* render_queue, as_render* render);
 extern void as_rq_render_end_draw_loop(as_render_queue* render_queue, as_render* render);
-extern void as_rq_render_draw_frame(as_render_queue* render_queue, as_render* render, void* display_context, as_camera* camera, as_scene* scene, as_screen_objects_group* ui_objects_group);
+extern as_rq_ticket as_rq_render_draw_frame(as_render_queue* render_queue, as_render* render, void* display_context, as_camera* camera, as_scene* scene, as_screen_objects_group* ui_objects_group);
+// the snapshot must stay untouched until the returned future completes, it completes with the snapshot
+extern as_future* as_rq_render_draw_frame_snapshot(as_render_queue* render_queue, as_render* render, void* display_context, as_scene* scene, as_screen_objects_group* ui_objects_group, const as_render_snapshot* snapshot);
 extern void as_rq_render_destroy(as_render_queue* render_queue, as_render* render);
 
 extern void as_rq_screen_object_update(as_render_queue* render_queue, as_screen_object* screen_object);
 extern void as_rq_screen_object_recompile(as_render_queue* render_queue, as_screen_object* screen_object);
 
+// background lane, what the caller submits next to the normal lane runs after it (see follow_ticket)
 extern void as_rq_texture_update(as_render_queue* render_queue, as_texture* texture, as_render* render);
+extern as_future* as_rq_texture_update_async(as_render_queue* render_queue, as_texture* texture, as_render* render);
 extern void as_rq_texture_destroy(as_render_queue* render_queue, as_texture* texture);
 
 extern void as_rq_shader_set_uniforms(as_render_queue* render_queue, as_render* render, as_shader* shader, as_shader_uniforms* uniforms);
 extern void as_rq_shader_update(as_render_queue* render_queue, as_render* render, as_shader* shader);
+extern as_future* as_rq_shader_update_async(as_render_queue* render_queue, as_render* render, as_shader* shader);
 extern void as_rq_shader_recompile(as_render_queue* render_queue, as_shader* shader);
 extern void as_rq_shader_destroy(as_render_queue* render_queue, as_render* render, as_shader* shader);
 
+// background lane, like as_rq_texture_update
 extern void as_rq_object_update(as_render_queue* render_queue, as_render* render, as_object* object, struct as_shape* shape, as_shader* shader);
+extern as_future* as_rq_object_update_async(as_render_queue* render_queue, as_render* render, as_object* object, struct as_shape* shape, as_shader* shader);
+extern void as_rq_object_remove(as_render_queue* render_queue, as_render* render, as_scene* scene, as_object* object);
 
 extern void as_rq_scene_destroy(as_render_queue* render_queue, as_render* render, as_scene* scene);
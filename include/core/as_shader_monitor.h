@@ -24,6 +24,7 @@ AS_STATIC_ARRAY_DECLARE(as_shader_monitor_threads_256, 256, as_shader_monitor_th
 typedef struct as_shader_monitor
 {
 	as_shader_monitor_threads_256 threads;
+	as_string_map shaders_by_files; // as_shader*, keyed by vertex and fragment file names
 
 	as_mutex mutex;
 	bool is_running;
@@ -2,6 +2,7 @@
 
 #include "as_types.h"
 #include "as_math.h"
+#include "as_memory.h"
 
 #define AS_MAX_VERTICES_SIZE 2048
 #define AS_MAX_INDICES_SIZE 2048
@@ -37,6 +38,8 @@ extern const i32 as_shape_quad_vertices_size;
 extern const u16 as_shape_quad_indices[];
 extern const i32 as_shape_quad_indices_size;
 
+extern as_slab as_shapes_slab;
+
 extern as_shape as_generate_triangle();
 extern as_shape as_generate_quad();
 extern as_shape* as_generate_cube();
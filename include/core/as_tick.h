@@ -14,11 +14,11 @@ typedef struct as_tick_handle
     f32 tick_rate; // unused yet    
 } as_tick_handle;
 
-AS_ARRAY_DECLARE(as_tick_handles_1024, 1024, as_tick_handle);
+AS_VECTOR_DECLARE(as_tick_handles, as_tick_handle);
 
 typedef struct as_tick_system
 {
-    as_tick_handles_1024 handles;
+    as_tick_handles handles;
     AS_DECLARE_TYPE;
 }as_tick_system;
 
@@ -8,6 +8,8 @@
 #define AS_ENGINE_WINDOW_WIDTH 1900
 #define AS_ENGINE_WINDOW_HEIGHT 1080
 #define AS_ENGINE_WINDOW_NAME "Abstract Shader Engine"
+#define AS_ENGINE_HEADLESS 0 // renders offscreen at the window size without glfw, for ci and gpu-less benchmarks
+#define AS_ENGINE_HEADLESS_FRAMES 1000 // frames as_engine_should_loop allows when headless, 0 for no limit
 
 // PATH
 #define AS_PATH_BIN "./"
@@ -29,10 +31,14 @@
 #define AS_PATH_DEFAULT_UI_TEXT_FRAG_SHADER "../resources/shaders/core_2d/default_ui_text_fragment.glsl"
 #define AS_PATH_DEFAULT_UI_TEXT_TEXTURE "../resources/textures/otaviogood_font.png"
 
+// Memory
+#define AS_MEMORY_STRICT_FRAMES 0 // warn about every call site allocating once the warm-up is over
+#define AS_MEMORY_WARMUP_FRAMES 300
+#define AS_MEMORY_MAX_LOGGED_OFFENDERS 16
+
 // Render
-#define AS_MAX_SCENE_OBJECTS 1024
 #define AS_MAX_SCENE_LIGHTS 128
 #define AS_MAX_SCENE_CAMERAS 128
 #define AS_MAX_SCREEN_OBJECTS 128
-#define AS_MAX_TEXTURE_POOL_SIZE 512
 #define AS_MAX_SHADER_UNIFORMS_SIZE 32
+#define AS_ENGINE_FRAME_LATENCY 0 // frames the render thread may run behind the game thread (up to 2), 0 waits for each frame
@@ -6,7 +6,10 @@
 
 i32 main()
 {
-	as_engine_init();
+	if (!as_engine_init())
+	{
+		return 1;
+	}
 
 #if AS_EDITOR
 	as_editor_set_default_scene();
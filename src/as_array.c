@@ -0,0 +1,140 @@
+// Abstract Shader Engine - Jed Fakhfekh - https://github.com/ougi-washi
+
+#include "as_array.h"
+#include "as_memory.h"
+#include <string.h>
+
+b8 as_vector_reserve_fn(void** data, sz* capacity, const sz element_size, const sz min_capacity)
+{
+	AS_ASSERT((data && capacity), "Trying to reserve vector, but vector is NULL");
+	if (min_capacity <= *capacity) { return true; }
+
+	sz new_capacity = *capacity > 0 ? *capacity * 2 : AS_VECTOR_MIN_CAPACITY;
+	if (new_capacity < min_capacity) { new_capacity = min_capacity; }
+
+	void* new_data = AS_REALLOC(*data, new_capacity * element_size);
+	if (!new_data)
+	{
+		AS_FLOG(LV_ERROR, "Could not grow vector to %zu elements", new_capacity);
+		return false;
+	}
+	*data = new_data;
+	*capacity = new_capacity;
+	return true;
+}
+
+void as_vector_shrink_fn(void** data, sz* capacity, const sz element_size, const sz size)
+{
+	AS_ASSERT((data && capacity), "Trying to shrink vector, but vector is NULL");
+	if (size == *capacity) { return; }
+	if (size == 0)
+	{
+		AS_FREE(*data);
+		*data = NULL;
+		*capacity = 0;
+		return;
+	}
+
+	void* new_data = AS_REALLOC(*data, size * element_size);
+	if (!new_data) { return; } // keeping the bigger buffer is still valid
+	*data = new_data;
+	*capacity = size;
+}
+
+void as_vector_free_fn(void** data, sz* size, sz* capacity)
+{
+	AS_ASSERT((data && size && capacity), "Trying to free vector, but vector is NULL");
+	if (*data) { AS_FREE(*data); }
+	*data = NULL;
+	*size = 0;
+	*capacity = 0;
+}
+
+b8 as_vector_out_of_bounds_fn(const sz index, const sz size, const char* file, const u32 line)
+{
+	AS_FLOG(LV_ERROR, "Vector index %zu out of bounds (size %zu) at %s:%u", index, size, file, line);
+	return false;
+}
+
+#define AS_BYTE_RING_PADDING_PAYLOAD ((u32)-1)
+
+b8 as_mpsc_byte_ring_init(as_mpsc_byte_ring* ring, const sz capacity)
+{
+	AS_ASSERT(ring, "Trying to init byte ring, but ring is NULL");
+	AS_WARNING_RETURN_VAL_IF_FALSE(((capacity & (capacity - 1)) == 0 && capacity >= AS_BYTE_RING_ALIGNMENT), false, "Byte ring capacity has to be a power of two");
+	memset(ring, 0, sizeof(as_mpsc_byte_ring));
+	ring->data = (u8*)AS_MALLOC_WITH_TYPE(capacity, "as_mpsc_byte_ring");
+	ring->capacity = capacity;
+	return ring->data != NULL;
+}
+
+void as_mpsc_byte_ring_destroy(as_mpsc_byte_ring* ring)
+{
+	AS_ASSERT(ring, "Trying to destroy byte ring, but ring is NULL");
+	if (ring->data) { AS_FREE(ring->data); }
+	memset(ring, 0, sizeof(as_mpsc_byte_ring));
+}
+
+void* as_mpsc_byte_ring_reserve(as_mpsc_byte_ring* ring, const sz payload_size, i64* out_end_position)
+{
+	const sz packet_size = AS_BYTE_RING_ALIGN(sizeof(as_byte_ring_packet) + payload_size);
+	AS_WARNING_RETURN_VAL_IF_FALSE((packet_size <= ring->capacity / 2), NULL, "Byte ring packet does not fit, make the ring bigger");
+
+	i64 head = AS_ATOMIC_LOAD_ACQUIRE_I64(&ring->head);
+	sz to_end = 0;
+	for (;;)
+	{
+		to_end = ring->capacity - (sz)(head & (i64)(ring->capacity - 1));
+		const sz claimed_size = packet_size <= to_end ? packet_size : to_end + packet_size;
+		const i64 tail = AS_ATOMIC_LOAD_ACQUIRE_I64(&ring->tail);
+		if ((sz)(head - tail) + claimed_size > ring->capacity) { return NULL; }
+		if (AS_ATOMIC_CAS_I64(&ring->head, head, head + (i64)claimed_size)) { break; }
+		head = AS_ATOMIC_LOAD_ACQUIRE_I64(&ring->head);
+	}
+
+	if (packet_size > to_end) // the consumer skips the end of the buffer and finds the packet at the start
+	{
+		as_byte_ring_packet* padding = (as_byte_ring_packet*)&ring->data[head & (i64)(ring->capacity - 1)];
+		padding->size = (u32)to_end;
+		padding->payload_size = AS_BYTE_RING_PADDING_PAYLOAD;
+		AS_ATOMIC_STORE_RELEASE_I64(&padding->is_committed, 1);
+		head += (i64)to_end;
+	}
+	as_byte_ring_packet* packet = (as_byte_ring_packet*)&ring->data[head & (i64)(ring->capacity - 1)];
+	packet->size = (u32)packet_size;
+	packet->payload_size = (u32)payload_size;
+	if (out_end_position) { *out_end_position = head + (i64)packet_size; }
+	return packet + 1;
+}
+
+void as_mpsc_byte_ring_commit(void* payload)
+{
+	AS_ASSERT(payload, "Trying to commit byte ring packet, but payload is NULL");
+	as_byte_ring_packet* packet = (as_byte_ring_packet*)payload - 1;
+	AS_ATOMIC_STORE_RELEASE_I64(&packet->is_committed, 1);
+}
+
+void* as_mpsc_byte_ring_front(as_mpsc_byte_ring* ring, sz* out_payload_size)
+{
+	for (;;)
+	{
+		const i64 tail = ring->tail;
+		as_byte_ring_packet* packet = (as_byte_ring_packet*)&ring->data[tail & (i64)(ring->capacity - 1)];
+		if (AS_ATOMIC_LOAD_ACQUIRE_I64(&packet->is_committed) == 0) { return NULL; }
+		if (packet->payload_size != AS_BYTE_RING_PADDING_PAYLOAD)
+		{
+			if (out_payload_size) { *out_payload_size = packet->payload_size; }
+			return packet + 1;
+		}
+		as_mpsc_byte_ring_pop_front(ring);
+	}
+}
+
+void as_mpsc_byte_ring_pop_front(as_mpsc_byte_ring* ring)
+{
+	const i64 tail = ring->tail;
+	as_byte_ring_packet* packet = (as_byte_ring_packet*)&ring->data[tail & (i64)(ring->capacity - 1)];
+	const u32 size = packet->size;
+	memset(packet, 0, size);
+	AS_ATOMIC_STORE_RELEASE_I64(&ring->tail, tail + (i64)size);
+}
@@ -17,11 +17,23 @@ typedef struct as_engine
 	as_camera* camera;
 	as_scene* scene;
 	as_textures_pool* textures_pool;
+	as_string_map textures_by_path; // packed as_handle of the texture, to not load the same file twice
+	as_mutex textures_by_path_mutex; // textures are created from the game and the console threads
 	as_screen_objects_group* ui_objects_group;
 	as_input_buffer* input_buffer;
 	as_tick_system* tick_system;
+	as_job_system* job_system;
 	as_content* content;
 	as_console* console;
+	as_render_snapshot* snapshots; // AS_RENDER_SNAPSHOTS_COUNT, indexed by frame
+	as_future* frame_futures[AS_RENDER_SNAPSHOTS_COUNT]; // completed once the render thread drew the matching snapshot
+	u64 frame_index;
+	u32 frame_latency;
+	u64 headless_frame_count; // 0 when there is a window or no limit
+	u64 loop_count;
+	f64 frame_start_time; // game thread timing, the render thread keeps its own in as_render
+	f64 delta_time;
+	volatile b8 is_replaying; // set by the console thread, frames are not submitted meanwhile so only the capture is measured
 } as_engine;
 
 static as_engine engine = {0};
@@ -116,40 +128,130 @@ void as_command_create_object(const char* shape_index, const char* shader_index,
 	AS_FLOG(LV_LOG, "Created object asset at %d", content_index);
 }
 
+void as_command_dump_memory(const char* path, const char* extra_0, const char* extra_1)
+{
+	AS_WARNING_RETURN_IF_FALSE(path, "Cannot dump memory stats, invalid path %p", path);
+	const char* extension = strrchr(path, '.');
+	const as_memory_dump_format format = (extension && strcmp(extension, ".csv") == 0) ? AS_MEMORY_DUMP_CSV : AS_MEMORY_DUMP_JSON;
+	if (as_memory_dump_stats(path, format))
+	{
+		AS_FLOG(LV_LOG, "Dumped memory stats to %s", path);
+	}
+}
+
+void as_command_dump_render_queue(const char* path, const char* extra_0, const char* extra_1)
+{
+	AS_WARNING_RETURN_IF_FALSE(path, "Cannot dump render queue stats, invalid path %p", path);
+	const char* extension = strrchr(path, '.');
+	const as_memory_dump_format format = (extension && strcmp(extension, ".csv") == 0) ? AS_MEMORY_DUMP_CSV : AS_MEMORY_DUMP_JSON;
+	if (as_rq_dump_stats(engine.render_queue, path, format))
+	{
+		AS_FLOG(LV_LOG, "Dumped render queue stats to %s", path);
+	}
+}
+
+void as_command_capture_render_queue(const char* path, const char* extra_0, const char* extra_1)
+{
+	AS_WARNING_RETURN_IF_FALSE(path, "Cannot capture render queue, invalid path %p", path);
+	as_rq_capture_start(engine.render_queue, path);
+}
+
+void as_command_stop_render_queue_capture(const char* extra_0, const char* extra_1, const char* extra_2)
+{
+	as_rq_capture_stop(engine.render_queue);
+}
+
+void as_command_replay_render_queue(const char* path, const char* extra_0, const char* extra_1)
+{
+	AS_WARNING_RETURN_IF_FALSE(path, "Cannot replay render queue capture, invalid path %p", path);
+	engine.is_replaying = true;
+	as_rq_replay(engine.render_queue, engine.display_context, path, AS_RQ_REPLAY_TIMING_NONE);
+	engine.is_replaying = false;
+}
+
 // maybe this should be moved to console defines
 void as_engine_init_console()
 {
 	engine.console = as_console_create();
-	as_command_mapping_128* command_mappings = as_console_get_mappings(engine.console);
-
-	AS_ARRAY_PUSH_BACK(*command_mappings, ((as_command_mapping){
+	as_console_add_mapping(engine.console, &((as_command_mapping){
 		"create_texture", 
 		"Loads a texture in the content. Usage example: create_texture /resources/textures/example.png", 
 		as_command_create_texture, 1}));
 
-	AS_ARRAY_PUSH_BACK(*command_mappings, ((as_command_mapping){
+	as_console_add_mapping(engine.console, &((as_command_mapping){
 		"create_shader",
 		"Loads a shader in the content. Usage example: create_shader /resources/shaders/example_vert.png /resources/shaders/example_frag.png",
 		&as_command_create_shader, 2}));
 
-	AS_ARRAY_PUSH_BACK(*command_mappings, ((as_command_mapping){
+	as_console_add_mapping(engine.console, &((as_command_mapping){
 		"create_sphere",
 		"Creates sphere shape from size, latitude_divisions and, longitude_divisions. Usage example: create_sphere 0.6 10 10",
 		& as_command_create_sphere, 3}));
 
-	AS_ARRAY_PUSH_BACK(*command_mappings, ((as_command_mapping){
+	as_console_add_mapping(engine.console, &((as_command_mapping){
 		"create_object",
 		"Loads a object in the content. Usage example, where 5 is the index for the shape and 7 is the index for the shader: create_object 5 7",
 		&as_command_create_object, 2}));
+
+	as_console_add_mapping(engine.console, &((as_command_mapping){
+		"dump_memory",
+		"Writes the per tag memory stats, as csv if the path ends with .csv and json otherwise. Usage example: dump_memory memory.json",
+		&as_command_dump_memory, 1}));
+
+	as_console_add_mapping(engine.console, &((as_command_mapping){
+		"dump_render_queue",
+		"Writes the render queue histograms (command timings, depth, producer waits), as csv if the path ends with .csv and json otherwise. Usage example: dump_render_queue render_queue.json",
+		&as_command_dump_render_queue, 1}));
+
+	as_console_add_mapping(engine.console, &((as_command_mapping){
+		"capture_render_queue",
+		"Writes every render command submitted from now on to a file, until stop_render_queue_capture, with the textures, shaders, shapes and objects it uses. Usage example: capture_render_queue render_queue.cap",
+		&as_command_capture_render_queue, 1}));
+
+	as_console_add_mapping(engine.console, &((as_command_mapping){
+		"stop_render_queue_capture",
+		"Closes the file of capture_render_queue. Usage example: stop_render_queue_capture",
+		&as_command_stop_render_queue_capture, 0}));
+
+	as_console_add_mapping(engine.console, &((as_command_mapping){
+		"replay_render_queue",
+		"Makes the objects of a render queue capture again, submits its commands as fast as possible and logs the throughput. Usage example: replay_render_queue render_queue.cap",
+		&as_command_replay_render_queue, 1}));
 }
 
-void as_engine_init()
+// leaves at most frame_latency frames to the render thread, their snapshots are the only ones still in use
+static void as_engine_wait_frames(const u32 frame_latency)
 {
-	AS_LOG(LV_LOG, "Initializing the engine");
+	for (u64 frame = engine.frame_index > AS_RENDER_SNAPSHOTS_COUNT ? engine.frame_index - AS_RENDER_SNAPSHOTS_COUNT : 0; frame + frame_latency < engine.frame_index; frame++)
+	{
+		as_future** frame_future = &engine.frame_futures[frame % AS_RENDER_SNAPSHOTS_COUNT];
+		if (!*frame_future) { continue; }
+		as_future_wait(*frame_future, -1.);
+		as_future_release(*frame_future);
+		*frame_future = NULL;
+	}
+}
 
-	//as_shader_binary_pool_create();
-	engine.display_context = as_display_context_create(AS_ENGINE_WINDOW_WIDTH, AS_ENGINE_WINDOW_HEIGHT, AS_ENGINE_WINDOW_NAME, &key_callback);
-	engine.render = as_render_create(engine.display_context);
+// display_context is NULL for headless engines
+static b8 as_engine_init_with_render(void* display_context, as_render* render)
+{
+	if (!render || AS_IS_INVALID(render))
+	{
+		AS_LOG(LV_ERROR, "Could not create the render, the engine is not initialized");
+		if (display_context)
+		{
+			as_display_context_destroy(display_context);
+			as_display_context_terminate();
+		}
+		as_job_system_destroy(engine.job_system);
+		engine.job_system = NULL;
+		return false;
+	}
+
+	engine.display_context = display_context;
+	engine.render = render;
+	as_mutex_init(&engine.textures_by_path_mutex);
+	engine.frame_start_time = get_monotonic_time();
 	engine.render_queue = as_rq_create(engine.render);
 	engine.shader_monitor = as_shader_monitor_create(&engine.render->frame_counter, engine.render_queue);
 	engine.input_buffer = as_input_create();
@@ -157,9 +259,35 @@ void as_engine_init()
 	engine.content = as_content_create();
 	engine.ui_objects_group = as_screen_objects_group_create();
 	engine.textures_pool = as_textures_pool_create();
+	engine.snapshots = (as_render_snapshot*)AS_MALLOC_WITH_TYPE(sizeof(as_render_snapshot) * AS_RENDER_SNAPSHOTS_COUNT, "as_render_snapshot");
+	as_engine_set_frame_latency(AS_ENGINE_FRAME_LATENCY);
 	as_engine_init_console();
+	return true;
+}
+
+b8 as_engine_init()
+{
+#if AS_ENGINE_HEADLESS
+	return as_engine_init_headless(AS_ENGINE_WINDOW_WIDTH, AS_ENGINE_WINDOW_HEIGHT, AS_ENGINE_HEADLESS_FRAMES, NULL, NULL);
+#else
+	AS_LOG(LV_LOG, "Initializing the engine");
 
-	while (AS_IS_INVALID(engine.render)) {};
+	//as_shader_binary_pool_create();
+	as_memory_set_strict_mode(AS_MEMORY_STRICT_FRAMES, AS_MEMORY_WARMUP_FRAMES);
+	engine.job_system = as_job_system_create(0);
+	void* display_context = as_display_context_create(AS_ENGINE_WINDOW_WIDTH, AS_ENGINE_WINDOW_HEIGHT, AS_ENGINE_WINDOW_NAME, &key_callback);
+	return as_engine_init_with_render(display_context, as_render_create(display_context));
+#endif
+}
+
+b8 as_engine_init_headless(const u32 width, const u32 height, const u64 frame_count, as_render_readback_func readback_func, void* readback_user_data)
+{
+	AS_FLOG(LV_LOG, "Initializing the engine headless, %ux%u", width, height);
+
+	as_memory_set_strict_mode(AS_MEMORY_STRICT_FRAMES, AS_MEMORY_WARMUP_FRAMES);
+	engine.job_system = as_job_system_create(0);
+	engine.headless_frame_count = frame_count;
+	return as_engine_init_with_render(NULL, as_render_create_headless(width, height, readback_func, readback_user_data));
 }
 
 void as_engine_clear()
@@ -171,42 +299,123 @@ void as_engine_clear()
 	as_shader_monitored_destroy(engine.shader_monitor);
 	as_content_destroy(engine.content);
 	as_rq_destroy(engine.render_queue);
+	as_engine_wait_frames(0);
+	AS_FREE(engine.snapshots);
 
 	as_tick_system_destroy(engine.tick_system);
 	as_scene_destroy(engine.render, engine.scene);
 	as_textures_pool_destroy(engine.textures_pool);
+	as_string_map_destroy(&engine.textures_by_path);
+	as_mutex_destroy(&engine.textures_by_path_mutex);
 	as_render_destroy(engine.render);
 
-	as_display_context_destroy(engine.display_context);
-	as_display_context_terminate();
+	if (engine.display_context)
+	{
+		as_display_context_destroy(engine.display_context);
+		as_display_context_terminate();
+	}
 
 	as_console_destroy(engine.console);
+	as_job_system_destroy(engine.job_system);
+	as_arena_destroy_frame();
+
+	as_slab_log_stats(&as_objects_slab);
+	as_slab_log_stats(&as_shapes_slab);
+	as_slab_log_stats(&as_shaders_slab);
+	as_slab_log_stats(&as_textures_slab);
+	as_slab_log_stats(&as_futures_slab);
+	as_handle_table_destroy(&as_shaders_table);
+	as_handle_table_destroy(&as_textures_table);
+	as_slab_destroy(&as_objects_slab);
+	as_slab_destroy(&as_shapes_slab);
+	as_slab_destroy(&as_shaders_slab);
+	as_slab_destroy(&as_textures_slab);
+	as_slab_destroy(&as_futures_slab);
+
+	as_memory_log_frame_offenders(AS_MEMORY_MAX_LOGGED_OFFENDERS);
 
 	AS_LOG_MEMORY();
 }
 
 bool as_engine_should_loop()
 {
-	bool should_loop = !as_display_context_should_close(engine.display_context);
-	as_input_loop_tick();
-	as_display_context_poll_event();
-	as_rq_render_start_draw_loop(engine.render_queue, engine.render);
+	bool should_loop = true;
+	if (engine.display_context)
+	{
+		should_loop = !as_display_context_should_close(engine.display_context);
+		as_input_loop_tick();
+		as_display_context_poll_event();
+	}
+	else if (engine.headless_frame_count > 0)
+	{
+		should_loop = engine.loop_count < engine.headless_frame_count;
+	}
+	engine.loop_count++;
 	as_tick_system_execute(engine.tick_system, as_get_delta_time());
 	return should_loop;
 }
 
+// paces the game thread and measures its delta time, only this thread touches these
+static void as_engine_end_frame()
+{
+	const f64 remaining_time = (1. / AS_TARGET_FPS) - (get_monotonic_time() - engine.frame_start_time);
+	if (remaining_time > 0 && !engine.render->is_headless) // headless runs are benchmarks or offline renders
+	{
+		sleep_seconds(remaining_time);
+	}
+	const f64 current_time = get_monotonic_time();
+	engine.delta_time = current_time - engine.frame_start_time;
+	engine.frame_start_time = current_time;
+	as_memory_end_frame();
+}
+
 void as_engine_draw()
 {
 	if (!engine.scene)
 	{
 		engine.scene = as_scene_create(engine.render, AS_PATH_DEFAULT_SCENE);
 	}
-	if (engine.camera)
+	if (engine.is_replaying)
 	{
-		as_rq_render_draw_frame(engine.render_queue, engine.render, engine.display_context, engine.camera, engine.scene, engine.ui_objects_group);
+		as_engine_end_frame();
+		return;
 	}
-	as_rq_wait_queue(engine.render_queue);
-	as_render_end_draw_loop(engine.render);
+	if (engine.frame_latency == 0)
+	{
+		// only what was submitted before the frame, work queued meanwhile by loading threads does not hold it back.
+		// uploads and what follows them are in the background lane, a burst of loads does not hold it back either
+		const as_rq_ticket upload_ticket = as_rq_get_last_ticket(engine.render_queue, AS_RENDER_LANE_NORMAL);
+		if (engine.camera)
+		{
+			as_rq_wait_ticket(engine.render_queue, as_rq_render_draw_frame(engine.render_queue, engine.render, engine.display_context, engine.camera, engine.scene, engine.ui_objects_group));
+		}
+		as_rq_wait_ticket(engine.render_queue, upload_ticket);
+	}
+	else if (engine.camera)
+	{
+		// the slot of this frame was last used AS_RENDER_SNAPSHOTS_COUNT frames ago, that frame is done after the wait
+		as_engine_wait_frames(engine.frame_latency - 1);
+		as_render_snapshot* snapshot = &engine.snapshots[engine.frame_index % AS_RENDER_SNAPSHOTS_COUNT];
+		as_render_snapshot_capture(snapshot, engine.camera, engine.scene, engine.ui_objects_group);
+		snapshot->frame_index = engine.frame_index;
+		engine.frame_futures[engine.frame_index % AS_RENDER_SNAPSHOTS_COUNT] = as_rq_render_draw_frame_snapshot(engine.render_queue, engine.render, engine.display_context, engine.scene, engine.ui_objects_group, snapshot);
+		engine.frame_index++;
+	}
+	as_engine_end_frame();
+}
+
+void as_engine_set_frame_latency(const u32 frame_latency)
+{
+	if (frame_latency > AS_RENDER_MAX_FRAME_LATENCY)
+	{
+		AS_FLOG(LV_WARNING, "Frame latency %u is too high, using %d", frame_latency, AS_RENDER_MAX_FRAME_LATENCY);
+	}
+	engine.frame_latency = frame_latency > AS_RENDER_MAX_FRAME_LATENCY ? AS_RENDER_MAX_FRAME_LATENCY : frame_latency;
+}
+
+u32 as_engine_get_frame_latency()
+{
+	return engine.frame_latency;
 }
 
 void as_engine_set_scene(as_scene* scene)
@@ -223,6 +432,16 @@ as_render* as_engine_get_render()
 	return engine.render;	
 }
 
+as_render_queue* as_engine_get_render_queue()
+{
+	return engine.render_queue;
+}
+
+as_job_system* as_engine_get_job_system()
+{
+	return engine.job_system;
+}
+
 as_content* as_engine_get_content()
 {
 	return engine.content;
@@ -230,6 +449,7 @@ as_content* as_engine_get_content()
 
 void as_engine_reset_scene()
 {
+	as_engine_wait_frames(0); // the snapshots in flight point to the objects of the scene
 	AS_WAIT_AND_LOCK(engine.render);
 	as_scene_destroy(engine.render, engine.scene);
 	engine.scene = as_scene_create(engine.render, AS_PATH_DEFAULT_SCENE);
@@ -243,17 +463,61 @@ f64 as_get_time()
 
 f64 as_get_delta_time()
 {
-	return as_render_get_delta_time(engine.render);
+	return engine.delta_time;
+}
+
+// the map holds the handle and not the pointer, a destroyed texture then stops resolving instead of being read after its release
+// both as_handle fields fit in the 64 bits of the map value
+static void* as_texture_handle_to_map_value(const as_handle handle)
+{
+	return (void*)(uintptr_t)(((u64)handle.generation << 32) | handle.index);
+}
+
+static as_handle as_texture_handle_from_map_value(void* value)
+{
+	const u64 packed = (u64)(uintptr_t)value;
+	return (as_handle){ .index = (u32)packed, .generation = (u32)(packed >> 32) };
+}
+
+// returns the texture already loaded from texture_path, or a new one that is_created tells the caller to upload, NULL when out of memory
+static as_texture* as_texture_find_or_add(const char* texture_path, b8* is_created)
+{
+	as_mutex_lock(&engine.textures_by_path_mutex);
+	const as_handle found_handle = as_texture_handle_from_map_value(as_string_map_get(&engine.textures_by_path, texture_path));
+	as_texture* texture = AS_HANDLE_IS_NULL(found_handle) ? NULL : as_texture_get(engine.textures_pool, found_handle);
+	*is_created = false;
+	if (!texture)
+	{
+		texture = as_texture_get_from_pool(engine.textures_pool);
+		if (texture)
+		{
+			as_texture_init(texture, texture_path);
+			as_string_map_set(&engine.textures_by_path, texture_path, as_texture_handle_to_map_value(texture->handle));
+			*is_created = true;
+		}
+	}
+	as_mutex_unlock(&engine.textures_by_path_mutex);
+	return texture;
 }
 
 as_texture* as_texture_create(const char* texture_path)
 {
-	as_texture* texture = as_texture_get_from_pool(engine.textures_pool);
-	as_texture_init(texture, texture_path);
-	as_rq_texture_update(engine.render_queue, texture, engine.render);
+	b8 is_created = false;
+	as_texture* texture = as_texture_find_or_add(texture_path, &is_created);
+	if (is_created)
+	{
+		as_rq_texture_update(engine.render_queue, texture, engine.render);
+	}
 	return texture;
 }
 
+as_future* as_texture_create_async(const char* texture_path)
+{
+	b8 is_created = false;
+	as_texture* texture = as_texture_find_or_add(texture_path, &is_created);
+	return is_created ? as_rq_texture_update_async(engine.render_queue, texture, engine.render) : as_future_create_ready(texture);
+}
+
 as_shader* as_shader_create(const char* vertex_shader_path, const char* fragment_shader_path)
 {
 	as_shader* found_shader = as_shader_monitor_find_shader(engine.shader_monitor, vertex_shader_path, fragment_shader_path);
@@ -268,6 +532,19 @@ as_shader* as_shader_create(const char* vertex_shader_path, const char* fragment
 	return shader;
 }
 
+as_future* as_shader_create_async(const char* vertex_shader_path, const char* fragment_shader_path)
+{
+	as_shader* found_shader = as_shader_monitor_find_shader(engine.shader_monitor, vertex_shader_path, fragment_shader_path);
+	if (found_shader)
+	{
+		return as_future_create_ready(found_shader);
+	}
+	as_shader* shader = as_shader_make(engine.render, vertex_shader_path, fragment_shader_path);
+	as_shader_monitor_add(&engine.render->frame_counter, engine.shader_monitor, shader, shader->filename_vertex, as_rq_shader_recompile);
+	as_shader_monitor_add(&engine.render->frame_counter, engine.shader_monitor, shader, shader->filename_fragment, as_rq_shader_recompile);
+	return as_rq_shader_update_async(engine.render_queue, engine.render, shader);
+}
+
 as_object* as_object_create(as_shape* shape, as_shader* shader)
 {
 	AS_ASSERT(shader, "Trying create object, but shader is NULL");
@@ -276,6 +553,13 @@ as_object* as_object_create(as_shape* shape, as_shader* shader)
 	return object;
 }
 
+as_future* as_object_create_async(as_shape* shape, as_shader* shader)
+{
+	AS_ASSERT(shader, "Trying create object, but shader is NULL");
+	as_object* object = as_object_consturct(engine.render, engine.scene);
+	return as_rq_object_update_async(engine.render_queue, engine.render, object, shape, shader);
+}
+
 as_object* as_object_create_with_tick(as_shape* shape, as_shader* shader, void tick_func_ptr(as_object*, const f64))
 {
 	AS_ASSERT(tick_func_ptr, "Cannot create ticking object, invalid function ptr");
@@ -286,6 +570,12 @@ as_object* as_object_create_with_tick(as_shape* shape, as_shader* shader, void t
 	return object;
 }
 
+void as_object_delete(as_object* object)
+{
+	AS_WARNING_RETURN_IF_FALSE(object, "Cannot delete object, invalid object");
+	as_rq_object_remove(engine.render_queue, engine.render, engine.scene, object);
+}
+
 as_camera* as_camera_create(const as_vec3* position, const as_vec3* target)
 {
 	return as_camera_make(engine.scene, position, target);
@@ -388,7 +678,7 @@ void as_input_loop_tick()
 				return;
 			}
 			scene_being_saved = true;
-			as_serialized_scene* serialized_scene = AS_MALLOC_SINGLE(as_serialized_scene);
+			as_serialized_scene* serialized_scene = AS_MALLOC_SINGLE_TAGGED(as_serialized_scene, AS_MEMORY_TAG_IO);
 			as_serialize_scene(engine.scene, serialized_scene);
 			AS_SERIALIZE_TO_FILE(as_serialized_scene, serialized_scene, AS_PATH_DEFAULT_SCENE);
 			// writing to the file is still being processed and we try to delete, this has to be delayed or something
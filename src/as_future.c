@@ -0,0 +1,113 @@
+// Abstract Shader Engine - Jed Fakhfekh - https://github.com/ougi-washi
+
+#include "as_future.h"
+#include "as_memory.h"
+#include "as_utility.h"
+#include <string.h>
+
+as_slab as_futures_slab = AS_SLAB_INITIALIZER(as_future, AS_MEMORY_TAG_QUEUE);
+
+as_future* as_future_create()
+{
+	as_future* future = AS_SLAB_ALLOC_SINGLE(&as_futures_slab, as_future);
+	memset(future, 0, sizeof(as_future)); // slab items keep their old content
+	future->ref_count = 1;
+	return future;
+}
+
+as_future* as_future_create_ready(void* result)
+{
+	as_future* future = as_future_create();
+	as_future_complete(future, result);
+	return future;
+}
+
+void as_future_retain(as_future* future)
+{
+	AS_ASSERT(future, "Cannot retain future, invalid future");
+	AS_ATOMIC_ADD_I64(&future->ref_count, 1);
+}
+
+void as_future_release(as_future* future)
+{
+	if (!future) { return; }
+	if (AS_ATOMIC_ADD_I64(&future->ref_count, -1) == 1)
+	{
+		as_slab_free(&as_futures_slab, future);
+	}
+}
+
+void as_future_complete(as_future* future, void* result)
+{
+	AS_ASSERT(future, "Cannot complete future, invalid future");
+	as_spinlock_lock(&future->continuations_lock);
+	if (future->state != AS_FUTURE_PENDING)
+	{
+		as_spinlock_unlock(&future->continuations_lock);
+		AS_FLOG(LV_WARNING, "Future %p completed twice", future);
+		return;
+	}
+	future->result = result;
+	AS_ATOMIC_EXCHANGE_I32(&future->state, AS_FUTURE_READY); // after the result so pollers never see a ready future without it
+	const u32 continuation_count = future->continuation_count;
+	as_spinlock_unlock(&future->continuations_lock);
+
+	as_wake_address_all(&future->state);
+	for (u32 i = 0; i < continuation_count; i++)
+	{
+		future->continuations[i](future->continuation_args[i], result);
+	}
+}
+
+b8 as_future_is_ready(as_future* future)
+{
+	AS_ASSERT(future, "Cannot poll future, invalid future");
+	return AS_ATOMIC_LOAD_ACQUIRE_I32(&future->state) == AS_FUTURE_READY;
+}
+
+void* as_future_get_result(as_future* future)
+{
+	return as_future_is_ready(future) ? future->result : NULL;
+}
+
+b8 as_future_wait(as_future* future, const f64 timeout_seconds)
+{
+	AS_ASSERT(future, "Cannot wait on future, invalid future");
+	const f64 deadline = get_monotonic_time() + timeout_seconds;
+	while (!as_future_is_ready(future))
+	{
+		if (timeout_seconds < 0.)
+		{
+			as_wait_on_address(&future->state, AS_FUTURE_PENDING);
+			continue;
+		}
+		const f64 remaining = deadline - get_monotonic_time();
+		if (remaining <= 0.) { return false; }
+		as_wait_on_address_for(&future->state, AS_FUTURE_PENDING, remaining);
+	}
+	return true;
+}
+
+b8 as_future_then(as_future* future, as_future_continuation func, void* arg)
+{
+	AS_ASSERT(future, "Cannot add continuation, invalid future");
+	AS_ASSERT(func, "Cannot add continuation, invalid function");
+	as_spinlock_lock(&future->continuations_lock);
+	if (future->state == AS_FUTURE_READY)
+	{
+		as_spinlock_unlock(&future->continuations_lock);
+		func(arg, future->result);
+		return true;
+	}
+	if (future->continuation_count >= AS_FUTURE_MAX_CONTINUATIONS)
+	{
+		as_spinlock_unlock(&future->continuations_lock);
+		AS_FLOG(LV_WARNING, "Cannot add continuation to future %p, it already has %u", future, future->continuation_count);
+		return false;
+	}
+	future->continuations[future->continuation_count] = func;
+	future->continuation_args[future->continuation_count] = arg;
+	future->continuation_count++;
+	as_spinlock_unlock(&future->continuations_lock);
+	return true;
+}
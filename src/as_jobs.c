@@ -0,0 +1,316 @@
+// Abstract Shader Engine - Jed Fakhfekh - https://github.com/ougi-washi
+
+#include "as_jobs.h"
+#include "as_memory.h"
+
+static AS_THREAD_LOCAL as_job_worker* as_current_job_worker = NULL;
+static AS_THREAD_LOCAL u32 as_job_steal_seed = 0;
+
+static as_job_worker* as_job_get_current_worker(as_job_system* system)
+{
+	return (as_current_job_worker && as_current_job_worker->system == system) ? as_current_job_worker : NULL;
+}
+
+// owner only, false when the deque is full
+static b8 as_job_deque_push(as_job_deque* deque, const as_job* job)
+{
+	const i64 bottom = deque->bottom;
+	const i64 top = AS_ATOMIC_LOAD_ACQUIRE_I64(&deque->top);
+	if (bottom - top >= AS_JOB_DEQUE_SIZE) { return false; }
+	deque->jobs[bottom & (AS_JOB_DEQUE_SIZE - 1)] = *job;
+	AS_ATOMIC_STORE_I64(&deque->bottom, bottom + 1); // full barrier, sleeping workers are checked after the job is visible
+	return true;
+}
+
+// owner only, takes the newest job
+static b8 as_job_deque_pop(as_job_deque* deque, as_job* out_job)
+{
+	const i64 bottom = deque->bottom - 1;
+	AS_ATOMIC_STORE_I64(&deque->bottom, bottom);
+	const i64 top = AS_ATOMIC_LOAD_I64(&deque->top);
+	if (top > bottom)
+	{
+		AS_ATOMIC_STORE_I64(&deque->bottom, bottom + 1);
+		return false;
+	}
+	*out_job = deque->jobs[bottom & (AS_JOB_DEQUE_SIZE - 1)];
+	if (top == bottom) // last job, thieves may be racing for it
+	{
+		const b8 is_won = AS_ATOMIC_CAS_I64(&deque->top, top, top + 1);
+		AS_ATOMIC_STORE_I64(&deque->bottom, bottom + 1);
+		return is_won;
+	}
+	return true;
+}
+
+// any thread, takes the oldest job
+static b8 as_job_deque_steal(as_job_deque* deque, as_job* out_job)
+{
+	const i64 top = AS_ATOMIC_LOAD_I64(&deque->top);
+	const i64 bottom = AS_ATOMIC_LOAD_I64(&deque->bottom);
+	if (top >= bottom) { return false; }
+	*out_job = deque->jobs[top & (AS_JOB_DEQUE_SIZE - 1)]; // the slot cannot be reused while top is unchanged
+	return AS_ATOMIC_CAS_I64(&deque->top, top, top + 1);
+}
+
+static void as_job_execute(const as_job* job)
+{
+	if (job->range_func)
+	{
+		job->range_func(job->arg, job->begin, job->end);
+	}
+	else if (job->func)
+	{
+		job->func(job->arg);
+	}
+	if (job->wait_group)
+	{
+		as_wait_group_done(job->wait_group);
+	}
+}
+
+static b8 as_job_find(as_job_system* system, as_job_worker* worker, as_job* out_job)
+{
+	if (worker && as_job_deque_pop(&worker->deque, out_job)) { return true; }
+
+	if (!AS_MPSC_RING_IS_EMPTY(system->inject) && as_spinlock_try_lock(&system->inject_consumer_lock))
+	{
+		as_job* front = AS_MPSC_RING_FRONT(system->inject);
+		if (front)
+		{
+			*out_job = *front;
+			AS_MPSC_RING_POP_FRONT(system->inject);
+		}
+		as_spinlock_unlock(&system->inject_consumer_lock);
+		if (front) { return true; }
+	}
+
+	// xorshift so thieves do not all start with the same victim
+	if (as_job_steal_seed == 0) { as_job_steal_seed = (u32)(uintptr_t)&as_job_steal_seed | 1; }
+	as_job_steal_seed ^= as_job_steal_seed << 13;
+	as_job_steal_seed ^= as_job_steal_seed >> 17;
+	as_job_steal_seed ^= as_job_steal_seed << 5;
+	const u32 start = as_job_steal_seed % system->worker_count;
+	for (u32 i = 0; i < system->worker_count; i++)
+	{
+		as_job_worker* victim = &system->workers[(start + i) % system->worker_count];
+		if (victim == worker) { continue; }
+		if (as_job_deque_steal(&victim->deque, out_job)) { return true; }
+	}
+	return false;
+}
+
+static void as_job_wake_worker(as_job_system* system)
+{
+	if (AS_ATOMIC_LOAD_I64(&system->sleeping_workers) > 0)
+	{
+		AS_ATOMIC_ADD_I32(&system->wake_epoch, 1);
+		as_wake_address_one(&system->wake_epoch);
+	}
+}
+
+static void as_job_push(as_job_system* system, const as_job* job)
+{
+	if (job->wait_group)
+	{
+		as_wait_group_add(job->wait_group, 1);
+	}
+	b8 is_pushed = false;
+	as_job_worker* worker = as_job_get_current_worker(system);
+	if (worker)
+	{
+		is_pushed = as_job_deque_push(&worker->deque, job);
+	}
+	else
+	{
+		AS_MPSC_RING_PUSH(system->inject, *job, is_pushed);
+	}
+	if (!is_pushed) // full, running it here slows the submitter down to the pace of the workers
+	{
+		as_job_execute(job);
+		return;
+	}
+	as_job_wake_worker(system);
+}
+
+static void* as_job_worker_run(void* arg)
+{
+	as_job_worker* worker = (as_job_worker*)arg;
+	as_job_system* system = worker->system;
+	as_current_job_worker = worker;
+	u32 idle_count = 0;
+	while (system->is_running)
+	{
+		as_job job;
+		if (as_job_find(system, worker, &job))
+		{
+			as_job_execute(&job);
+			idle_count = 0;
+			continue;
+		}
+		if (++idle_count < AS_JOB_IDLE_SPIN_COUNT)
+		{
+			AS_CPU_PAUSE();
+			continue;
+		}
+		// the search after registering as sleeping catches jobs pushed before a submitter could see us
+		const u32 epoch = AS_ATOMIC_LOAD_RELAXED_I32(&system->wake_epoch);
+		AS_ATOMIC_ADD_I64(&system->sleeping_workers, 1);
+		const b8 is_found = as_job_find(system, worker, &job);
+		if (!is_found && system->is_running)
+		{
+			as_wait_on_address(&system->wake_epoch, epoch);
+		}
+		AS_ATOMIC_ADD_I64(&system->sleeping_workers, -1);
+		if (is_found)
+		{
+			as_job_execute(&job);
+		}
+		idle_count = 0;
+	}
+	as_current_job_worker = NULL;
+	return NULL;
+}
+
+as_job_system* as_job_system_create(const u32 worker_count)
+{
+	as_job_system* system = AS_MALLOC_SINGLE(as_job_system);
+	u32 count = worker_count > 0 ? worker_count : (u32)as_get_cpu_cores();
+	if (count == 0) { count = 1; }
+	if (count > AS_MAX_JOB_WORKERS) { count = AS_MAX_JOB_WORKERS; }
+
+	system->workers = (as_job_worker*)AS_MALLOC_WITH_TYPE(sizeof(as_job_worker) * count, "as_job_worker");
+	system->worker_count = count;
+	system->is_running = true;
+	for (u32 i = 0; i < count; i++)
+	{
+		system->workers[i].system = system;
+		system->workers[i].index = i;
+	}
+	as_current_job_worker = &system->workers[0];
+	for (u32 i = 1; i < count; i++)
+	{
+		system->workers[i].thread = as_thread_create(as_job_worker_run, &system->workers[i]);
+		char name[AS_THREAD_NAME_SIZE] = { 0 };
+		snprintf(name, sizeof(name), "as_job_%u", i);
+		as_thread_set_name(system->workers[i].thread, name);
+	}
+	AS_SET_VALID(system);
+	AS_FLOG(LV_LOG, "Created job system with %u workers", count);
+	return system;
+}
+
+void as_job_system_destroy(as_job_system* system)
+{
+	AS_ASSERT(system, "Cannot destroy job system, invalid system");
+	system->is_running = false;
+	AS_ATOMIC_ADD_I32(&system->wake_epoch, 1);
+	as_wake_address_all(&system->wake_epoch);
+	for (u32 i = 1; i < system->worker_count; i++)
+	{
+		as_thread_join(system->workers[i].thread);
+	}
+
+	// whatever is left still runs, someone may be waiting on it
+	as_current_job_worker = NULL;
+	as_job job;
+	while (as_job_find(system, NULL, &job))
+	{
+		as_job_execute(&job);
+	}
+
+	AS_FREE(system->workers);
+	AS_SET_INVALID(system);
+	AS_FREE(system);
+}
+
+u32 as_job_system_get_worker_count(as_job_system* system)
+{
+	AS_ASSERT(system, "Cannot get worker count, invalid system");
+	return system->worker_count;
+}
+
+i32 as_job_system_get_worker_index(as_job_system* system)
+{
+	as_job_worker* worker = as_job_get_current_worker(system);
+	return worker ? (i32)worker->index : -1;
+}
+
+void as_job_submit(as_job_system* system, as_job_func func, void* arg, as_wait_group* wait_group)
+{
+	AS_ASSERT(system, "Cannot submit job, invalid system");
+	AS_ASSERT(func, "Cannot submit job, invalid function");
+	as_job job = { 0 };
+	job.func = func;
+	job.arg = arg;
+	job.wait_group = wait_group;
+	as_job_push(system, &job);
+}
+
+void as_job_parallel_for(as_job_system* system, const sz count, const sz batch_size, as_job_range_func func, void* arg)
+{
+	AS_ASSERT(system, "Cannot run parallel for, invalid system");
+	AS_ASSERT(func, "Cannot run parallel for, invalid function");
+	if (count == 0) { return; }
+
+	sz batch = batch_size;
+	if (batch == 0) // a few batches per worker so stealing can even out uneven batches
+	{
+		batch = count / ((sz)system->worker_count * 4);
+		if (batch == 0) { batch = 1; }
+	}
+
+	as_wait_group wait_group = AS_WAIT_GROUP_INITIALIZER;
+	for (sz begin = 0; begin < count; begin += batch)
+	{
+		as_job job = { 0 };
+		job.range_func = func;
+		job.arg = arg;
+		job.begin = begin;
+		job.end = begin + batch < count ? begin + batch : count;
+		job.wait_group = &wait_group;
+		as_job_push(system, &job);
+	}
+	as_wait_group_wait(system, &wait_group);
+}
+
+b8 as_job_run_pending(as_job_system* system)
+{
+	AS_ASSERT(system, "Cannot run pending job, invalid system");
+	as_job job;
+	if (!as_job_find(system, as_job_get_current_worker(system), &job)) { return false; }
+	as_job_execute(&job);
+	return true;
+}
+
+void as_wait_group_add(as_wait_group* wait_group, const i64 count)
+{
+	AS_ATOMIC_ADD_I64(&wait_group->pending, count);
+}
+
+void as_wait_group_done(as_wait_group* wait_group)
+{
+	AS_ATOMIC_ADD_I64(&wait_group->pending, -1);
+}
+
+b8 as_wait_group_is_done(as_wait_group* wait_group)
+{
+	return AS_ATOMIC_LOAD_I64(&wait_group->pending) <= 0;
+}
+
+void as_wait_group_wait(as_job_system* system, as_wait_group* wait_group)
+{
+	AS_ASSERT(system, "Cannot wait, invalid system");
+	AS_ASSERT(wait_group, "Cannot wait, invalid wait group");
+	u32 idle_count = 0;
+	while (!as_wait_group_is_done(wait_group))
+	{
+		if (as_job_run_pending(system))
+		{
+			idle_count = 0;
+			continue;
+		}
+		if (++idle_count < AS_JOB_IDLE_SPIN_COUNT) { AS_CPU_PAUSE(); }
+		else { as_thread_yield(); }
+	}
+}
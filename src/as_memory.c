@@ -1,82 +1,461 @@
 // Abstract Shader Engine - Jed Fakhfekh - https://github.com/ougi-washi
 
 #include "as_memory.h"
+#include "as_threads.h"
 #include "stdlib.h"
+#include <string.h>
+#if !PLATFORM_WINDOWS
+#include <sys/mman.h>
+#endif
+
+// zeroed memory, small blocks from calloc and large ones mapped from the OS so nothing gets memset
+void* as_memory_alloc_zeroed(const sz _size)
+{
+	if (_size < AS_MEMORY_LARGE_ALLOCATION_SIZE)
+	{
+		return calloc(1, _size);
+	}
+#if PLATFORM_WINDOWS
+	return VirtualAlloc(NULL, _size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+	void* ptr = mmap(NULL, _size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	return ptr == MAP_FAILED ? NULL : ptr;
+#endif
+}
+
+void as_memory_release(void* _ptr, const sz _size)
+{
+	if (_size < AS_MEMORY_LARGE_ALLOCATION_SIZE)
+	{
+		free(_ptr);
+		return;
+	}
+#if PLATFORM_WINDOWS
+	VirtualFree(_ptr, 0, MEM_RELEASE);
+#else
+	munmap(_ptr, _size);
+#endif
+}
+
+void* as_memory_resize(void* _ptr, const sz _old_size, const sz _size)
+{
+	if (_old_size < AS_MEMORY_LARGE_ALLOCATION_SIZE && _size < AS_MEMORY_LARGE_ALLOCATION_SIZE)
+	{
+		return realloc(_ptr, _size);
+	}
+	void* new_ptr = as_memory_alloc_zeroed(_size);
+	if (new_ptr)
+	{
+		memcpy(new_ptr, _ptr, _old_size < _size ? _old_size : _size);
+		as_memory_release(_ptr, _old_size);
+	}
+	return new_ptr;
+}
+
+static const char* memory_tag_names[AS_MEMORY_TAG_COUNT] = { "none", "render", "shader", "scene", "content", "queue", "io" };
+static volatile b8 memory_strict_mode = false;
+static i64 memory_strict_warmup_frames = 0;
+
+// only its thread writes it, so counting an allocation is a few relaxed stores instead of contended atomic adds.
+// the counters only grow, readers sum every thread and frames are the difference with the last as_memory_end_frame.
+// current and peak bytes are the exception, one atomic add per call on memory_current_bytes
+typedef struct as_memory_thread_counters
+{
+	i64 allocated_bytes[AS_MEMORY_TAG_COUNT];
+	i64 freed_bytes[AS_MEMORY_TAG_COUNT];
+	i64 allocation_count[AS_MEMORY_TAG_COUNT];
+	i64 free_count[AS_MEMORY_TAG_COUNT];
+	struct as_memory_thread_counters* next;
+} as_memory_thread_counters;
+
+typedef struct as_memory_counters_sum
+{
+	i64 allocated_bytes[AS_MEMORY_TAG_COUNT];
+	i64 freed_bytes[AS_MEMORY_TAG_COUNT];
+	i64 allocation_count[AS_MEMORY_TAG_COUNT];
+	i64 free_count[AS_MEMORY_TAG_COUNT];
+} as_memory_counters_sum;
+
+static AS_THREAD_LOCAL as_memory_thread_counters* memory_thread_counters = NULL;
+static as_memory_thread_counters* memory_threads_counters = NULL; // every thread that ever allocated, kept after it exits
+static as_mutex memory_counters_mutex = AS_MUTEX_INITIALIZER;
+// guarded by memory_counters_mutex, written when frames end
+static as_memory_counters_sum memory_frame_start = { 0 };
+// shared by every thread, the peak needs the live total at each allocation and the frees often happen on other threads
+static volatile i64 memory_current_bytes[AS_MEMORY_TAG_COUNT] = { 0 };
+static volatile i64 memory_peak_bytes[AS_MEMORY_TAG_COUNT] = { 0 };
+static as_memory_tag_stats memory_last_frame_tag_stats[AS_MEMORY_TAG_COUNT] = { 0 };
+static as_memory_frame_stats memory_frame_stats = { 0 };
+
+static as_memory_thread_counters* as_memory_get_thread_counters()
+{
+	if (!memory_thread_counters)
+	{
+		// raw calloc, these counters cannot count themselves
+		as_memory_thread_counters* counters = (as_memory_thread_counters*)calloc(1, sizeof(as_memory_thread_counters));
+		if (!counters) { return NULL; }
+		as_mutex_lock(&memory_counters_mutex);
+		counters->next = memory_threads_counters;
+		memory_threads_counters = counters;
+		as_mutex_unlock(&memory_counters_mutex);
+		memory_thread_counters = counters;
+	}
+	return memory_thread_counters;
+}
+
+#define AS_MEMORY_COUNTER_ADD(_counter, _value) AS_ATOMIC_STORE_RELAXED_I64(&(_counter), AS_ATOMIC_LOAD_RELAXED_I64(&(_counter)) + (_value))
+
+void as_memory_tag_add(const as_memory_tag _tag, const i64 _size)
+{
+	as_memory_thread_counters* counters = as_memory_get_thread_counters();
+	if (!counters) { return; }
+	const as_memory_tag tag = _tag < AS_MEMORY_TAG_COUNT ? _tag : AS_MEMORY_TAG_NONE;
+	AS_MEMORY_COUNTER_ADD(counters->allocated_bytes[tag], _size);
+	AS_MEMORY_COUNTER_ADD(counters->allocation_count[tag], 1);
+
+	const i64 current = AS_ATOMIC_ADD_I64(&memory_current_bytes[tag], _size) + _size;
+	i64 peak = AS_ATOMIC_LOAD_RELAXED_I64(&memory_peak_bytes[tag]);
+	while (current > peak && !AS_ATOMIC_CAS_I64(&memory_peak_bytes[tag], peak, current))
+	{
+		peak = AS_ATOMIC_LOAD_RELAXED_I64(&memory_peak_bytes[tag]);
+	}
+}
+
+void as_memory_tag_remove(const as_memory_tag _tag, const i64 _size)
+{
+	as_memory_thread_counters* counters = as_memory_get_thread_counters();
+	if (!counters) { return; }
+	const as_memory_tag tag = _tag < AS_MEMORY_TAG_COUNT ? _tag : AS_MEMORY_TAG_NONE;
+	AS_MEMORY_COUNTER_ADD(counters->freed_bytes[tag], _size);
+	AS_MEMORY_COUNTER_ADD(counters->free_count[tag], 1);
+	AS_ATOMIC_ADD_I64(&memory_current_bytes[tag], -_size);
+}
+
+// has to be called with memory_counters_mutex held
+static as_memory_counters_sum as_memory_sum_counters()
+{
+	as_memory_counters_sum sum = { 0 };
+	for (as_memory_thread_counters* counters = memory_threads_counters; counters; counters = counters->next)
+	{
+		for (u32 i = 0; i < AS_MEMORY_TAG_COUNT; i++)
+		{
+			sum.allocated_bytes[i] += AS_ATOMIC_LOAD_RELAXED_I64(&counters->allocated_bytes[i]);
+			sum.freed_bytes[i] += AS_ATOMIC_LOAD_RELAXED_I64(&counters->freed_bytes[i]);
+			sum.allocation_count[i] += AS_ATOMIC_LOAD_RELAXED_I64(&counters->allocation_count[i]);
+			sum.free_count[i] += AS_ATOMIC_LOAD_RELAXED_I64(&counters->free_count[i]);
+		}
+	}
+	return sum;
+}
+
+const char* as_memory_tag_to_string(const as_memory_tag tag)
+{
+	return tag < AS_MEMORY_TAG_COUNT ? memory_tag_names[tag] : "unknown";
+}
+
+as_memory_tag_stats as_memory_get_tag_stats(const as_memory_tag tag)
+{
+	as_memory_tag_stats out_stats = { 0 };
+	if (tag >= AS_MEMORY_TAG_COUNT) { return out_stats; }
+	as_mutex_lock(&memory_counters_mutex);
+	const as_memory_counters_sum sum = as_memory_sum_counters();
+	out_stats = memory_last_frame_tag_stats[tag];
+	out_stats.current_bytes = AS_ATOMIC_LOAD_RELAXED_I64(&memory_current_bytes[tag]);
+	out_stats.peak_bytes = AS_ATOMIC_LOAD_RELAXED_I64(&memory_peak_bytes[tag]);
+	out_stats.live_count = sum.allocation_count[tag] - sum.free_count[tag];
+	out_stats.total_count = sum.allocation_count[tag];
+	out_stats.frame_allocated_bytes = sum.allocated_bytes[tag] - memory_frame_start.allocated_bytes[tag];
+	out_stats.frame_freed_bytes = sum.freed_bytes[tag] - memory_frame_start.freed_bytes[tag];
+	as_mutex_unlock(&memory_counters_mutex);
+	return out_stats;
+}
+
+void as_memory_end_frame()
+{
+	as_mutex_lock(&memory_counters_mutex);
+	const as_memory_counters_sum sum = as_memory_sum_counters();
+	i64 allocation_count = 0;
+	i64 free_count = 0;
+	i64 allocated_bytes = 0;
+	for (u32 i = 0; i < AS_MEMORY_TAG_COUNT; i++)
+	{
+		memory_last_frame_tag_stats[i].last_frame_allocated_bytes = sum.allocated_bytes[i] - memory_frame_start.allocated_bytes[i];
+		memory_last_frame_tag_stats[i].last_frame_freed_bytes = sum.freed_bytes[i] - memory_frame_start.freed_bytes[i];
+		allocation_count += sum.allocation_count[i] - memory_frame_start.allocation_count[i];
+		free_count += sum.free_count[i] - memory_frame_start.free_count[i];
+		allocated_bytes += memory_last_frame_tag_stats[i].last_frame_allocated_bytes;
+	}
+	memory_frame_start = sum;
+
+	const i64 frame_index = memory_frame_stats.frame_index;
+	AS_ATOMIC_STORE_I64(&memory_frame_stats.frame_index, frame_index + 1); // read without the lock by as_memory_is_past_warmup
+	memory_frame_stats.last_allocation_count = allocation_count;
+	memory_frame_stats.last_free_count = free_count;
+	memory_frame_stats.last_allocated_bytes = allocated_bytes;
+	if (frame_index >= memory_strict_warmup_frames && allocation_count > memory_frame_stats.worst_allocation_count)
+	{
+		memory_frame_stats.worst_allocation_count = allocation_count;
+		memory_frame_stats.worst_frame_index = frame_index;
+	}
+	as_mutex_unlock(&memory_counters_mutex);
+}
+
+as_memory_frame_stats as_memory_get_frame_stats()
+{
+	as_mutex_lock(&memory_counters_mutex);
+	const as_memory_counters_sum sum = as_memory_sum_counters();
+	as_memory_frame_stats out_stats = memory_frame_stats;
+	out_stats.allocation_count = 0;
+	out_stats.free_count = 0;
+	out_stats.allocated_bytes = 0;
+	for (u32 i = 0; i < AS_MEMORY_TAG_COUNT; i++)
+	{
+		out_stats.allocation_count += sum.allocation_count[i] - memory_frame_start.allocation_count[i];
+		out_stats.free_count += sum.free_count[i] - memory_frame_start.free_count[i];
+		out_stats.allocated_bytes += sum.allocated_bytes[i] - memory_frame_start.allocated_bytes[i];
+	}
+	as_mutex_unlock(&memory_counters_mutex);
+	return out_stats;
+}
+
+void as_memory_set_strict_mode(const b8 enabled, const i64 warmup_frames)
+{
+	memory_strict_warmup_frames = warmup_frames;
+	memory_strict_mode = enabled;
+}
+
+b8 as_memory_is_past_warmup()
+{
+	return memory_strict_mode && AS_ATOMIC_LOAD_I64(&memory_frame_stats.frame_index) >= memory_strict_warmup_frames;
+}
+
+void as_memory_log_tag_stats()
+{
+	for (u32 i = 0; i < AS_MEMORY_TAG_COUNT; i++)
+	{
+		const as_memory_tag_stats stats = as_memory_get_tag_stats(i);
+		AS_FLOG(LV_LOG, "Memory tag %s: current=%lld, peak=%lld, live=%lld, total=%lld, last frame +%lld/-%lld",
+			memory_tag_names[i], (long long)stats.current_bytes, (long long)stats.peak_bytes, (long long)stats.live_count,
+			(long long)stats.total_count, (long long)stats.last_frame_allocated_bytes, (long long)stats.last_frame_freed_bytes);
+	}
+}
+
+b8 as_memory_dump_stats(const char* path, const as_memory_dump_format format)
+{
+	AS_WARNING_RETURN_VAL_IF_FALSE(path, false, "Cannot dump memory stats, invalid path %p", path);
+	FILE* file = fopen(path, "w");
+	AS_WARNING_RETURN_VAL_IF_FALSE(file, false, "Cannot dump memory stats, could not open %s", path);
+
+	if (format == AS_MEMORY_DUMP_CSV)
+	{
+		fprintf(file, "tag,current_bytes,peak_bytes,live_count,total_count,last_frame_allocated_bytes,last_frame_freed_bytes\n");
+	}
+	else
+	{
+		fprintf(file, "{\n\t\"tags\": [\n");
+	}
+	for (u32 i = 0; i < AS_MEMORY_TAG_COUNT; i++)
+	{
+		const as_memory_tag_stats stats = as_memory_get_tag_stats(i);
+		if (format == AS_MEMORY_DUMP_CSV)
+		{
+			fprintf(file, "%s,%lld,%lld,%lld,%lld,%lld,%lld\n",
+				memory_tag_names[i], (long long)stats.current_bytes, (long long)stats.peak_bytes, (long long)stats.live_count,
+				(long long)stats.total_count, (long long)stats.last_frame_allocated_bytes, (long long)stats.last_frame_freed_bytes);
+		}
+		else
+		{
+			fprintf(file, "\t\t{ \"tag\": \"%s\", \"current_bytes\": %lld, \"peak_bytes\": %lld, \"live_count\": %lld, \"total_count\": %lld, \"last_frame_allocated_bytes\": %lld, \"last_frame_freed_bytes\": %lld }%s\n",
+				memory_tag_names[i], (long long)stats.current_bytes, (long long)stats.peak_bytes, (long long)stats.live_count,
+				(long long)stats.total_count, (long long)stats.last_frame_allocated_bytes, (long long)stats.last_frame_freed_bytes,
+				i + 1 < AS_MEMORY_TAG_COUNT ? "," : "");
+		}
+	}
+	if (format == AS_MEMORY_DUMP_JSON)
+	{
+		fprintf(file, "\t]\n}\n");
+	}
+	fclose(file);
+	return true;
+}
+
+#if AS_MEMORY_TRACKING
 
 u32 allocations_count = 0;
 u64 allocated_memory = 0;
-as_allocation allocations[MAX_ALLOCATIONS_COUNT] = { 0 };
+as_allocation allocations[AS_ALLOCATIONS_TABLE_SIZE] = { 0 };
+static as_mutex allocations_mutex = AS_MUTEX_INITIALIZER;
 
-void* as_malloc_fn(const size_t _size, const char* _file, const u32 _line, const char* _type)
+#define AS_ALLOCATIONS_TABLE_MASK (AS_ALLOCATIONS_TABLE_SIZE - 1)
+
+static as_memory_frame_offender frame_offenders[AS_MEMORY_MAX_FRAME_OFFENDERS] = { 0 };
+static u32 frame_offenders_count = 0;
+
+// has to be called with allocations_mutex held, returns true the first time a call site shows up
+b8 as_memory_record_frame_offender(const char* _file, const u32 _line, const char* _type, const sz _size)
 {
-	void* new_ptr = malloc(_size);
-	AS_ASSERT(new_ptr, "Could not allocate memory.");
+	for (u32 i = 0; i < frame_offenders_count; i++)
+	{
+		as_memory_frame_offender* offender = &frame_offenders[i];
+		if (offender->line == _line && (offender->file == _file || strcmp(offender->file, _file) == 0))
+		{
+			offender->count++;
+			offender->bytes += _size;
+			return false;
+		}
+	}
+	if (frame_offenders_count >= AS_MEMORY_MAX_FRAME_OFFENDERS) { return false; }
+	as_memory_frame_offender* offender = &frame_offenders[frame_offenders_count++];
+	offender->file = _file;
+	offender->type = _type;
+	offender->line = _line;
+	offender->count = 1;
+	offender->bytes = _size;
+	offender->first_frame = AS_ATOMIC_LOAD_I64(&memory_frame_stats.frame_index);
+	return true;
+}
+
+sz as_allocation_hash(const void* _ptr)
+{
+	// fibonacci hashing, the low bits of heap pointers are mostly alignment so they are dropped
+	const u64 key = (u64)(uintptr_t)_ptr >> 4;
+	return (sz)((key * 11400714819323198485ull) >> (64 - AS_ALLOCATIONS_TABLE_BITS));
+}
 
-	strcpy(allocations[allocations_count].file, _file);
-	strcpy(allocations[allocations_count].type, _type);
-	allocations[allocations_count].line = _line;
-	allocations[allocations_count].size = _size;
-	allocations[allocations_count].ptr = new_ptr;
-	if (allocations[allocations_count].ptr)
+as_allocation* as_allocation_find(const void* _ptr)
+{
+	sz index = as_allocation_hash(_ptr);
+	while (allocations[index].ptr)
 	{
-		memset(allocations[allocations_count].ptr, 0, _size);
+		if (allocations[index].ptr == _ptr)
+		{
+			return &allocations[index];
+		}
+		index = (index + 1) & AS_ALLOCATIONS_TABLE_MASK;
 	}
-	allocated_memory += _size;
+	return NULL;
+}
+
+as_allocation* as_allocation_insert(void* _ptr)
+{
+	AS_ASSERT((allocations_count < MAX_ALLOCATIONS_COUNT), "Too many allocations to track.");
+	sz index = as_allocation_hash(_ptr);
+	while (allocations[index].ptr)
+	{
+		index = (index + 1) & AS_ALLOCATIONS_TABLE_MASK;
+	}
+	allocations[index].ptr = _ptr;
 	allocations_count++;
-	//void* out_ptr = allocations[allocations_count - 1].ptr;
+	return &allocations[index];
+}
+
+void as_allocation_erase(as_allocation* _allocation)
+{
+	// backward shift deletion, keeps the probe chains intact without tombstones
+	sz hole = _allocation - allocations;
+	sz index = hole;
+	while (true)
+	{
+		index = (index + 1) & AS_ALLOCATIONS_TABLE_MASK;
+		if (!allocations[index].ptr)
+		{
+			break;
+		}
+		const sz home = as_allocation_hash(allocations[index].ptr);
+		if (((index - home) & AS_ALLOCATIONS_TABLE_MASK) >= ((index - hole) & AS_ALLOCATIONS_TABLE_MASK))
+		{
+			allocations[hole] = allocations[index];
+			hole = index;
+		}
+	}
+	allocations[hole].ptr = NULL;
+	allocations[hole].size = 0;
+	allocations_count--;
+}
+
+void* as_malloc_fn(const size_t _size, const char* _file, const u32 _line, const char* _type, const as_memory_tag _tag)
+{
+	void* new_ptr = as_memory_alloc_zeroed(_size);
+	AS_ASSERT(new_ptr, "Could not allocate memory.");
+	if (!new_ptr) { return NULL; }
+
+	as_mutex_lock(&allocations_mutex);
+	as_allocation* allocation = as_allocation_insert(new_ptr);
+	allocation->file = _file;
+	allocation->type = _type;
+	allocation->line = _line;
+	allocation->size = _size;
+	allocation->tag = _tag;
+	allocated_memory += _size;
+	const b8 is_new_offender = as_memory_is_past_warmup() && as_memory_record_frame_offender(_file, _line, _type, _size);
+	as_mutex_unlock(&allocations_mutex);
+	as_memory_tag_add(_tag, _size);
+	if (is_new_offender)
+	{
+		AS_FLOG(LV_WARNING, "Allocation of %zu bytes (%s) after warm-up at %s:%u", _size, as_memory_tag_to_string(_tag), _file, _line);
+	}
 	return new_ptr;
 }
 
 void* as_realloc_fn(void* _ptr, const size_t _size, const char* _file, const u32 _line)
 {
-	if (allocations && _ptr)
+	if (_ptr)
 	{
-		for (u32 i = 0; i < allocations_count; i++)
+		as_mutex_lock(&allocations_mutex);
+		as_allocation* allocation = as_allocation_find(_ptr);
+		if (allocation)
 		{
-			if (allocations[i].ptr == _ptr)
+			const char* type = allocation->type;
+			const as_memory_tag tag = allocation->tag;
+			const sz old_size = allocation->size;
+			void* new_ptr = as_memory_resize(_ptr, old_size, _size);
+			if (!new_ptr) // like realloc, the old block is still valid and still tracked
 			{
-				_ptr = realloc(_ptr, _size);
-				allocated_memory -= allocations[i].size;
-				allocated_memory += _size;
-
-				strcpy(allocations[i].file, _file);
-				allocations[i].line = _line;
-				allocations[i].ptr = _ptr;
-				allocations[i].size = _size;
-				return _ptr;
+				as_mutex_unlock(&allocations_mutex);
+				AS_FLOG(LV_ERROR, "Could not reallocate %zu bytes to %zu at %s:%u", old_size, _size, _file, _line);
+				return NULL;
 			}
+			allocated_memory -= old_size;
+			as_allocation_erase(allocation);
+			_ptr = new_ptr;
+
+			allocation = as_allocation_insert(_ptr);
+			allocation->file = _file;
+			allocation->type = type;
+			allocation->line = _line;
+			allocation->size = _size;
+			allocation->tag = tag;
+			allocated_memory += _size;
+			const b8 is_new_offender = as_memory_is_past_warmup() && as_memory_record_frame_offender(_file, _line, type, _size);
+			as_mutex_unlock(&allocations_mutex);
+			as_memory_tag_remove(tag, old_size);
+			as_memory_tag_add(tag, _size);
+			if (is_new_offender)
+			{
+				AS_FLOG(LV_WARNING, "Reallocation to %zu bytes (%s) after warm-up at %s:%u", _size, as_memory_tag_to_string(tag), _file, _line);
+			}
+			return _ptr;
 		}
+		as_mutex_unlock(&allocations_mutex);
 	}
-	return as_malloc_fn(_size, _file, _line, "");
+	return as_malloc_fn(_size, _file, _line, "", AS_MEMORY_TAG_NONE);
 }
 
 void as_free_fn(void* _ptr)
 {
 	if (!_ptr) { return; };
-	i64 removed_index = -1;
-	for (u32 i = 0; i < allocations_count; i++)
-	{
-		if (removed_index == -1 && allocations[i].ptr == _ptr)
-		{
-			free(_ptr);
-			_ptr = NULL;
-			allocated_memory -= allocations[i].size;
-			removed_index = i;
-		}
-		else if (removed_index >= 0 && i > 0)
-		{
-			allocations[i - 1] = allocations[i];
-		}
-	}
-	if (allocations_count > 0 && removed_index >= 0)
+	as_mutex_lock(&allocations_mutex);
+	as_allocation* allocation = as_allocation_find(_ptr);
+	if (allocation)
 	{
-		allocations_count--;
+		const sz size = allocation->size;
+		const as_memory_tag tag = allocation->tag;
+		allocated_memory -= size;
+		as_allocation_erase(allocation);
+		as_memory_release(_ptr, size);
+		as_memory_tag_remove(tag, size);
 	}
-	//if (_ptr)
-	//{
-	//	free(_ptr);
-	//	_ptr = NULL;
-	//}
+	as_mutex_unlock(&allocations_mutex);
 }
 
 char* as_allocation_to_string(as_allocation* _allocation) 
@@ -94,15 +473,456 @@ char* as_allocation_to_string(as_allocation* _allocation)
 
 void as_log_memory() 
 {
-	char log_buffer[4096];
+	// one line per allocation, nothing gets truncated however many are still alive
+	as_mutex_lock(&allocations_mutex);
+	AS_FLOG(LV_LOG, "Total allocated memory = %llu in %u allocations", (unsigned long long)allocated_memory, allocations_count);
+	for (u32 i = 0; i < AS_ALLOCATIONS_TABLE_SIZE; i++) 
+	{
+		if (!allocations[i].ptr) { continue; }
+		AS_FLOG(LV_LOG, "ptr=%p, size=%zu, tag=%s, type=%s, file=%s, line=%u",
+			allocations[i].ptr, allocations[i].size, as_memory_tag_to_string(allocations[i].tag), allocations[i].type, allocations[i].file, allocations[i].line);
+	}
+	as_mutex_unlock(&allocations_mutex);
+	as_memory_log_tag_stats();
+}
+
+int as_memory_compare_frame_offenders(const void* a, const void* b)
+{
+	const u64 count_a = ((const as_memory_frame_offender*)a)->count;
+	const u64 count_b = ((const as_memory_frame_offender*)b)->count;
+	return (count_a < count_b) - (count_a > count_b);
+}
+
+void as_memory_log_frame_offenders(const u32 max_count)
+{
+	const as_memory_frame_stats frame_stats = as_memory_get_frame_stats();
+	AS_FLOG(LV_LOG, "Frames: %lld, worst frame after warm-up: %lld allocations at frame %lld",
+		(long long)frame_stats.frame_index, (long long)frame_stats.worst_allocation_count, (long long)frame_stats.worst_frame_index);
 
-	snprintf(log_buffer, sizeof(log_buffer), "Total allocated memory = %zu\n", allocated_memory);
-	for (u32 i = 0; i < allocations_count; i++) 
+	as_mutex_lock(&allocations_mutex);
+	qsort(frame_offenders, frame_offenders_count, sizeof(as_memory_frame_offender), as_memory_compare_frame_offenders);
+	for (u32 i = 0; i < frame_offenders_count && i < max_count; i++)
 	{
-		char* str = as_allocation_to_string(&allocations[i]);
-		strncat(log_buffer, str, sizeof(log_buffer) - strlen(log_buffer) - 1);
-		free(str);
-		strncat(log_buffer, "\n", sizeof(log_buffer) - strlen(log_buffer) - 1);
+		const as_memory_frame_offender* offender = &frame_offenders[i];
+		AS_FLOG(LV_LOG, "%llu allocations (%llu bytes, %s) after warm-up from %s:%u, first at frame %lld",
+			(unsigned long long)offender->count, (unsigned long long)offender->bytes, offender->type, offender->file, offender->line, (long long)offender->first_frame);
 	}
-	AS_LOG(LV_LOG, log_buffer);
-}
\ No newline at end of file
+	as_mutex_unlock(&allocations_mutex);
+}
+#else
+// the size is kept right before the returned pointer, 16 bytes keep the alignment of malloc
+#define AS_UNTRACKED_HEADER_SIZE 16
+
+typedef struct as_untracked_header
+{
+	sz size;
+	as_memory_tag tag;
+} as_untracked_header;
+
+void* as_malloc_untracked_fn(const size_t _size, const as_memory_tag _tag)
+{
+	u8* block = (u8*)as_memory_alloc_zeroed(_size + AS_UNTRACKED_HEADER_SIZE);
+	if (!block) { return NULL; }
+	as_untracked_header* header = (as_untracked_header*)block;
+	header->size = _size + AS_UNTRACKED_HEADER_SIZE;
+	header->tag = _tag;
+	as_memory_tag_add(_tag, _size);
+	return block + AS_UNTRACKED_HEADER_SIZE;
+}
+
+void* as_realloc_untracked_fn(void* _ptr, const size_t _size)
+{
+	if (!_ptr) { return as_malloc_untracked_fn(_size, AS_MEMORY_TAG_NONE); }
+	u8* block = (u8*)_ptr - AS_UNTRACKED_HEADER_SIZE;
+	const as_untracked_header old_header = *(as_untracked_header*)block;
+	block = (u8*)as_memory_resize(block, old_header.size, _size + AS_UNTRACKED_HEADER_SIZE);
+	if (!block) { return NULL; }
+	((as_untracked_header*)block)->size = _size + AS_UNTRACKED_HEADER_SIZE;
+	as_memory_tag_remove(old_header.tag, old_header.size - AS_UNTRACKED_HEADER_SIZE);
+	as_memory_tag_add(old_header.tag, _size);
+	return block + AS_UNTRACKED_HEADER_SIZE;
+}
+
+void as_free_untracked_fn(void* _ptr)
+{
+	if (!_ptr) { return; }
+	u8* block = (u8*)_ptr - AS_UNTRACKED_HEADER_SIZE;
+	const as_untracked_header header = *(as_untracked_header*)block;
+	as_memory_release(block, header.size);
+	as_memory_tag_remove(header.tag, header.size - AS_UNTRACKED_HEADER_SIZE);
+}
+
+void as_memory_log_frame_offenders(const u32 max_count)
+{
+	const as_memory_frame_stats frame_stats = as_memory_get_frame_stats();
+	AS_FLOG(LV_LOG, "Frames: %lld, worst frame after warm-up: %lld allocations at frame %lld (build with AS_MEMORY_TRACKING for call sites)",
+		(long long)frame_stats.frame_index, (long long)frame_stats.worst_allocation_count, (long long)frame_stats.worst_frame_index);
+}
+#endif // AS_MEMORY_TRACKING
+as_arena* as_arena_create(const sz capacity, const as_memory_tag tag)
+{
+	as_arena* arena = AS_MALLOC_SINGLE_TAGGED(as_arena, tag);
+	arena->data = (u8*)AS_MALLOC_TAGGED(capacity, "arena", tag);
+	arena->capacity = arena->data ? capacity : 0;
+	return arena;
+}
+
+void as_arena_destroy(as_arena* arena)
+{
+	if (!arena) { return; }
+	AS_FREE(arena->data);
+	AS_FREE(arena);
+}
+
+void* as_arena_alloc(as_arena* arena, const sz size, const sz alignment)
+{
+	AS_WARNING_RETURN_VAL_IF_FALSE(arena, NULL, "Cannot allocate %zu bytes, invalid arena", size);
+	const sz aligned_offset = (arena->offset + alignment - 1) & ~(alignment - 1);
+	if (aligned_offset + size > arena->capacity)
+	{
+		AS_FLOG(LV_ERROR, "Arena %p is full, could not allocate %zu bytes (%zu/%zu used)", arena, size, arena->offset, arena->capacity);
+		return NULL;
+	}
+	arena->offset = aligned_offset + size;
+	if (arena->offset > arena->peak)
+	{
+		arena->peak = arena->offset;
+	}
+	return arena->data + aligned_offset;
+}
+
+as_arena_mark as_arena_get_mark(const as_arena* arena)
+{
+	return arena ? arena->offset : 0;
+}
+
+void as_arena_rewind(as_arena* arena, const as_arena_mark mark)
+{
+	AS_ASSERT((arena && mark <= arena->offset), "Cannot rewind arena past its current offset");
+	arena->offset = mark;
+}
+
+void as_arena_reset(as_arena* arena)
+{
+	if (!arena) { return; }
+	arena->offset = 0;
+}
+
+static AS_THREAD_LOCAL as_arena* frame_arena = NULL;
+
+as_arena* as_arena_get_frame()
+{
+	if (!frame_arena)
+	{
+		frame_arena = as_arena_create(AS_ARENA_FRAME_SIZE, AS_MEMORY_TAG_RENDER);
+	}
+	return frame_arena;
+}
+
+void as_arena_destroy_frame()
+{
+	as_arena_destroy(frame_arena);
+	frame_arena = NULL;
+}
+
+as_slab_page* as_slab_add_page(as_slab* slab)
+{
+	if (slab->items_per_page == 0)
+	{
+		slab->item_stride = (AS_SLAB_ITEM_OFFSET + slab->item_size + AS_ARENA_DEFAULT_ALIGNMENT - 1) & ~(sz)(AS_ARENA_DEFAULT_ALIGNMENT - 1);
+		slab->items_per_page = AS_SLAB_PAGE_SIZE / slab->item_stride;
+		if (slab->items_per_page < 1) { slab->items_per_page = 1; }
+		if (slab->items_per_page > AS_SLAB_MAX_ITEMS_PER_PAGE) { slab->items_per_page = AS_SLAB_MAX_ITEMS_PER_PAGE; }
+	}
+
+	as_slab_page* page = AS_MALLOC_TAGGED(sizeof(as_slab_page), slab->name, slab->tag);
+	page->data = (u8*)AS_MALLOC_TAGGED(slab->item_stride * slab->items_per_page, slab->name, slab->tag);
+	if (!page->data)
+	{
+		AS_FREE(page);
+		return NULL;
+	}
+
+	// thread the new slots onto the free list in address order
+	for (sz slot = slab->items_per_page; slot > 0; slot--)
+	{
+		as_slab_item_header* header = (as_slab_item_header*)(page->data + (slot - 1) * slab->item_stride);
+		header->page = page;
+		header->slot = slot - 1;
+		header->next_free = slab->free_list;
+		slab->free_list = header;
+	}
+	page->next = slab->pages;
+	slab->pages = page;
+	slab->page_count++;
+	return page;
+}
+
+void* as_slab_alloc(as_slab* slab)
+{
+	AS_WARNING_RETURN_VAL_IF_FALSE(slab, NULL, "Cannot allocate from slab %p", slab);
+	as_mutex_lock(&slab->mutex);
+	if (!slab->free_list && !as_slab_add_page(slab))
+	{
+		as_mutex_unlock(&slab->mutex);
+		AS_FLOG(LV_ERROR, "Could not add a page to slab %s", slab->name);
+		return NULL;
+	}
+	as_slab_item_header* header = slab->free_list;
+	slab->free_list = header->next_free;
+	header->next_free = NULL;
+	header->page->live_mask |= 1ull << header->slot;
+	header->page->live_count++;
+	slab->live_count++;
+	if (slab->live_count > slab->peak_count)
+	{
+		slab->peak_count = slab->live_count;
+	}
+	as_mutex_unlock(&slab->mutex);
+
+	void* item = (u8*)header + AS_SLAB_ITEM_OFFSET;
+	memset(item, 0, slab->item_size);
+	return item;
+}
+
+void as_slab_free(as_slab* slab, void* ptr)
+{
+	if (!slab || !ptr) { return; }
+	as_slab_item_header* header = (as_slab_item_header*)((u8*)ptr - AS_SLAB_ITEM_OFFSET);
+
+	as_mutex_lock(&slab->mutex);
+	const u64 slot_bit = 1ull << header->slot;
+	if (!(header->page->live_mask & slot_bit))
+	{
+		as_mutex_unlock(&slab->mutex);
+		AS_FLOG(LV_WARNING, "Slab %s item %p is already free", slab->name, ptr);
+		return;
+	}
+	header->page->live_mask &= ~slot_bit;
+	header->page->live_count--;
+	slab->live_count--;
+
+	header->next_free = slab->free_list;
+	slab->free_list = header;
+	as_mutex_unlock(&slab->mutex);
+}
+
+b8 as_slab_owns(as_slab* slab, const void* ptr)
+{
+	if (!slab || !ptr) { return false; }
+	b8 found = false;
+	as_mutex_lock(&slab->mutex);
+	for (as_slab_page* page = slab->pages; page && !found; page = page->next)
+	{
+		found = (const u8*)ptr >= page->data && (const u8*)ptr < page->data + slab->item_stride * slab->items_per_page;
+	}
+	as_mutex_unlock(&slab->mutex);
+	return found;
+}
+
+void as_slab_destroy(as_slab* slab)
+{
+	if (!slab) { return; }
+	as_mutex_lock(&slab->mutex);
+	if (slab->live_count > 0)
+	{
+		AS_FLOG(LV_WARNING, "Destroying slab %s with %zu live items", slab->name, slab->live_count);
+	}
+	as_slab_page* page = slab->pages;
+	while (page)
+	{
+		as_slab_page* next = page->next;
+		AS_FREE(page->data);
+		AS_FREE(page);
+		page = next;
+	}
+	slab->pages = NULL;
+	slab->free_list = NULL;
+	slab->page_count = 0;
+	slab->live_count = 0;
+	as_mutex_unlock(&slab->mutex);
+}
+
+as_slab_stats as_slab_get_stats(as_slab* slab)
+{
+	as_slab_stats stats = { 0 };
+	if (!slab) { return stats; }
+
+	as_mutex_lock(&slab->mutex);
+	sz stranded_count = 0;
+	for (as_slab_page* page = slab->pages; page; page = page->next)
+	{
+		if (page->live_count == 0)
+		{
+			stats.empty_page_count++;
+		}
+		else
+		{
+			stranded_count += slab->items_per_page - page->live_count;
+		}
+	}
+	stats.live_count = slab->live_count;
+	stats.peak_count = slab->peak_count;
+	stats.page_count = slab->page_count;
+	stats.capacity = slab->page_count * slab->items_per_page;
+	as_mutex_unlock(&slab->mutex);
+
+	if (stats.capacity > 0)
+	{
+		stats.occupancy = (f32)stats.live_count / (f32)stats.capacity;
+		stats.fragmentation = (f32)stranded_count / (f32)stats.capacity;
+	}
+	return stats;
+}
+
+void as_slab_log_stats(as_slab* slab)
+{
+	if (!slab) { return; }
+	const as_slab_stats stats = as_slab_get_stats(slab);
+	AS_FLOG(LV_LOG, "Slab %s: %zu live (peak %zu), %zu pages (%zu empty), occupancy %.2f, fragmentation %.2f",
+		slab->name, stats.live_count, stats.peak_count, stats.page_count, stats.empty_page_count, stats.occupancy, stats.fragmentation);
+}
+
+static as_handle_slot* as_handle_table_resolve(as_handle_table* table, const as_handle handle)
+{
+	if (AS_HANDLE_IS_NULL(handle) || handle.index >= table->slots.size) { return NULL; }
+	as_handle_slot* slot = &table->slots.data[handle.index];
+	return slot->generation == handle.generation ? slot : NULL;
+}
+
+as_handle as_handle_table_add(as_handle_table* table, void* item)
+{
+	AS_ASSERT(table, "Trying to add to handle table, but table is NULL");
+	AS_WARNING_RETURN_VAL_IF_FALSE(item, AS_HANDLE_INVALID, "Trying to add a NULL item to handle table %s", table->name);
+
+	as_mutex_lock(&table->mutex);
+	if (!AS_VECTOR_RESERVE(table->items, table->items.size + 1) ||
+		!AS_VECTOR_RESERVE(table->dense_slots, table->dense_slots.size + 1))
+	{
+		as_mutex_unlock(&table->mutex);
+		return AS_HANDLE_INVALID;
+	}
+
+	u32 slot_index = 0;
+	if (table->free_head > 0)
+	{
+		slot_index = table->free_head - 1;
+		table->free_head = table->slots.data[slot_index].next_free;
+	}
+	else
+	{
+		as_handle_slot* new_slot = AS_VECTOR_INCREMENT(table->slots);
+		if (!new_slot)
+		{
+			as_mutex_unlock(&table->mutex);
+			return AS_HANDLE_INVALID;
+		}
+		new_slot->generation = 1;
+		slot_index = (u32)(table->slots.size - 1);
+	}
+
+	as_handle_slot* slot = &table->slots.data[slot_index];
+	slot->dense_index = (u32)table->items.size;
+	slot->next_free = 0;
+	table->items.data[table->items.size++] = item;
+	table->dense_slots.data[table->dense_slots.size++] = slot_index;
+
+	const as_handle handle = { slot_index, slot->generation };
+	as_mutex_unlock(&table->mutex);
+	return handle;
+}
+
+void* as_handle_table_get(as_handle_table* table, const as_handle handle)
+{
+	if (!table) { return NULL; }
+	as_mutex_lock(&table->mutex);
+	const as_handle_slot* slot = as_handle_table_resolve(table, handle);
+	void* item = slot ? table->items.data[slot->dense_index] : NULL;
+	as_mutex_unlock(&table->mutex);
+	return item;
+}
+
+sz as_handle_table_get_dense_index(as_handle_table* table, const as_handle handle)
+{
+	if (!table) { return -1; }
+	as_mutex_lock(&table->mutex);
+	const as_handle_slot* slot = as_handle_table_resolve(table, handle);
+	const sz dense_index = slot ? slot->dense_index : (sz)-1;
+	as_mutex_unlock(&table->mutex);
+	return dense_index;
+}
+
+void* as_handle_table_remove(as_handle_table* table, const as_handle handle, void** out_moved)
+{
+	AS_ASSERT(table, "Trying to remove from handle table, but table is NULL");
+	if (out_moved) { *out_moved = NULL; }
+
+	as_mutex_lock(&table->mutex);
+	as_handle_slot* slot = as_handle_table_resolve(table, handle);
+	if (!slot)
+	{
+		as_mutex_unlock(&table->mutex);
+		AS_FLOG(LV_WARNING, "Stale handle %u:%u in handle table %s", handle.index, handle.generation, table->name);
+		return NULL;
+	}
+
+	const u32 dense_index = slot->dense_index;
+	const u32 last_index = (u32)(table->items.size - 1);
+	void* item = table->items.data[dense_index];
+	if (dense_index != last_index)
+	{
+		table->items.data[dense_index] = table->items.data[last_index];
+		table->dense_slots.data[dense_index] = table->dense_slots.data[last_index];
+		table->slots.data[table->dense_slots.data[dense_index]].dense_index = dense_index;
+		if (out_moved) { *out_moved = table->items.data[dense_index]; }
+	}
+	table->items.size--;
+	table->dense_slots.size--;
+
+	slot->generation = slot->generation + 1 == 0 ? 1 : slot->generation + 1;
+	slot->next_free = table->free_head;
+	table->free_head = handle.index + 1;
+
+	as_mutex_unlock(&table->mutex);
+	return item;
+}
+
+void as_handle_table_sort(as_handle_table* table, i32 compare(const void*, const void*), void on_moved(void*, const sz))
+{
+	AS_ASSERT(table, "Trying to sort handle table, but table is NULL");
+	AS_ASSERT(compare, "Trying to sort handle table, but compare is NULL");
+
+	as_mutex_lock(&table->mutex);
+	for (u32 i = 1; i < (u32)table->items.size; i++)
+	{
+		void* item = table->items.data[i];
+		const u32 slot_index = table->dense_slots.data[i];
+		u32 dense_index = i;
+		for (; dense_index > 0 && compare(table->items.data[dense_index - 1], item) > 0; dense_index--)
+		{
+			table->items.data[dense_index] = table->items.data[dense_index - 1];
+			table->dense_slots.data[dense_index] = table->dense_slots.data[dense_index - 1];
+			table->slots.data[table->dense_slots.data[dense_index]].dense_index = dense_index;
+			if (on_moved) { on_moved(table->items.data[dense_index], dense_index); }
+		}
+		if (dense_index != i)
+		{
+			table->items.data[dense_index] = item;
+			table->dense_slots.data[dense_index] = slot_index;
+			table->slots.data[slot_index].dense_index = dense_index;
+			if (on_moved) { on_moved(item, dense_index); }
+		}
+	}
+	as_mutex_unlock(&table->mutex);
+}
+
+void as_handle_table_destroy(as_handle_table* table)
+{
+	if (!table) { return; }
+	as_mutex_lock(&table->mutex);
+	AS_VECTOR_FREE(table->slots);
+	AS_VECTOR_FREE(table->items);
+	AS_VECTOR_FREE(table->dense_slots);
+	table->free_head = 0;
+	as_mutex_unlock(&table->mutex);
+}
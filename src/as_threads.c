@@ -1,7 +1,19 @@
 // Abstract Shader Engine - Jed Fakhfekh - https://github.com/ougi-washi
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // pthread_setname_np, pthread_setaffinity_np
+#endif
 #include "as_threads.h"
 #include "as_memory.h"
+#include <string.h>
+#if PLATFORM_WINDOWS
+#pragma comment(lib, "Synchronization.lib") // WaitOnAddress
+#elif PLATFORM_LINUX || PLATFORM_UNIX
+#include <sched.h>
+#endif
+#if PLATFORM_LINUX
+#include <linux/futex.h>
+#endif
 
 as_thread as_thread_create(void* (*func)(void*), void* arg)
 {
@@ -77,8 +89,82 @@ void as_thread_set_priority(as_thread thread, const i32 priority)
 	SetThreadPriority(thread, priority);
 #elif PLATFORM_LINUX || PLATFORM_UNIX
 	struct sched_param param;
+	i32 policy = SCHED_OTHER;
+	if (pthread_getschedparam(thread, &policy, &param) != 0) { return; }
 	param.sched_priority = priority;
-	pthread_setschedparam(thread, SCHED_OTHER, &param);
+	pthread_setschedparam(thread, policy, &param);
+#endif
+}
+
+void as_thread_set_name(as_thread thread, const char* name)
+{
+	AS_ASSERT(name, "Cannot set thread name, invalid name");
+#if PLATFORM_WINDOWS
+	wchar_t wide_name[AS_THREAD_NAME_SIZE * 4] = { 0 };
+	MultiByteToWideChar(CP_UTF8, 0, name, -1, wide_name, AS_THREAD_NAME_SIZE * 4 - 1);
+	SetThreadDescription(thread, wide_name);
+#elif PLATFORM_LINUX
+	char short_name[AS_THREAD_NAME_SIZE] = { 0 };
+	strncpy(short_name, name, AS_THREAD_NAME_SIZE - 1);
+	pthread_setname_np(thread, short_name);
+#endif
+}
+
+b8 as_thread_set_affinity(as_thread thread, const u64 core_mask)
+{
+	const i32 core_count = as_get_cpu_cores();
+	const u64 all_cores = core_count >= 64 ? ~0ull : (1ull << core_count) - 1;
+	const u64 mask = core_mask ? (core_mask & all_cores) : all_cores;
+	AS_WARNING_RETURN_VAL_IF_FALSE(mask, false, "Cannot set thread affinity, the mask has no available core");
+#if PLATFORM_WINDOWS
+	return SetThreadAffinityMask(thread, (DWORD_PTR)mask) != 0;
+#elif PLATFORM_LINUX
+	cpu_set_t cpu_set;
+	CPU_ZERO(&cpu_set);
+	for (i32 core = 0; core < 64; core++)
+	{
+		if (mask & (1ull << core)) { CPU_SET(core, &cpu_set); }
+	}
+	return pthread_setaffinity_np(thread, sizeof(cpu_set), &cpu_set) == 0;
+#else
+	return false;
+#endif
+}
+
+b8 as_thread_set_policy(as_thread thread, const as_thread_policy policy, const i32 priority)
+{
+#if PLATFORM_WINDOWS
+	const i32 level = policy == AS_THREAD_POLICY_FIFO ? THREAD_PRIORITY_TIME_CRITICAL :
+		policy == AS_THREAD_POLICY_ROUND_ROBIN ? THREAD_PRIORITY_HIGHEST : priority;
+	return SetThreadPriority(thread, level) != 0;
+#elif PLATFORM_LINUX || PLATFORM_UNIX
+	const i32 sched_policy = policy == AS_THREAD_POLICY_FIFO ? SCHED_FIFO :
+		policy == AS_THREAD_POLICY_ROUND_ROBIN ? SCHED_RR : SCHED_OTHER;
+	struct sched_param param = { 0 };
+	if (sched_policy != SCHED_OTHER) // clamped, out of range priorities are rejected
+	{
+		const i32 min_priority = sched_get_priority_min(sched_policy);
+		const i32 max_priority = sched_get_priority_max(sched_policy);
+		param.sched_priority = priority < min_priority ? min_priority : priority > max_priority ? max_priority : priority;
+	}
+	const i32 result = pthread_setschedparam(thread, sched_policy, &param);
+	if (result != 0)
+	{
+		AS_FLOG(LV_WARNING, "Could not set thread policy %d (error %d), real time policies need CAP_SYS_NICE", policy, result);
+		return false;
+	}
+	return true;
+#else
+	return false;
+#endif
+}
+
+void as_thread_yield()
+{
+#if PLATFORM_WINDOWS
+	SwitchToThread();
+#elif PLATFORM_LINUX || PLATFORM_UNIX
+	sched_yield();
 #endif
 }
 
@@ -91,6 +177,7 @@ void as_thread_detach(as_thread thread)
 #endif
 }
 
+#if PLATFORM_WINDOWS
 i32 emulate_pthread_mutex_lock(volatile AS_MUTEX_TYPE* mx)
 {
 	if (*mx == NULL) /* static initializer? */
@@ -101,6 +188,7 @@ i32 emulate_pthread_mutex_lock(volatile AS_MUTEX_TYPE* mx)
 	}
 	return WaitForSingleObject(*mx, INFINITE) == WAIT_FAILED;
 }
+#endif
 
 bool as_mutex_init(as_mutex* mutex)
 {
@@ -122,6 +210,86 @@ bool as_mutex_unlock(as_mutex* mutex)
 bool as_mutex_destroy(as_mutex* mutex)
 {
 	bool result = AS_MUTEX_CLEANUP(*mutex);
-	AS_FREE(mutex);
 	return result;
 }
+
+void as_wait_on_address(u32* address, const u32 expected)
+{
+#if PLATFORM_WINDOWS
+	WaitOnAddress((volatile VOID*)address, (PVOID)&expected, sizeof(u32), INFINITE);
+#elif PLATFORM_LINUX
+	syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+#elif PLATFORM_UNIX
+	if (AS_ATOMIC_LOAD_RELAXED_I32(address) == expected) { sched_yield(); }
+#endif
+}
+
+void as_wait_on_address_for(u32* address, const u32 expected, const f64 timeout_seconds)
+{
+	if (timeout_seconds <= 0.) { return; }
+#if PLATFORM_WINDOWS
+	WaitOnAddress((volatile VOID*)address, (PVOID)&expected, sizeof(u32), (DWORD)(timeout_seconds * 1000.) + 1);
+#elif PLATFORM_LINUX
+	struct timespec timeout;
+	timeout.tv_sec = (time_t)timeout_seconds;
+	timeout.tv_nsec = (long)((timeout_seconds - (f64)timeout.tv_sec) * 1e9);
+	syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, expected, &timeout, NULL, 0);
+#elif PLATFORM_UNIX
+	if (AS_ATOMIC_LOAD_RELAXED_I32(address) == expected) { sched_yield(); }
+#endif
+}
+
+void as_wake_address_one(u32* address)
+{
+#if PLATFORM_WINDOWS
+	WakeByAddressSingle((PVOID)address);
+#elif PLATFORM_LINUX
+	syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#endif
+}
+
+void as_wake_address_all(u32* address)
+{
+#if PLATFORM_WINDOWS
+	WakeByAddressAll((PVOID)address);
+#elif PLATFORM_LINUX
+	syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, INT32_MAX, NULL, NULL, 0);
+#endif
+}
+
+b8 as_spinlock_try_lock(as_spinlock* lock)
+{
+	// the plain load keeps waiting cores from bouncing the cache line with failed exchanges
+	return AS_ATOMIC_LOAD_RELAXED_I32(&lock->state) == 0 && AS_ATOMIC_CAS_I32(&lock->state, 0, 1);
+}
+
+void as_spinlock_lock(as_spinlock* lock)
+{
+	AS_ASSERT(lock, "Cannot lock, invalid lock");
+	u32 backoff = 1;
+	for (u32 round = 0; round < AS_SPINLOCK_SPIN_ROUNDS; round++)
+	{
+		if (as_spinlock_try_lock(lock)) { return; }
+		for (u32 i = 0; i < backoff; i++) { AS_CPU_PAUSE(); }
+		if (backoff < AS_SPINLOCK_MAX_BACKOFF) { backoff <<= 1; }
+	}
+	// held for long, mark that someone sleeps on it so the unlock wakes us up
+	while (AS_ATOMIC_EXCHANGE_I32(&lock->state, 2) != 0)
+	{
+		as_wait_on_address(&lock->state, 2);
+	}
+}
+
+void as_spinlock_unlock(as_spinlock* lock)
+{
+	AS_ASSERT(lock, "Cannot unlock, invalid lock");
+	if (AS_ATOMIC_EXCHANGE_I32(&lock->state, 0) == 2)
+	{
+		as_wake_address_one(&lock->state);
+	}
+}
+
+b8 as_spinlock_is_locked(as_spinlock* lock)
+{
+	return AS_ATOMIC_LOAD_RELAXED_I32(&lock->state) != 0;
+}
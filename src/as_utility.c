@@ -3,6 +3,7 @@
 #include "as_utility.h"
 #include "as_memory.h"
 #include <stdlib.h>
+#include <string.h>
 
 as_file_handle* as_fp_make_handle(as_file_pool* file_pool)
 {
@@ -30,6 +31,186 @@ void as_fp_remove_handle(as_file_pool* file_pool, as_file_handle* handle)
 	AS_UNLOCK(file_pool);
 }
 
+u64 as_string_hash(const char* str)
+{
+	u64 hash = 14695981039346656037ull; // FNV-1a
+	for (const u8* c = (const u8*)str; *c; c++)
+	{
+		hash ^= *c;
+		hash *= 1099511628211ull;
+	}
+	return hash > 1 ? hash : hash + 2; // 0 and 1 mark empty and removed entries
+}
+
+static as_string_map_entry* as_string_map_find(const as_string_map* map, const char* key, const u64 hash)
+{
+	if (!map->entries) { return NULL; }
+	const sz mask = map->capacity - 1;
+	for (sz i = hash & mask; ; i = (i + 1) & mask)
+	{
+		as_string_map_entry* entry = &map->entries[i];
+		if (entry->hash == 0) { return NULL; }
+		if (entry->hash == hash && strcmp(entry->key, key) == 0) { return entry; }
+	}
+}
+
+static b8 as_string_map_resize(as_string_map* map, const sz capacity)
+{
+	as_string_map_entry* entries = AS_MALLOC_WITH_TYPE(sizeof(as_string_map_entry) * capacity, "as_string_map_entry");
+	if (!entries) { return false; }
+
+	const sz mask = capacity - 1;
+	for (sz i = 0; i < map->capacity; i++)
+	{
+		const as_string_map_entry* entry = &map->entries[i];
+		if (entry->hash <= 1) { continue; }
+		sz j = entry->hash & mask;
+		while (entries[j].hash != 0) { j = (j + 1) & mask; }
+		entries[j] = *entry;
+	}
+	if (map->entries) { AS_FREE(map->entries); }
+	map->entries = entries;
+	map->capacity = capacity;
+	map->removed_count = 0;
+	return true;
+}
+
+b8 as_string_map_set(as_string_map* map, const char* key, void* value)
+{
+	AS_ASSERT(map, "Cannot set string map value, invalid map");
+	AS_WARNING_RETURN_VAL_IF_FALSE(key, false, "Cannot set string map value, invalid key");
+	const u64 hash = as_string_hash(key);
+
+	as_string_map_entry* existing = as_string_map_find(map, key, hash);
+	if (existing)
+	{
+		existing->value = value;
+		return true;
+	}
+
+	if ((f64)(map->size + map->removed_count + 1) > (f64)map->capacity * AS_STRING_MAP_MAX_LOAD)
+	{
+		// only grow when live entries need it, otherwise rehashing at the same size drops the removed ones
+		sz capacity = map->capacity > 0 ? map->capacity : AS_STRING_MAP_MIN_CAPACITY;
+		while ((f64)(map->size + 1) > (f64)capacity * AS_STRING_MAP_MAX_LOAD / 2) { capacity *= 2; }
+		if (!as_string_map_resize(map, capacity)) { return false; }
+	}
+
+	const sz key_size = strlen(key) + 1;
+	char* key_copy = AS_MALLOC_WITH_TYPE(key_size, "char");
+	if (!key_copy) { return false; }
+	memcpy(key_copy, key, key_size);
+
+	const sz mask = map->capacity - 1;
+	sz i = hash & mask;
+	while (map->entries[i].hash > 1) { i = (i + 1) & mask; }
+	if (map->entries[i].hash == 1) { map->removed_count--; }
+	map->entries[i].hash = hash;
+	map->entries[i].key = key_copy;
+	map->entries[i].value = value;
+	map->size++;
+	return true;
+}
+
+void* as_string_map_get(const as_string_map* map, const char* key)
+{
+	if (!map || !key) { return NULL; }
+	const as_string_map_entry* entry = as_string_map_find(map, key, as_string_hash(key));
+	return entry ? entry->value : NULL;
+}
+
+b8 as_string_map_remove(as_string_map* map, const char* key)
+{
+	if (!map || !key) { return false; }
+	as_string_map_entry* entry = as_string_map_find(map, key, as_string_hash(key));
+	if (!entry) { return false; }
+	AS_FREE(entry->key);
+	entry->key = NULL;
+	entry->value = NULL;
+	entry->hash = 1;
+	map->size--;
+	map->removed_count++;
+	return true;
+}
+
+void as_string_map_destroy(as_string_map* map)
+{
+	if (!map || !map->entries) { return; }
+	for (sz i = 0; i < map->capacity; i++)
+	{
+		if (map->entries[i].hash > 1) { AS_FREE(map->entries[i].key); }
+	}
+	AS_FREE(map->entries);
+	memset(map, 0, sizeof(as_string_map));
+}
+
+static u32 as_histogram_get_bucket(const u64 value)
+{
+	if (value < 4) { return (u32)value; }
+	const u32 msb = 63 - as_clz64(value);
+	return (msb - 1) * 4 + (u32)((value >> (msb - 2)) & 3);
+}
+
+// highest value that lands in the bucket
+static u64 as_histogram_get_bucket_limit(const u32 bucket)
+{
+	if (bucket < 4) { return bucket; }
+	const u32 msb = bucket / 4 + 1;
+	return ((u64)(4 + bucket % 4 + 1) << (msb - 2)) - 1;
+}
+
+void as_histogram_record(as_histogram* histogram, const u64 value)
+{
+	AS_ATOMIC_ADD_I64(&histogram->buckets[as_histogram_get_bucket(value)], 1);
+	AS_ATOMIC_ADD_I64(&histogram->count, 1);
+	i64 max = AS_ATOMIC_LOAD_I64(&histogram->max);
+	while ((i64)value > max && !AS_ATOMIC_CAS_I64(&histogram->max, max, (i64)value))
+	{
+		max = AS_ATOMIC_LOAD_I64(&histogram->max);
+	}
+}
+
+u64 as_histogram_get_percentile(as_histogram* histogram, const f64 percentile)
+{
+	const i64 count = AS_ATOMIC_LOAD_I64(&histogram->count);
+	if (count <= 0) { return 0; }
+	const u64 max = (u64)AS_ATOMIC_LOAD_I64(&histogram->max);
+	i64 rank = (i64)(percentile * (f64)count + .5);
+	if (rank < 1) { rank = 1; }
+	i64 seen = 0;
+	for (u32 bucket = 0; bucket < AS_HISTOGRAM_BUCKETS_COUNT; bucket++)
+	{
+		seen += AS_ATOMIC_LOAD_I64(&histogram->buckets[bucket]);
+		if (seen >= rank)
+		{
+			const u64 limit = as_histogram_get_bucket_limit(bucket);
+			return limit < max ? limit : max;
+		}
+	}
+	return max;
+}
+
+as_histogram_summary as_histogram_summarize(as_histogram* histogram)
+{
+	as_histogram_summary summary = { 0 };
+	summary.count = AS_ATOMIC_LOAD_I64(&histogram->count);
+	summary.p50 = as_histogram_get_percentile(histogram, .50);
+	summary.p95 = as_histogram_get_percentile(histogram, .95);
+	summary.p99 = as_histogram_get_percentile(histogram, .99);
+	summary.max = (u64)AS_ATOMIC_LOAD_I64(&histogram->max);
+	return summary;
+}
+
+void as_histogram_reset(as_histogram* histogram)
+{
+	for (u32 bucket = 0; bucket < AS_HISTOGRAM_BUCKETS_COUNT; bucket++)
+	{
+		AS_ATOMIC_STORE_I64(&histogram->buckets[bucket], 0);
+	}
+	AS_ATOMIC_STORE_I64(&histogram->count, 0);
+	AS_ATOMIC_STORE_I64(&histogram->max, 0);
+}
+
 void as_i32_to_str(const i32 integer, char* out_str)
 {
 	sprintf(out_str, "%d", integer);
@@ -47,7 +228,7 @@ char* as_util_read_file(const char* path, sz* size)
 	*size = ftell(file);
 	fseek(file, 0, SEEK_SET);
 
-	char* content = (char*)AS_MALLOC(*size + 1);
+	char* content = (char*)AS_MALLOC_TAGGED(*size + 1, "char", AS_MEMORY_TAG_IO);
 	if (content)
 	{
 		fread(content, 1, *size, file);
@@ -283,6 +464,21 @@ void sleep_seconds(const f64 seconds)
 #endif
 }
 
+f64 get_monotonic_time()
+{
+#ifdef _WIN32
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (f64)counter.QuadPart / (f64)frequency.QuadPart;
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (f64)now.tv_sec + (f64)now.tv_nsec * 1e-9;
+#endif
+}
+
 void as_serialize_to_file(void* data, const sz size, const char* path)
 {
 	as_util_ensure_directory_exists(path);
@@ -294,7 +490,7 @@ void as_serialize_to_file(void* data, const sz size, const char* path)
 
 void* as_deserialize_from_file(const sz size, const char* path)
 {
-	void* data = (void*)AS_MALLOC(size); 
+	void* data = AS_MALLOC_TAGGED(size, "", AS_MEMORY_TAG_IO); 
     FILE* file = fopen(path, "rb"); 
     if (file) 
 	{ 
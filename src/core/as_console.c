@@ -28,17 +28,20 @@ typedef struct as_console_command
 as_command_mapping* as_console_find_command_mapping(as_console* console, const char* command_name)
 {
 	AS_ASSERT(console, "Cannot find command mapping, invalid console");
-	for (sz i = 0; i < AS_ARRAY_GET_SIZE(console->mappings); ++i)
-	{
-		as_command_mapping* mapped_cmd = AS_ARRAY_GET(console->mappings, i);
-		if (!mapped_cmd || !mapped_cmd->func) continue;
+	as_command_mapping* mapped_cmd = as_string_map_get(&console->mappings_by_name, command_name);
+	return mapped_cmd && mapped_cmd->func ? mapped_cmd : NULL;
+}
 
-		if (strcmp(command_name, mapped_cmd->name) == 0)
-		{
-			return mapped_cmd;
-		}
-	}
-	return NULL;
+as_command_mapping* as_console_add_mapping(as_console* console, const as_command_mapping* mapping)
+{
+	AS_ASSERT(console, "Cannot add command mapping, invalid console");
+	AS_ASSERT(mapping, "Cannot add command mapping, invalid mapping");
+
+	as_command_mapping* added_mapping = AS_ARRAY_INCREMENT(console->mappings);
+	AS_WARNING_RETURN_VAL_IF_FALSE(added_mapping, NULL, "Cannot add command mapping %s, too many mappings", mapping->name);
+	*added_mapping = *mapping;
+	as_string_map_set(&console->mappings_by_name, added_mapping->name, added_mapping);
+	return added_mapping;
 }
 
 void as_console_execute_command(as_console* console, as_console_command* cmd)
@@ -50,31 +53,26 @@ void as_console_execute_command(as_console* console, as_console_command* cmd)
 		return;
 	}
 	
-	for (sz i = 0; i < AS_ARRAY_GET_SIZE(console->mappings); ++i) 
+	as_command_mapping* mapped_cmd = as_console_find_command_mapping(console, cmd->command);
+	if (mapped_cmd)
 	{
-		as_command_mapping* mapped_cmd = AS_ARRAY_GET(console->mappings, i);
-		if (!mapped_cmd || !mapped_cmd->func) continue;
-
-		if (strcmp(cmd->command, mapped_cmd->name) == 0)
+		if (mapped_cmd->arg_count == 0) 
 		{
-			if (mapped_cmd->arg_count == 0) 
-			{
-				mapped_cmd->func(NULL, NULL, NULL);
-			}
-			else if (mapped_cmd->arg_count == 1)
-			{
-				mapped_cmd->func(cmd->argument[0], NULL, NULL);
-			}
-			else if (mapped_cmd->arg_count == 2)
-			{
-				mapped_cmd->func(cmd->argument[0], cmd->argument[1], NULL);
-			}
-			else if (mapped_cmd->arg_count == 3)
-			{
-				mapped_cmd->func(cmd->argument[0], cmd->argument[1], cmd->argument[2]);
-			}
-			return;
+			mapped_cmd->func(NULL, NULL, NULL);
+		}
+		else if (mapped_cmd->arg_count == 1)
+		{
+			mapped_cmd->func(cmd->argument[0], NULL, NULL);
 		}
+		else if (mapped_cmd->arg_count == 2)
+		{
+			mapped_cmd->func(cmd->argument[0], cmd->argument[1], NULL);
+		}
+		else if (mapped_cmd->arg_count == 3)
+		{
+			mapped_cmd->func(cmd->argument[0], cmd->argument[1], cmd->argument[2]);
+		}
+		return;
 	}
 	AS_FLOG(LV_LOG, "Unknown command: %s\n", cmd->command);
 }
@@ -116,6 +114,7 @@ as_console* as_console_create()
 	as_console* console = AS_MALLOC_SINGLE(as_console);
 	console->is_running = true;
 	console->thread = as_thread_create(as_console_process_input, console);
+	as_thread_set_name(console->thread, "as_console");
 	return console;
 }
 
@@ -149,6 +148,7 @@ void as_console_destroy(as_console* console)
 	{
 		console->is_running = false;
 		as_thread_terminate(console->thread);
+		as_string_map_destroy(&console->mappings_by_name);
 		AS_FREE(console);
 	}
 }
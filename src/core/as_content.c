@@ -3,10 +3,29 @@
 #include "core/as_content.h"
 #include "as_types.h"
 #include "as_memory.h"
+#include "core/as_render.h"
+#include "core/as_shapes.h"
+
+void as_content_free_asset_ptr(as_asset* asset)
+{
+	// generated shapes and made shaders live in slabs, registered assets can come from anywhere
+	if (asset->type == AS_ASSET_TYPE_SHAPE && as_slab_owns(&as_shapes_slab, asset->ptr))
+	{
+		as_slab_free(&as_shapes_slab, asset->ptr);
+	}
+	else if (asset->type == AS_ASSET_TYPE_SHADER && as_slab_owns(&as_shaders_slab, asset->ptr))
+	{
+		as_shader_free(asset->ptr);
+	}
+	else
+	{
+		AS_FREE(asset->ptr);
+	}
+}
 
 as_content* as_content_create()
 {
-	as_content* content = AS_MALLOC_SINGLE(as_content);
+	as_content* content = AS_MALLOC_SINGLE_TAGGED(as_content, AS_MEMORY_TAG_CONTENT);
 	AS_SET_VALID(content);
 	return content;
 }
@@ -17,19 +36,23 @@ void as_content_destroy(as_content* content)
 	{
 		return;
 	}
-	for (sz i = 0 ; i < AS_ARRAY_GET_SIZE(content->assets) ; i++)
+	for (sz i = 0 ; i < AS_VECTOR_GET_SIZE(content->assets) ; i++)
 	{
-		as_asset* asset = AS_ARRAY_GET(content->assets, i);
+		as_asset* asset = AS_VECTOR_GET(content->assets, i);
 		if (AS_IS_VALID(asset))
 		{
 			if (asset->destory_func_ptr)
 			{
 				asset->destory_func_ptr(asset->ptr);
 			}
-			AS_FREE(asset->ptr); // Maybe have to check each type and clear it accordingly
+			if (asset->free_on_destruction)
+			{
+				as_content_free_asset_ptr(asset); // Maybe have to check each type and clear it accordingly
+			}
 			AS_SET_INVALID(asset);
 		}
 	}
+	AS_VECTOR_FREE(content->assets);
 	AS_FREE(content);
 }
 
@@ -38,8 +61,8 @@ extern i32 as_content_add_asset(as_content* content, void* ptr, const as_asset_t
 	AS_ASSERT(content, "Cannot add asset to content, NULL content");
 	AS_ASSERT(ptr, "Cannot add asset to content, NULL ptr");
 
-	as_asset* asset = AS_ARRAY_INCREMENT(content->assets);
-	AS_ASSERT(asset, "Cannot add asset to content, asset array could be full");
+	as_asset* asset = AS_VECTOR_INCREMENT(content->assets);
+	AS_ASSERT(asset, "Cannot add asset to content, could not grow the asset array");
 
 	asset->ptr = ptr;
 	asset->type = type;
@@ -48,13 +71,14 @@ extern i32 as_content_add_asset(as_content* content, void* ptr, const as_asset_t
 	
 	AS_SET_VALID(asset);
 
-	return AS_ARRAY_GET_LAST_INDEX(content->assets);
+	return (i32)AS_VECTOR_GET_LAST_INDEX(content->assets);
 }
 
 void as_content_remove_asset(as_content* content, const sz index, const bool destroy)
 {
 	AS_ASSERT(content, "Cannot remove asset from content, NULL content");
-	as_asset* asset = AS_ARRAY_GET(content->assets, index);
+	AS_WARNING_RETURN_IF_FALSE((index < AS_VECTOR_GET_SIZE(content->assets)), "Cannot remove asset %zu, index out of bounds", index);
+	as_asset* asset = AS_VECTOR_GET(content->assets, index);
 	if (AS_IS_VALID(asset))
 	{
 		if (destroy)
@@ -65,17 +89,18 @@ void as_content_remove_asset(as_content* content, const sz index, const bool des
 			}
 			if (asset->free_on_destruction)
 			{
-				AS_FREE(asset->ptr);
+				as_content_free_asset_ptr(asset);
 			}
 		}
 		AS_SET_INVALID(asset);
 	}
 	asset->ptr = NULL;
-	AS_ARRAY_REMOVE_AT(content->assets, index);
+	AS_VECTOR_REMOVE_AT(content->assets, index);
 }
 
 as_asset* as_content_get_asset(as_content* content, const sz index)
 {
 	AS_ASSERT(content, "Cannot get asset, NULL content");
-	return AS_ARRAY_GET(content->assets, index);
+	if (index >= AS_VECTOR_GET_SIZE(content->assets)) { return NULL; }
+	return AS_VECTOR_GET(content->assets, index);
 }
@@ -12,24 +12,26 @@ void as_input_add(as_input_buffer* buffer, const i32 key, const i32 action)
     new_key.key = key;
     new_key.action = action;
     
-    AS_ARRAY_INSERT_AT(buffer->keys, 0, new_key);
-    if(AS_ARRAY_GET_SIZE(buffer->keys) > AS_MAX_INPUT_BUFFER_SIZE)
+    // events are produced and read on the main thread, so the producer can also drop the oldest
+    if (AS_RING_GET_SIZE(buffer->keys) == AS_RING_CAPACITY(buffer->keys))
     {
-        AS_ARRAY_REMOVE_AT(buffer->keys, AS_ARRAY_GET_LAST_INDEX(buffer->keys));
+        AS_RING_POP_FRONT(buffer->keys);
     }
-    if(buffer->on_add)
+    bool pushed = false;
+    AS_RING_PUSH(buffer->keys, new_key, pushed);
+    if(pushed && buffer->on_add)
     {    
-        buffer->on_add(AS_ARRAY_GET(buffer->keys, 0));
+        buffer->on_add(AS_RING_AT(buffer->keys, AS_RING_GET_SIZE(buffer->keys) - 1));
     }
 }
 
 bool as_input_is_pressed(as_input_buffer* buffer, const i32 key)
 {
     AS_ASSERT(buffer, "Trying to read buffer, but buffer is NULL");
-    for(sz i = 0 ; i < buffer->keys.size ; i++)
+    for(sz i = AS_RING_GET_SIZE(buffer->keys) ; i > 0 ; i--) // newest first
     {
-        as_input_key* current_key = AS_ARRAY_GET(buffer->keys, i);
-        if (current_key && current_key->key == key)
+        const as_input_key* current_key = AS_RING_AT(buffer->keys, i - 1);
+        if (current_key->key == key)
         {
             return (current_key->action == AS_PRESS || current_key->action == AS_REPEAT);
         }
@@ -40,10 +42,10 @@ bool as_input_is_pressed(as_input_buffer* buffer, const i32 key)
 bool as_input_is_released(as_input_buffer* buffer, const i32 key)
 {
 	AS_ASSERT(buffer, "Trying to read buffer, but buffer is NULL");
-	for (sz i = 0; i < buffer->keys.size; i++)
+	for (sz i = AS_RING_GET_SIZE(buffer->keys); i > 0; i--) // newest first
 	{
-		as_input_key* current_key = AS_ARRAY_GET(buffer->keys, i);
-		if (current_key && current_key->key == key)
+		const as_input_key* current_key = AS_RING_AT(buffer->keys, i - 1);
+		if (current_key->key == key)
 		{
 			return (current_key->action == AS_RELEASE);
 		}
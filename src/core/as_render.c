@@ -8,21 +8,12 @@
 #include <GLFW/glfw3.h>
 #include <vulkan/vulkan.h>
 
-#if defined (_WIN32)
-#include <vulkan/vulkan_win32.h>
-#define VK_KHR_PLATFORM_SURFACE_EXTENSION_NAME VK_KHR_WIN32_SURFACE_EXTENSION_NAME
-#elif defined(__linux__)
-#include <vulkan/vulkan_xcb.h>
-#define VK_KHR_PLATFORM_SURFACE_EXTENSION_NAME VK_KHR_XCB_SURFACE_EXTENSION_NAME
-#elif defined(__ANDROID__)
-#include <vulkan/vulkan_android.h>
-#define VK_KHR_PLATFORM_SURFACE_EXTENSION_NAME VK_KHR_XCB_SURFACE_EXTENSION_NAME
-#endif
-
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
 #define AS_USE_VULKAN_VALIDATION_LAYER 1
+#define AS_MAX_INSTANCE_EXTENSIONS 16
+#define AS_HEADLESS_IMAGE_FORMAT VK_FORMAT_B8G8R8A8_SRGB // same as the preferred swap chain format
 
 
 static clock_t start_time = 0;
@@ -33,21 +24,13 @@ typedef struct queue_family_indices
 	u32 present_family;
 } queue_family_indices;
 
-const char* instance_extensions[] = 
-{
-	VK_KHR_SURFACE_EXTENSION_NAME,
-	VK_KHR_PLATFORM_SURFACE_EXTENSION_NAME,
-#if AS_USE_VULKAN_VALIDATION_LAYER
-	VK_EXT_DEBUG_UTILS_EXTENSION_NAME
-#endif
-};
-const u32 instance_extensions_count = AS_ARRAY_SIZE(instance_extensions);
 const char* device_extensions[] =
 {
-	VK_KHR_SWAPCHAIN_EXTENSION_NAME,
-	VK_KHR_MAINTENANCE1_EXTENSION_NAME
+	VK_KHR_MAINTENANCE1_EXTENSION_NAME,
+	VK_KHR_SWAPCHAIN_EXTENSION_NAME // last, headless renders do not enable it
 };
 const u32 device_extensions_count = AS_ARRAY_SIZE(device_extensions);
+#define AS_GET_DEVICE_EXTENSIONS_COUNT(_render) ((_render)->is_headless ? device_extensions_count - 1 : device_extensions_count)
 
 const char* validation_layers[] =
 {
@@ -149,20 +132,7 @@ void as_get_attribute_descriptions(VkVertexInputAttributeDescription* attribute_
 	attribute_descriptions[3].offset = offsetof(as_vertex, tex_coord);
 }
 
-bool is_device_suitable(VkPhysicalDevice device) 
-{
-	VkPhysicalDeviceProperties device_properties;
-	vkGetPhysicalDeviceProperties(device, &device_properties);
-	VkPhysicalDeviceFeatures device_features;
-	vkGetPhysicalDeviceFeatures(device, &device_features);
-
-	// Example criteria for device suitability
-	const bool is_discrete_gpu = device_properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU;
-	const bool has_geometry_shader = device_features.geometryShader;
-
-	return is_discrete_gpu && has_geometry_shader;
-}
-
+// no surface for headless renders, the graphics family presents then
 queue_family_indices find_queue_families(const VkPhysicalDevice device, const VkSurfaceKHR surface) 
 {
 	queue_family_indices indices = { UINT32_MAX,  UINT32_MAX};
@@ -170,7 +140,14 @@ queue_family_indices find_queue_families(const VkPhysicalDevice device, const Vk
 	u32 queue_family_count = 0;
 	vkGetPhysicalDeviceQueueFamilyProperties(device, &queue_family_count, NULL);
 
-	VkQueueFamilyProperties* queue_families = (VkQueueFamilyProperties*)AS_MALLOC(queue_family_count * sizeof(VkQueueFamilyProperties));
+	as_arena* frame_arena = as_arena_get_frame();
+	const as_arena_mark frame_mark = as_arena_get_mark(frame_arena);
+	VkQueueFamilyProperties* queue_families = AS_ARENA_ALLOC_ARRAY(frame_arena, VkQueueFamilyProperties, queue_family_count);
+	if (!queue_families)
+	{
+		AS_LOG(LV_ERROR, "Cannot find queue families, could not allocate them");
+		return indices;
+	}
 	vkGetPhysicalDeviceQueueFamilyProperties(device, &queue_family_count, queue_families);
 
 	for (u32 j = 0; j < queue_family_count; ++j) 
@@ -181,7 +158,10 @@ queue_family_indices find_queue_families(const VkPhysicalDevice device, const Vk
 		}
 
 		VkBool32 present_support = false;
-		vkGetPhysicalDeviceSurfaceSupportKHR(device, j, surface, &present_support);
+		if (surface != VK_NULL_HANDLE)
+		{
+			vkGetPhysicalDeviceSurfaceSupportKHR(device, j, surface, &present_support);
+		}
 
 		if (present_support) 
 		{
@@ -193,10 +173,65 @@ queue_family_indices find_queue_families(const VkPhysicalDevice device, const Vk
 			break;
 		}
 	}
-	AS_FREE(queue_families);
+	as_arena_rewind(frame_arena, frame_mark);
+	if (surface == VK_NULL_HANDLE)
+	{
+		indices.present_family = indices.graphics_family;
+	}
 	return indices;
 }
 
+bool has_device_extensions(as_render* render, const VkPhysicalDevice device)
+{
+	u32 extension_count = 0;
+	vkEnumerateDeviceExtensionProperties(device, NULL, &extension_count, NULL);
+
+	as_arena* frame_arena = as_arena_get_frame();
+	const as_arena_mark frame_mark = as_arena_get_mark(frame_arena);
+	VkExtensionProperties* extensions = AS_ARENA_ALLOC_ARRAY(frame_arena, VkExtensionProperties, extension_count);
+	if (!extensions)
+	{
+		AS_LOG(LV_ERROR, "Cannot check device extensions, could not allocate them");
+		return false;
+	}
+	vkEnumerateDeviceExtensionProperties(device, NULL, &extension_count, extensions);
+
+	u32 found_count = 0;
+	for (u32 i = 0; i < AS_GET_DEVICE_EXTENSIONS_COUNT(render); i++)
+	{
+		for (u32 j = 0; j < extension_count; j++)
+		{
+			if (strcmp(device_extensions[i], extensions[j].extensionName) == 0)
+			{
+				found_count++;
+				break;
+			}
+		}
+	}
+	as_arena_rewind(frame_arena, frame_mark);
+	return found_count == AS_GET_DEVICE_EXTENSIONS_COUNT(render);
+}
+
+// 0 when the device cannot be used, otherwise higher is better. cpu devices come last but are accepted, they are what ci machines have
+u32 rate_device(as_render* render, const VkPhysicalDevice device)
+{
+	const queue_family_indices indices = find_queue_families(device, render->surface);
+	if (indices.graphics_family == UINT32_MAX || indices.present_family == UINT32_MAX || !has_device_extensions(render, device))
+	{
+		return 0;
+	}
+
+	VkPhysicalDeviceProperties device_properties;
+	vkGetPhysicalDeviceProperties(device, &device_properties);
+	switch (device_properties.deviceType)
+	{
+	case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:		return 4;
+	case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:	return 3;
+	case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:		return 2;
+	default:										return 1; // cpu and other
+	}
+}
+
 VkFormat find_supported_format(as_render* render, const VkFormat* candidates, sz candidate_count, VkImageTiling tiling, VkFormatFeatureFlags features) 
 {
 	for (sz i = 0; i < candidate_count; ++i) 
@@ -229,6 +264,27 @@ bool has_stencil_component(VkFormat format) {
 	return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
 }
 
+// glfw knows the surface extensions of the platform (win32, xlib, xcb, wayland...), headless renders need none
+u32 get_instance_extensions(as_render* render, const char** out_extensions)
+{
+	u32 count = 0;
+	if (!render->is_headless)
+	{
+		u32 glfw_count = 0;
+		const char** glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_count);
+		AS_ASSERT(glfw_extensions, "Vulkan cannot present on this platform");
+		for (u32 i = 0; i < glfw_count && count < AS_MAX_INSTANCE_EXTENSIONS; i++)
+		{
+			out_extensions[count++] = glfw_extensions[i];
+		}
+	}
+	if (AS_USE_VULKAN_VALIDATION_LAYER && count < AS_MAX_INSTANCE_EXTENSIONS)
+	{
+		out_extensions[count++] = VK_EXT_DEBUG_UTILS_EXTENSION_NAME;
+	}
+	return count;
+}
+
 void create_instance(as_render* render)
 {
 	VkApplicationInfo app_info = {0};
@@ -242,7 +298,8 @@ void create_instance(as_render* render)
 	VkInstanceCreateInfo create_info = {0};
 	create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
 	create_info.pApplicationInfo = &app_info;
-	create_info.enabledExtensionCount = instance_extensions_count;
+	const char* instance_extensions[AS_MAX_INSTANCE_EXTENSIONS] = { 0 };
+	create_info.enabledExtensionCount = get_instance_extensions(render, instance_extensions);
 	create_info.ppEnabledExtensionNames = instance_extensions;
 	VkDebugUtilsMessengerCreateInfoEXT debug_create_info = {0};
 	populate_debug_messenger_create_info(&debug_create_info);
@@ -267,19 +324,32 @@ void pick_physical_device(as_render* render)
 	vkEnumeratePhysicalDevices(render->instance, &device_count, NULL);
 	AS_ASSERT(device_count > 0, "Failed to find GPUs with Vulkan support\n");
 
-	VkPhysicalDevice* devices = (VkPhysicalDevice*)AS_MALLOC(device_count * sizeof(VkPhysicalDevice));
+	as_arena* frame_arena = as_arena_get_frame();
+	const as_arena_mark frame_mark = as_arena_get_mark(frame_arena);
+	VkPhysicalDevice* devices = AS_ARENA_ALLOC_ARRAY(frame_arena, VkPhysicalDevice, device_count);
+	if (!devices)
+	{
+		AS_LOG(LV_ERROR, "Cannot pick a physical device, could not allocate the devices list");
+		return;
+	}
 	vkEnumeratePhysicalDevices(render->instance, &device_count, devices);
 
+	u32 best_rate = 0;
 	for (u32 i = 0; i < device_count; i++)
 	{
-		if (is_device_suitable(devices[i]))
+		const u32 rate = rate_device(render, devices[i]);
+		if (rate > best_rate)
 		{
+			best_rate = rate;
 			render->physical_device = devices[i];
-			break;
 		}
 	}
-	AS_FREE(devices);
+	as_arena_rewind(frame_arena, frame_mark);
 	AS_ASSERT(render->physical_device, "Failed to find a suitable GPU");
+
+	VkPhysicalDeviceProperties device_properties;
+	vkGetPhysicalDeviceProperties(render->physical_device, &device_properties);
+	AS_FLOG(LV_LOG, "Picked device %s", device_properties.deviceName);
 }
 
 void create_surface(as_render* render, void* display_context) 
@@ -298,9 +368,10 @@ void create_logical_device(as_render* render)
 		indices.graphics_family,
 		indices.present_family
 	};
+	const u32 unique_queue_families_count = indices.graphics_family == indices.present_family ? 1 : 2;
 
 	f32 queue_priority = 1.0f;
-	for (u32 i = 0; i < 2; i++)
+	for (u32 i = 0; i < unique_queue_families_count; i++)
 	{
 		VkDeviceQueueCreateInfo queue_create_info = {0};
 		queue_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
@@ -315,10 +386,10 @@ void create_logical_device(as_render* render)
 
 	VkDeviceCreateInfo create_info = {0};
 	create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-	create_info.queueCreateInfoCount = 2;
+	create_info.queueCreateInfoCount = unique_queue_families_count;
 	create_info.pQueueCreateInfos = queue_create_infos;
 	create_info.pEnabledFeatures = &device_features;
-	create_info.enabledExtensionCount = device_extensions_count;
+	create_info.enabledExtensionCount = AS_GET_DEVICE_EXTENSIONS_COUNT(render);
 	create_info.ppEnabledExtensionNames = device_extensions;
 
 	if (AS_USE_VULKAN_VALIDATION_LAYER) 
@@ -506,7 +577,7 @@ void create_render_pass(as_render* render)
 	color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	color_attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	color_attachment.finalLayout = render->is_headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
 	VkAttachmentDescription depth_attachment = { 0 };
 	depth_attachment.format = find_depth_format(render);
@@ -535,11 +606,22 @@ void create_render_pass(as_render* render)
 	VkSubpassDependency dependency = { 0 };
 	dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
 	dependency.dstSubpass = 0;
-	dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-	dependency.srcAccessMask = 0;
+	// the depth image is shared by the frames in flight, the previous frame must be done writing it
+	dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 	dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
 	dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
+	// headless frames may be copied to a readback buffer right after the pass
+	VkSubpassDependency readback_dependency = { 0 };
+	readback_dependency.srcSubpass = 0;
+	readback_dependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+	readback_dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	readback_dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	readback_dependency.dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	readback_dependency.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+	VkSubpassDependency dependencies[] = { dependency, readback_dependency };
 	VkAttachmentDescription attachments[] = { color_attachment, depth_attachment };
 	VkRenderPassCreateInfo render_pass_info = { 0 };
 	render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -547,24 +629,13 @@ void create_render_pass(as_render* render)
 	render_pass_info.pAttachments = attachments;
 	render_pass_info.subpassCount = 1;
 	render_pass_info.pSubpasses = &subpass;
-	render_pass_info.dependencyCount = 1;
-	render_pass_info.pDependencies = &dependency;
+	render_pass_info.dependencyCount = render->is_headless ? 2 : 1;
+	render_pass_info.pDependencies = dependencies;
 
 	AS_ASSERT(vkCreateRenderPass(render->device, &render_pass_info, NULL, &render->render_pass) == VK_SUCCESS,
 		"Failed to create render pass");
 }
 
-void as_shader_set_locked(const u64 frame_count, as_shader* shader)
-{
-	shader->refresh_frame = frame_count;
-	AS_WAIT_AND_LOCK(shader);
-}
-
-void as_shader_set_unlocked(as_shader* shader)
-{
-	AS_UNLOCK(shader);
-}
-
 bool as_shader_is_unlocked(const u64 frame_count, as_shader* shader)
 {
 	return shader->refresh_frame + 10 < frame_count && AS_IS_UNLOCKED(shader);
@@ -575,7 +646,14 @@ void as_shader_create_descriptor_set_layout(as_shader* shader)
 	AS_ASSERT(&shader->uniforms, "Cannot create_descriptor_set_layout_from_uniforms, NULL uniforms");
 
 	const sz bindings_count = (shader->uniforms.size + 1); // ubo + uniforms
-	VkDescriptorSetLayoutBinding* bindings = AS_MALLOC(sizeof(VkDescriptorSetLayoutBinding) * bindings_count);
+	as_arena* frame_arena = as_arena_get_frame();
+	const as_arena_mark frame_mark = as_arena_get_mark(frame_arena);
+	VkDescriptorSetLayoutBinding* bindings = AS_ARENA_ALLOC_ARRAY(frame_arena, VkDescriptorSetLayoutBinding, bindings_count);
+	if (!bindings)
+	{
+		AS_LOG(LV_ERROR, "Cannot create descriptor set layout, could not allocate the bindings");
+		return;
+	}
 
 	VkDescriptorSetLayoutBinding ubo_layout_binding = { 0 };
 	ubo_layout_binding.binding = 0;
@@ -606,7 +684,7 @@ void as_shader_create_descriptor_set_layout(as_shader* shader)
 
 	AS_ASSERT(vkCreateDescriptorSetLayout(*shader->device, &layout_info, NULL, &shader->descriptor_set_layout) == VK_SUCCESS,
 		"Failed to create descriptor set layout!");
-	AS_FREE(bindings);
+	as_arena_rewind(frame_arena, frame_mark);
 }
 
 VkShaderModule create_shader_module(VkDevice device, as_shader_binary* shader_bin)
@@ -966,11 +1044,25 @@ void create_command_buffers(as_render* render)
 		"Failed to allocate command buffers");
 }
 
+// one per swap chain image, the presentation of an image may still wait on it after the fence of its frame signaled
+void create_render_finished_semaphores(as_render* render)
+{
+	VkSemaphoreCreateInfo semaphore_info = { 0 };
+	semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	for (sz i = render->render_finished_semaphores.size; i < render->swap_chain_images.size; i++)
+	{
+		const VkResult create_result = vkCreateSemaphore(render->device, &semaphore_info, NULL, &render->render_finished_semaphores.data[i]);
+		AS_ASSERT(create_result == VK_SUCCESS, "Failed to create render finished semaphore");
+		render->render_finished_semaphores.size = i + 1;
+	}
+}
+
 void create_sync_objects(as_render* render) 
 {
 	render->image_available_semaphores.size = MAX_FRAMES_IN_FLIGHT;
-	render->render_finished_semaphores.size = MAX_FRAMES_IN_FLIGHT;
 	render->in_flight_fences.size = MAX_FRAMES_IN_FLIGHT;
+	create_render_finished_semaphores(render);
 
 	VkSemaphoreCreateInfo semaphore_info = { 0 };
 	semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -982,9 +1074,8 @@ void create_sync_objects(as_render* render)
 	for (sz i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) 
 	{
 		const VkResult image_available_semaphore_create_res = vkCreateSemaphore(render->device, &semaphore_info, NULL, &render->image_available_semaphores.data[i]);
-		const VkResult render_finished_semaphore_create_res = vkCreateSemaphore(render->device, &semaphore_info, NULL, &render->render_finished_semaphores.data[i]);
 		const VkResult in_flight_fence_create_res = vkCreateFence(render->device, &fence_info, NULL, &render->in_flight_fences.data[i]);
-		AS_ASSERT(image_available_semaphore_create_res && render_finished_semaphore_create_res && in_flight_fence_create_res, "Failed to create synchronization objects for a frame!");
+		AS_ASSERT(image_available_semaphore_create_res == VK_SUCCESS && in_flight_fence_create_res == VK_SUCCESS, "Failed to create synchronization objects for a frame!");
 	}
 }
 
@@ -993,14 +1084,15 @@ as_mat4 as_get_camera_view_matrix(as_camera* camera)
 	return as_mat4_look_at(&camera->position, &camera->target, &camera->up);
 }
 
-void update_shader_uniform_buffer(as_render* render, as_scene* scene, as_shader* shader, as_camera* camera, const u32 current_image)
+// frame_slot is render->current_frame, its fence was waited on so the gpu is not reading these buffers anymore
+void update_shader_uniform_buffer(as_render* render, const as_mat4* objects_transforms, const sz objects_size, as_shader* shader, as_camera* camera, const u32 frame_slot)
 {
 	as_uniform_buffer_object ubo = { 0 };
 	as_mat4_set_identity(&ubo.model);
-	if (scene)
+	if (objects_transforms)
 	{
-		memcpy(ubo.object_transforms, scene->gpu_data.objects_transforms, sizeof(ubo.object_transforms));
-		ubo.scene_info.m[0][0] = (f32)scene->objects.size;
+		memcpy(ubo.object_transforms, objects_transforms, sizeof(ubo.object_transforms));
+		ubo.scene_info.m[0][0] = (f32)objects_size;
 	}
 	if (camera)
 	{
@@ -1015,11 +1107,11 @@ void update_shader_uniform_buffer(as_render* render, as_scene* scene, as_shader*
 
 	if (shader->uniform_buffers.buffers_mapped.size != 0)
 	{
-		memcpy(shader->uniform_buffers.buffers_mapped.data[current_image], &ubo, sizeof(ubo));
+		memcpy(shader->uniform_buffers.buffers_mapped.data[frame_slot], &ubo, sizeof(ubo));
 	}
 }
 
-as_push_const_buffer get_push_const_buffer(const as_object* object, const as_camera* camera, const as_render* render)
+as_push_const_buffer get_push_const_buffer(const i32 object_gpu_index, const as_camera* camera, const as_render* render)
 {
 	as_mat4 buffer_data = {0};
 	buffer_data.m[0][0] = camera->position.x;
@@ -1031,7 +1123,7 @@ as_push_const_buffer get_push_const_buffer(const as_object* object, const as_cam
 	buffer_data.m[1][2] = camera->cached_direction.z;
 
 	buffer_data.m[2][0] = as_render_get_time(render);
-	buffer_data.m[2][1] = (f32)object->scene_gpu_index;
+	buffer_data.m[2][1] = (f32)object_gpu_index;
 
 	return (as_push_const_buffer)
 	{
@@ -1039,24 +1131,24 @@ as_push_const_buffer get_push_const_buffer(const as_object* object, const as_cam
 	};
 }
 
-void update_screen_object_uniform_buffer(as_render* render, as_screen_object* screen_object, const u32 current_image)
+void update_screen_object_uniform_buffer(as_render* render, as_screen_object* screen_object, const u32* custom_data, const u32 frame_slot)
 {
 	as_uniform_buffer_screen_object ubo = { 0 };
-	if (screen_object)
+	if (custom_data)
 	{
 		//memcpy(ubo.custom_info, screen_object->custom_info, sizeof(ubo.custom_info));
-		memcpy(ubo.custom_data, screen_object->custom_data, sizeof(ubo.custom_data));
+		memcpy(ubo.custom_data, custom_data, sizeof(ubo.custom_data));
 	}
-	if (screen_object->uniform_buffers.buffers_mapped.size != 0 && AS_ARRAY_GET_SIZE(screen_object->uniform_buffers.buffers_mapped) > current_image)
+	if (screen_object->uniform_buffers.buffers_mapped.size != 0 && AS_ARRAY_GET_SIZE(screen_object->uniform_buffers.buffers_mapped) > frame_slot)
 	{
-		memcpy(screen_object->uniform_buffers.buffers_mapped.data[current_image], &ubo, sizeof(ubo));
+		memcpy(screen_object->uniform_buffers.buffers_mapped.data[frame_slot], &ubo, sizeof(ubo));
 	}
 }
 
-as_push_const_buffer_screen_object get_push_const_buffer_screen_object(const as_screen_object* screen_object)
+as_push_const_buffer_screen_object get_push_const_buffer_screen_object(const as_mat4* data)
 {
 	as_mat4 buffer_data = { 0 };
-	memcpy(&buffer_data, &screen_object->data, sizeof(as_mat4));
+	memcpy(&buffer_data, data, sizeof(as_mat4));
 
 	return (as_push_const_buffer_screen_object)
 	{
@@ -1064,7 +1156,47 @@ as_push_const_buffer_screen_object get_push_const_buffer_screen_object(const as_
 	};
 }
 
-void record_command_buffer(as_render* render, VkCommandBuffer command_buffer, const u32 image_index, as_scene* scene, as_screen_objects_group* ui_objects_group)
+// the snapshot objects are still alive, removals go through the render queue behind the frames that captured them
+static as_object* as_render_snapshot_get_object(const as_render_snapshot* snapshot, const sz index)
+{
+	as_object* object = snapshot->objects[index];
+	const as_handle handle = snapshot->objects_handles[index];
+	if (AS_IS_INVALID(object) || object->handle.index != handle.index || object->handle.generation != handle.generation) { return NULL; }
+	return object;
+}
+
+// copies the offscreen image to the readback buffer of its slot, the render pass left it in transfer src layout
+void record_readback(as_render* render, VkCommandBuffer command_buffer, const u32 image_index)
+{
+	VkBufferImageCopy region = { 0 };
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.layerCount = 1;
+	region.imageExtent.width = render->swap_chain_extent.width;
+	region.imageExtent.height = render->swap_chain_extent.height;
+	region.imageExtent.depth = 1;
+	vkCmdCopyImageToBuffer(command_buffer, render->swap_chain_images.data[image_index], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, render->readback_buffers.data[image_index], 1, &region);
+
+	VkBufferMemoryBarrier barrier = { 0 };
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.buffer = render->readback_buffers.data[image_index];
+	barrier.size = VK_WHOLE_SIZE;
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, NULL, 1, &barrier, 0, NULL);
+	render->readback_frames[image_index] = render->frame_counter + 1;
+}
+
+// the fence of the slot was waited on, so its copy is done
+void deliver_readback(as_render* render, const u64 slot)
+{
+	if (render->readback_frames[slot] == 0) { return; }
+	render->readback_func(render->readback_user_data, (const u8*)render->readback_mapped.data[slot], render->swap_chain_extent.width, render->swap_chain_extent.height, render->readback_frames[slot] - 1);
+	render->readback_frames[slot] = 0;
+}
+
+void record_command_buffer(as_render* render, VkCommandBuffer command_buffer, const u32 image_index, as_scene* scene, as_screen_objects_group* ui_objects_group, const as_render_snapshot* snapshot)
 {
 	VkCommandBufferBeginInfo begin_info = { 0 };
 	begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -1090,7 +1222,7 @@ void record_command_buffer(as_render* render, VkCommandBuffer command_buffer, co
 	render_pass_info.pClearValues = clear_values;
 	render_pass_info.clearValueCount = AS_ARRAY_SIZE(clear_values);
 
-	as_camera* camera = as_camera_get_main(scene);
+	as_camera* camera = snapshot ? (as_camera*)&snapshot->camera : as_camera_get_main(scene);
 
 	vkCmdBeginRenderPass(command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
 	{
@@ -1109,13 +1241,15 @@ void record_command_buffer(as_render* render, VkCommandBuffer command_buffer, co
 		scissor.extent = render->swap_chain_extent;
 		vkCmdSetScissor(command_buffer, 0, 1, &scissor);
 
-		if (scene)
+		if (scene || snapshot)
 		{
-			for (sz obj_index = 0 ; obj_index < scene->objects.size ; obj_index++)
+			const sz objects_size = snapshot ? snapshot->objects_size : AS_HANDLE_TABLE_GET_SIZE(scene->objects);
+			for (sz obj_index = 0 ; obj_index < objects_size ; obj_index++)
 			{
-				as_object* object = AS_ARRAY_GET(scene->objects, obj_index);
+				as_object* object = snapshot ? as_render_snapshot_get_object(snapshot, obj_index) : AS_HANDLE_TABLE_GET_AT(scene->objects, as_object, obj_index);
+				if (!object || object->vertex_buffer == VK_NULL_HANDLE) { continue; } // its upload may still be behind in the background lane
 				as_shader* shader = object->shader;
-				as_push_const_buffer push_const = get_push_const_buffer(object, camera, render);
+				as_push_const_buffer push_const = get_push_const_buffer(snapshot ? (i32)obj_index : object->scene_gpu_index, camera, render);
 				if (!shader || !shader->graphics_pipeline || !as_shader_is_unlocked(render->frame_counter, shader)) { continue; }
 
 				vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, shader->graphics_pipeline);
@@ -1127,14 +1261,15 @@ void record_command_buffer(as_render* render, VkCommandBuffer command_buffer, co
 			}
 		}
 
-		if (ui_objects_group)
+		if (ui_objects_group || snapshot)
 		{
-			for (i32 i = 0; i < AS_ARRAY_GET_SIZE(*ui_objects_group); i++)
+			const i32 ui_size = (i32)(snapshot ? snapshot->ui_size : AS_ARRAY_GET_SIZE(*ui_objects_group));
+			for (i32 i = 0; i < ui_size; i++)
 			{
-				as_screen_object* screen_object = AS_ARRAY_GET(*ui_objects_group, i);
-				as_push_const_buffer_screen_object push_const = get_push_const_buffer_screen_object(screen_object);
+				as_screen_object* screen_object = snapshot ? snapshot->ui_objects[i] : AS_ARRAY_GET(*ui_objects_group, i);
 				if (!screen_object) { continue; }
 				if (!screen_object->pipeline) { continue; }
+				as_push_const_buffer_screen_object push_const = get_push_const_buffer_screen_object(snapshot ? &snapshot->ui_data[i] : &screen_object->data);
 
 				vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, screen_object->pipeline);
 				vkCmdPushConstants(command_buffer, screen_object->pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(push_const), &push_const);
@@ -1145,6 +1280,11 @@ void record_command_buffer(as_render* render, VkCommandBuffer command_buffer, co
 	}
 	vkCmdEndRenderPass(command_buffer);
 
+	if (render->is_headless && render->readback_func)
+	{
+		record_readback(render, command_buffer, image_index);
+	}
+
 	VkResult end_command_buffer_result = vkEndCommandBuffer(command_buffer);
 	AS_ASSERT(end_command_buffer_result == VK_SUCCESS, "Failed to record command buffer!");
 }
@@ -1165,6 +1305,17 @@ void cleanup_swap_chain(as_render* render)
 	vkDestroyImage(render->device, render->depth_image, NULL);
 	vkFreeMemory(render->device, render->depth_image_memory, NULL);
 
+	if (render->is_headless)
+	{
+		for (sz i = 0; i < render->swap_chain_images.size; i++)
+		{
+			vkDestroyImage(render->device, render->swap_chain_images.data[i], NULL);
+			vkFreeMemory(render->device, render->offscreen_images_memory.data[i], NULL);
+			vkDestroyBuffer(render->device, render->readback_buffers.data[i], NULL);
+			vkFreeMemory(render->device, render->readback_memories.data[i], NULL);
+		}
+		return;
+	}
 	vkDestroySwapchainKHR(render->device, render->swap_chain, NULL);
 }
 
@@ -1286,6 +1437,31 @@ void create_depth_resources(as_render* render) {
 	render->depth_image_view = create_image_view(render, render->depth_image, depth_format, VK_IMAGE_ASPECT_DEPTH_BIT);
 }
 
+// the headless replacement of create_swap_chain, one image per frame in flight so a slot is free once its fence is
+void create_offscreen_images(as_render* render, const u32 width, const u32 height)
+{
+	render->swap_chain_image_format = AS_HEADLESS_IMAGE_FORMAT;
+	render->swap_chain_extent.width = width;
+	render->swap_chain_extent.height = height;
+	render->swap_chain_images.size = MAX_FRAMES_IN_FLIGHT;
+	render->offscreen_images_memory.size = MAX_FRAMES_IN_FLIGHT;
+	render->readback_buffers.size = MAX_FRAMES_IN_FLIGHT;
+	render->readback_memories.size = MAX_FRAMES_IN_FLIGHT;
+	render->readback_mapped.size = MAX_FRAMES_IN_FLIGHT;
+
+	const VkDeviceSize readback_size = (VkDeviceSize)width * height * 4;
+	for (sz i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+	{
+		create_image(render, width, height, render->swap_chain_image_format, VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &render->swap_chain_images.data[i], &render->offscreen_images_memory.data[i]);
+		create_buffer(render, readback_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			&render->readback_buffers.data[i], &render->readback_memories.data[i]);
+		vkMapMemory(render->device, render->readback_memories.data[i], 0, readback_size, 0, &render->readback_mapped.data[i]);
+	}
+}
+
 void update_time(as_render* render)
 {
 	clock_t current_time = clock();
@@ -1308,6 +1484,7 @@ void recreate_swap_chain(as_render* render, void* display_context)
 
 	cleanup_swap_chain(render);
 	create_swap_chain(render, display_context);
+	create_render_finished_semaphores(render); // the new swap chain may have more images
 	create_image_views(render);
 	create_depth_resources(render);
 	create_framebuffers(render);
@@ -1315,7 +1492,7 @@ void recreate_swap_chain(as_render* render, void* display_context)
 
 as_render* as_render_create(void* display_context)
 {
-	as_render* render = (as_render*)AS_MALLOC(sizeof(as_render));
+	as_render* render = AS_MALLOC_SINGLE_TAGGED(as_render, AS_MEMORY_TAG_RENDER);
 	create_instance(render);
 	create_surface(render, display_context);
 	pick_physical_device(render);
@@ -1333,6 +1510,29 @@ as_render* as_render_create(void* display_context)
 	return render;
 }
 
+as_render* as_render_create_headless(const u32 width, const u32 height, as_render_readback_func readback_func, void* readback_user_data)
+{
+	AS_WARNING_RETURN_VAL_IF_FALSE((width > 0 && height > 0), NULL, "Cannot create headless render, invalid size %ux%u", width, height);
+	as_render* render = AS_MALLOC_SINGLE_TAGGED(as_render, AS_MEMORY_TAG_RENDER);
+	render->is_headless = true;
+	render->readback_func = readback_func;
+	render->readback_user_data = readback_user_data;
+	create_instance(render);
+	pick_physical_device(render);
+	create_logical_device(render);
+	create_command_pool(render);
+	create_offscreen_images(render, width, height);
+	create_image_views(render);
+	create_render_pass(render);
+	create_depth_resources(render);
+	create_framebuffers(render);
+	create_command_buffers(render);
+	create_sync_objects(render);
+	AS_SET_VALID(render);
+	AS_FLOG(LV_LOG, "Created headless render %ux%u", width, height);
+	return render;
+}
+
 void as_render_start_draw_loop(as_render* render)
 {
 	render->last_frame_time = get_current_time();
@@ -1343,7 +1543,7 @@ void as_render_end_draw_loop(as_render* render)
 	render->current_time = get_current_time();
 
 	const f32 remaining_time = as_render_get_remaining_time(render);
-	if (remaining_time > 0)
+	if (remaining_time > 0 && !render->is_headless) // headless runs are benchmarks or offline renders
 	{
 		sleep_seconds(remaining_time);
 	}
@@ -1351,81 +1551,183 @@ void as_render_end_draw_loop(as_render* render)
 	render->last_frame_time = get_current_time();
 }
 
-void as_render_draw_frame(as_render* render, void* display_context, as_camera* camera, as_scene* scene, as_screen_objects_group* screen_objects_group)
+static void release_retired(as_render* render, const as_retired* retired)
+{
+	switch (retired->type)
+	{
+	case AS_RETIRED_BUFFER: vkDestroyBuffer(render->device, retired->buffer, NULL); break;
+	case AS_RETIRED_MEMORY: vkFreeMemory(render->device, retired->memory, NULL); break;
+	case AS_RETIRED_PIPELINE: vkDestroyPipeline(render->device, retired->pipeline, NULL); break;
+	case AS_RETIRED_PIPELINE_LAYOUT: vkDestroyPipelineLayout(render->device, retired->pipeline_layout, NULL); break;
+	case AS_RETIRED_DESCRIPTOR_POOL: vkDestroyDescriptorPool(render->device, retired->descriptor_pool, NULL); break;
+	case AS_RETIRED_DESCRIPTOR_SET_LAYOUT: vkDestroyDescriptorSetLayout(render->device, retired->descriptor_set_layout, NULL); break;
+	case AS_RETIRED_IMAGE: vkDestroyImage(render->device, retired->image, NULL); break;
+	case AS_RETIRED_IMAGE_VIEW: vkDestroyImageView(render->device, retired->image_view, NULL); break;
+	case AS_RETIRED_SAMPLER: vkDestroySampler(render->device, retired->sampler, NULL); break;
+	}
+}
+
+static void retire(as_render* render, const as_retired* retired)
+{
+	as_spinlock_lock(&render->retired_lock);
+	as_retired* entry = AS_VECTOR_INCREMENT(render->retired);
+	if (!entry)
+	{
+		as_spinlock_unlock(&render->retired_lock);
+		AS_LOG(LV_ERROR, "Cannot retire gpu object, waiting for the device instead");
+		vkDeviceWaitIdle(render->device);
+		release_retired(render, retired);
+		return;
+	}
+	*entry = *retired;
+	// one frame later than needed, off the render thread the counter can be read between a submit and its increment
+	entry->frame = render->frame_counter + 1;
+	as_spinlock_unlock(&render->retired_lock);
+}
+
+#define AS_RETIRE(_render, _type, _field, _handle) \
+	{ as_retired _retired = { 0 }; _retired.type = (_type); _retired._field = (_handle); retire((_render), &_retired); }
+
+// call it once the fence of the current slot signaled, or with all when the device is idle
+static void release_retired_list(as_render* render, const b8 all)
+{
+	as_spinlock_lock(&render->retired_lock);
+	sz kept = 0;
+	for (sz i = 0; i < render->retired.size; i++)
+	{
+		const as_retired* retired = &render->retired.data[i];
+		// frames up to frame_counter - MAX_FRAMES_IN_FLIGHT are done, the last user of the object is frame - 1
+		if (all || retired->frame + MAX_FRAMES_IN_FLIGHT - 1 <= render->frame_counter)
+		{
+			release_retired(render, retired);
+		}
+		else
+		{
+			render->retired.data[kept++] = *retired;
+		}
+	}
+	render->retired.size = kept;
+	as_spinlock_unlock(&render->retired_lock);
+}
+
+void as_render_draw_frame(as_render* render, void* display_context, as_camera* camera, as_scene* scene, as_screen_objects_group* screen_objects_group, const as_render_snapshot* snapshot)
 {
 	if (AS_IS_INVALID(render)){ return;};
 
+	// up to MAX_FRAMES_IN_FLIGHT frames run on the gpu, once this fence signaled the per slot resources are free to write
 	vkWaitForFences(render->device, 1, &render->in_flight_fences.data[render->current_frame], VK_TRUE, UINT64_MAX);
+	release_retired_list(render, false);
 
 	u32 image_index = 0;
-	VkResult result = vkAcquireNextImageKHR(render->device, render->swap_chain, UINT64_MAX, render->image_available_semaphores.data[render->current_frame], VK_NULL_HANDLE, &image_index);
-
-	if (result == VK_ERROR_OUT_OF_DATE_KHR) 
+	VkResult result = VK_SUCCESS;
+	if (render->is_headless)
 	{
-		recreate_swap_chain(render, display_context);
-		return;
+		image_index = (u32)render->current_frame; // the offscreen image of this slot is free since its fence is
+		if (render->readback_func)
+		{
+			deliver_readback(render, image_index);
+		}
+	}
+	else
+	{
+		result = vkAcquireNextImageKHR(render->device, render->swap_chain, UINT64_MAX, render->image_available_semaphores.data[render->current_frame], VK_NULL_HANDLE, &image_index);
+		if (result == VK_ERROR_OUT_OF_DATE_KHR) 
+		{
+			recreate_swap_chain(render, display_context);
+			return;
+		}
+		AS_ASSERT(result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR, "Failed to acquire swap chain image!");
 	}
-	AS_ASSERT(result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR, "Failed to acquire swap chain image!");
 
 	update_time(render);
 
-	if (screen_objects_group)
+	if (snapshot)
 	{
-		for (sz i = 0; i < AS_ARRAY_GET_SIZE(*screen_objects_group); i++)
+		for (sz i = 0; i < snapshot->ui_size; i++)
 		{
-			as_screen_object* screen_obj = AS_ARRAY_GET(*screen_objects_group, i);
-			if (screen_obj)
-			{
-				update_screen_object_uniform_buffer(render, screen_obj, image_index);
-			}
+			update_screen_object_uniform_buffer(render, snapshot->ui_objects[i], snapshot->ui_custom_data[i], (u32)render->current_frame);
 		}
-	}
 
-	AS_WAIT_AND_LOCK(scene);
-	if (scene)
+		// nothing live is read, the game thread keeps ticking the scene meanwhile
+		for (sz obj_index = 0; obj_index < snapshot->objects_size; obj_index++)
+		{
+			as_object* object = as_render_snapshot_get_object(snapshot, obj_index);
+			if (!object || AS_IS_INVALID(object->shader)) { continue; }
+			update_shader_uniform_buffer(render, snapshot->objects_transforms, snapshot->objects_size, object->shader, (as_camera*)&snapshot->camera, render->current_frame);
+		}
+
+		vkResetFences(render->device, 1, &render->in_flight_fences.data[render->current_frame]);
+
+		vkResetCommandBuffer(render->command_buffers.data[render->current_frame], 0);
+		record_command_buffer(render, render->command_buffers.data[render->current_frame], image_index, scene, screen_objects_group, snapshot);
+	}
+	else
 	{
-		for (sz obj_index = 0; obj_index < scene->objects.size; obj_index++)
+		if (screen_objects_group)
 		{
-			as_object* object = AS_ARRAY_GET(scene->objects, obj_index);
-			if (AS_IS_INVALID(object)) { continue; }
-			as_shader* shader = object->shader;
-			if (AS_IS_INVALID(shader)) { continue; }
-			if (!shader->graphics_pipeline)
+			for (sz i = 0; i < AS_ARRAY_GET_SIZE(*screen_objects_group); i++)
 			{
-				//as_shader_update(render, shader);
+				as_screen_object* screen_obj = AS_ARRAY_GET(*screen_objects_group, i);
+				if (screen_obj)
+				{
+					update_screen_object_uniform_buffer(render, screen_obj, screen_obj->custom_data, (u32)render->current_frame);
+				}
 			}
-			update_shader_uniform_buffer(render, scene, shader, camera, render->current_frame);
 		}
 
-		as_scene_gpu_update_data(scene);
-		as_scene_gpu_update_buffer(render, scene);
+		AS_WAIT_AND_LOCK(scene);
+		if (scene)
+		{
+			for (sz obj_index = 0; obj_index < AS_HANDLE_TABLE_GET_SIZE(scene->objects); obj_index++)
+			{
+				as_object* object = AS_HANDLE_TABLE_GET_AT(scene->objects, as_object, obj_index);
+				if (AS_IS_INVALID(object)) { continue; }
+				as_shader* shader = object->shader;
+				if (AS_IS_INVALID(shader)) { continue; }
+				if (!shader->graphics_pipeline)
+				{
+					//as_shader_update(render, shader);
+				}
+				update_shader_uniform_buffer(render, scene->gpu_data.objects_transforms, AS_HANDLE_TABLE_GET_SIZE(scene->objects), shader, camera, render->current_frame);
+			}
 
-		vkResetFences(render->device, 1, &render->in_flight_fences.data[render->current_frame]);
+			as_scene_gpu_update_data(scene);
+			as_scene_gpu_update_buffer(render, scene);
 
-		vkResetCommandBuffer(render->command_buffers.data[render->current_frame], 0);
-		record_command_buffer(render, render->command_buffers.data[render->current_frame], image_index, scene, screen_objects_group);
+			vkResetFences(render->device, 1, &render->in_flight_fences.data[render->current_frame]);
+
+			vkResetCommandBuffer(render->command_buffers.data[render->current_frame], 0);
+			record_command_buffer(render, render->command_buffers.data[render->current_frame], image_index, scene, screen_objects_group, NULL);
+		}
+		AS_UNLOCK(scene);
 	}
-	AS_UNLOCK(scene);
 
 	VkSubmitInfo submit_info = { 0 };
 	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 	
 	VkSemaphore wait_semaphores[] = { render->image_available_semaphores.data[render->current_frame] };
 	VkPipelineStageFlags wait_stages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-	submit_info.waitSemaphoreCount = 1;
+	submit_info.waitSemaphoreCount = render->is_headless ? 0 : 1; // nothing to acquire nor present
 	submit_info.pWaitSemaphores = wait_semaphores;
 	submit_info.pWaitDstStageMask = wait_stages;
 
 	submit_info.commandBufferCount = 1;
 	submit_info.pCommandBuffers = &render->command_buffers.data[render->current_frame];
 	
-	VkSemaphore signal_semaphores[] = { render->render_finished_semaphores.data[render->current_frame] };
-	submit_info.signalSemaphoreCount = 1;
+	VkSemaphore signal_semaphores[] = { render->render_finished_semaphores.data[image_index] };
+	submit_info.signalSemaphoreCount = render->is_headless ? 0 : 1;
 	submit_info.pSignalSemaphores = signal_semaphores;
 	
 	AS_ASSERT(vkQueueSubmit(render->graphics_queue, 1, &submit_info, render->in_flight_fences.data[render->current_frame]) == VK_SUCCESS, 
 		"Failed to submit draw command buffer!");
 
+	if (render->is_headless)
+	{
+		render->current_frame = (render->current_frame + 1) % MAX_FRAMES_IN_FLIGHT;
+		render->frame_counter++;
+		return;
+	}
+
 	VkSwapchainKHR swap_chains[] = { render->swap_chain };
 
 	VkPresentInfoKHR present_info = { 0 };
@@ -1436,7 +1738,6 @@ void as_render_draw_frame(as_render* render, void* display_context, as_camera* c
 	present_info.pSwapchains = swap_chains;
 	present_info.pImageIndices = &image_index;
 	
-	vkDeviceWaitIdle(render->device);
 	result = vkQueuePresentKHR(render->present_queue, &present_info);
 
 	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || render->framebuffer_resized) 
@@ -1456,14 +1757,26 @@ void as_render_draw_frame(as_render* render, void* display_context, as_camera* c
 void as_render_destroy(as_render* render)
 {
 	vkDeviceWaitIdle(render->device);
+	release_retired_list(render, true);
+	AS_VECTOR_FREE(render->retired);
+	if (render->is_headless && render->readback_func)
+	{
+		for (u64 i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) // oldest slot first
+		{
+			deliver_readback(render, (render->current_frame + i) % MAX_FRAMES_IN_FLIGHT);
+		}
+	}
 
 	cleanup_swap_chain(render);
 
 	vkDestroyRenderPass(render->device, render->render_pass, NULL);
 
-	for (sz i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+	for (sz i = 0; i < render->render_finished_semaphores.size; i++)
 	{
 		vkDestroySemaphore(render->device, render->render_finished_semaphores.data[i], NULL);
+	}
+	for (sz i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+	{
 		vkDestroySemaphore(render->device, render->image_available_semaphores.data[i], NULL);
 		vkDestroyFence(render->device, render->in_flight_fences.data[i], NULL);
 	}
@@ -1477,7 +1790,10 @@ void as_render_destroy(as_render* render)
 		destroy_debug_utils_messenger_EXT(render->instance, render->debug_messenger, NULL);
 	}
 
-	vkDestroySurfaceKHR(render->instance, render->surface, NULL);
+	if (!render->is_headless)
+	{
+		vkDestroySurfaceKHR(render->instance, render->surface, NULL);
+	}
 	vkDestroyInstance(render->instance, NULL);
 
 	AS_IS_INVALID(render);
@@ -1555,8 +1871,19 @@ void as_screen_object_create_pipeline_layout(as_render* render, as_screen_object
 
 void as_screen_object_create_pipeline(as_screen_object* screen_object)
 {
-	as_file_pool* file_pool = AS_MALLOC_SINGLE(as_file_pool);
-	as_shader_binary_pool* shader_binary_pool = AS_MALLOC_SINGLE(as_shader_binary_pool);
+	as_arena* frame_arena = as_arena_get_frame();
+	const as_arena_mark frame_mark = as_arena_get_mark(frame_arena);
+	as_file_pool* file_pool = AS_ARENA_ALLOC_SINGLE(frame_arena, as_file_pool);
+	as_shader_binary_pool* shader_binary_pool = AS_ARENA_ALLOC_SINGLE(frame_arena, as_shader_binary_pool);
+	if (!file_pool || !shader_binary_pool)
+	{
+		as_arena_rewind(frame_arena, frame_mark);
+		AS_LOG(LV_ERROR, "Cannot create pipeline, could not allocate the shader pools");
+		return;
+	}
+	AS_SET_INVALID(file_pool);
+	AS_STATIC_ARRAY_CLEAR(file_pool->handles);
+	AS_STATIC_ARRAY_CLEAR(*shader_binary_pool);
 
 	as_shader_binary* vert_shader_bin = as_shader_read_code(shader_binary_pool, file_pool, AS_PATH_DEFAULT_2D_VERT_SHADER, AS_SHADER_TYPE_VERTEX);
 	as_shader_binary* frag_shader_bin = as_shader_read_code(shader_binary_pool, file_pool, screen_object->filename_fragment, AS_SHADER_TYPE_FRAGMENT);
@@ -1565,7 +1892,7 @@ void as_screen_object_create_pipeline(as_screen_object* screen_object)
 	{
 		as_shader_destroy_binary(shader_binary_pool, frag_shader_bin, true);
 		as_shader_destroy_binary(shader_binary_pool, vert_shader_bin, true);
-		AS_FREE(shader_binary_pool);
+		as_arena_rewind(frame_arena, frame_mark);
 		return;
 	}
 
@@ -1683,8 +2010,7 @@ void as_screen_object_create_pipeline(as_screen_object* screen_object)
 	as_shader_destroy_binary(shader_binary_pool, frag_shader_bin, true);
 	as_shader_destroy_binary(shader_binary_pool, vert_shader_bin, true);
 
-	AS_FREE(shader_binary_pool);
-	AS_FREE(file_pool);
+	as_arena_rewind(frame_arena, frame_mark);
 }
 void as_screen_object_create_descriptor_set_layout(as_screen_object* screen_object)
 {
@@ -1905,7 +2231,10 @@ void as_screen_object_destroy(as_screen_object* screen_object, const b8 free_ptr
 				if (!texture) { continue; }
 				as_texture_destroy(texture);
 			}
-			AS_FREE(screen_object->uniforms.data[i].data);
+			else
+			{
+				AS_FREE(screen_object->uniforms.data[i].data);
+			}
 		}
 
 		for (sz i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
@@ -1940,7 +2269,7 @@ void as_screen_object_destroy(as_screen_object* screen_object, const b8 free_ptr
 
 as_screen_objects_group* as_screen_objects_group_create()
 {
-	return AS_MALLOC_SINGLE(as_screen_objects_group);
+	return AS_MALLOC_SINGLE_TAGGED(as_screen_objects_group, AS_MEMORY_TAG_RENDER);
 }
 
 void as_screen_objects_group_destroy(as_screen_objects_group* screen_objects_group)
@@ -1985,13 +2314,22 @@ extern as_vec2 as_screen_object_get_extent(const as_screen_object* screen_object
 	return AS_VEC(as_vec2, screen_object->data.m[1][0], screen_object->data.m[1][1]);
 }
 
+as_slab as_textures_slab = AS_SLAB_INITIALIZER(as_texture, AS_MEMORY_TAG_RENDER);
+as_handle_table as_textures_table = AS_HANDLE_TABLE_INITIALIZER("as_textures_table");
+
 as_texture* as_texture_make(const char* path)
 {
-	as_texture* texture = AS_MALLOC_SINGLE(as_texture);
+	as_texture* texture = AS_SLAB_ALLOC_SINGLE(&as_textures_slab, as_texture);
 	strcpy(texture->filename, path);
+	texture->handle = as_handle_table_add(&as_textures_table, texture);
 	return texture;
 }
 
+as_texture* as_texture_get(as_textures_pool* textures_pool, const as_handle handle)
+{
+	return AS_HANDLE_TABLE_GET(textures_pool ? textures_pool : &as_textures_table, as_texture, handle);
+}
+
 void as_texture_init(as_texture* texture, const char* path)
 {
 	AS_ASSERT(texture, "Cannot init texture, invalid pointer");
@@ -2015,6 +2353,7 @@ bool as_texture_update(as_render* render, as_texture* texture)
 	}
 
 	texture->device = &render->device;
+	texture->render = render;
 
 	u32 tex_width, tex_height, tex_channels;
 	stbi_uc* pixels = stbi_load(texture->filename, &tex_width, &tex_height, &tex_channels, STBI_rgb_alpha);
@@ -2082,32 +2421,39 @@ void as_texture_destroy(as_texture* texture)
 
 	AS_FLOG(LV_LOG, "Destroy texture %p", texture);
 
-	AS_LOCK(texture);
-	if (texture->device && *texture->device)
+	AS_WAIT_AND_LOCK(texture);
+	if (texture->render)
 	{
-		if (texture->image)
-		{
-			vkDestroyImage(*texture->device, texture->image, NULL);
-		}
-		if (texture->image_view)
-		{
-			vkDestroyImageView(*texture->device, texture->image_view, NULL);
-		}
-		if (texture->sampler)
-		{
-			vkDestroySampler(*texture->device, texture->sampler, NULL);
-		}
-		if (texture->memory)
-		{
-			vkFreeMemory(*texture->device, texture->memory, NULL);
-		}
+		// frames in flight may still sample it, destroying a null handle does nothing
+		AS_RETIRE(texture->render, AS_RETIRED_SAMPLER, sampler, texture->sampler);
+		AS_RETIRE(texture->render, AS_RETIRED_IMAGE_VIEW, image_view, texture->image_view);
+		AS_RETIRE(texture->render, AS_RETIRED_IMAGE, image, texture->image);
+		AS_RETIRE(texture->render, AS_RETIRED_MEMORY, memory, texture->memory);
+		texture->sampler = VK_NULL_HANDLE;
+		texture->image_view = VK_NULL_HANDLE;
+		texture->image = VK_NULL_HANDLE;
+		texture->memory = VK_NULL_HANDLE;
 	}
 	AS_SET_INVALID(texture);
+	AS_UNLOCK(texture);
+}
+
+void as_texture_free(as_texture* texture)
+{
+	if (!texture) { return; }
+	as_texture_destroy(texture);
+	if (as_texture_get(NULL, texture->handle) == texture) // pool textures are unregistered by their pool
+	{
+		as_handle_table_remove(&as_textures_table, texture->handle, NULL);
+	}
+	as_slab_free(&as_textures_slab, texture);
 }
 
 as_textures_pool* as_textures_pool_create()
 {
-	return AS_MALLOC_SINGLE(as_textures_pool);
+	as_textures_pool* textures_pool = AS_MALLOC_SINGLE_TAGGED(as_textures_pool, AS_MEMORY_TAG_RENDER);
+	textures_pool->name = "as_textures_pool";
+	return textures_pool;
 }
 
 void as_textures_pool_destroy(as_textures_pool* textures_pool)
@@ -2115,21 +2461,21 @@ void as_textures_pool_destroy(as_textures_pool* textures_pool)
 	AS_FLOG(LV_LOG, "Destroy texture pool %p", textures_pool);
 
 	if (!textures_pool) { return; }
-	AS_ARRAY_FOR_EACH(*textures_pool, as_texture, texture,
+	AS_HANDLE_TABLE_FOR_EACH(*textures_pool, as_texture, texture,
 	{
-		if (textures_pool->size < 0 || textures_pool->size > AS_MAX_TEXTURE_POOL_SIZE)
-		{
-			break;
-		}
 		as_texture_destroy(texture);
+		as_slab_free(&as_textures_slab, texture);
 	});
+	as_handle_table_destroy(textures_pool);
 	AS_FREE(textures_pool);
 }
 
 as_texture* as_texture_get_from_pool(as_textures_pool* textures_pool)
 {
 	AS_ASSERT(textures_pool, "Cannot get texture from pool, invalid textures_pool ptr");
-	return AS_ARRAY_INCREMENT(*textures_pool);
+	as_texture* texture = AS_SLAB_ALLOC_SINGLE(&as_textures_slab, as_texture);
+	texture->handle = as_handle_table_add(textures_pool, texture);
+	return texture;
 }
 
 void as_texture_remove_from_pool(as_textures_pool* textures_pool, as_texture* texture, const bool destory)
@@ -2137,16 +2483,14 @@ void as_texture_remove_from_pool(as_textures_pool* textures_pool, as_texture* te
 	AS_ASSERT(texture, "Cannot remove texture from pool, invalid texture ptr");
 	AS_ASSERT(textures_pool, "Cannot remove texture from pool, invalid textures_pool ptr");
 
-	if (destory)
-	{
-		as_texture_destroy(texture);
-	}
+	AS_WARNING_RETURN_IF_FALSE((as_texture_get(textures_pool, texture->handle) == texture), "Texture %p is not in pool %p", texture, textures_pool);
+	as_handle_table_remove(textures_pool, texture->handle, NULL);
+	texture->handle = AS_HANDLE_INVALID;
 
-	sz found_index = -1;
-	AS_ARRAY_FIND_PTR(*textures_pool, texture, found_index);
-	if (found_index > -1)
+	if (destory) // otherwise the caller owns the texture and releases it with as_texture_free
 	{
-		AS_ARRAY_REMOVE_AT(*textures_pool, found_index);
+		as_texture_destroy(texture);
+		as_slab_free(&as_textures_slab, texture);
 	}
 }
 
@@ -2158,8 +2502,19 @@ void as_shader_create_graphics_pipeline(as_shader* shader)
 		return;
 	}
 
-	as_file_pool* file_pool = AS_MALLOC_SINGLE(as_file_pool);
-	as_shader_binary_pool* shader_binary_pool = AS_MALLOC_SINGLE(as_shader_binary_pool);
+	as_arena* frame_arena = as_arena_get_frame();
+	const as_arena_mark frame_mark = as_arena_get_mark(frame_arena);
+	as_file_pool* file_pool = AS_ARENA_ALLOC_SINGLE(frame_arena, as_file_pool);
+	as_shader_binary_pool* shader_binary_pool = AS_ARENA_ALLOC_SINGLE(frame_arena, as_shader_binary_pool);
+	if (!file_pool || !shader_binary_pool)
+	{
+		as_arena_rewind(frame_arena, frame_mark);
+		AS_LOG(LV_ERROR, "Cannot create pipeline, could not allocate the shader pools");
+		return;
+	}
+	AS_SET_INVALID(file_pool);
+	AS_STATIC_ARRAY_CLEAR(file_pool->handles);
+	AS_STATIC_ARRAY_CLEAR(*shader_binary_pool);
 	as_shader_binary* vert_shader_bin = as_shader_read_code(shader_binary_pool, file_pool, shader->filename_vertex, AS_SHADER_TYPE_VERTEX);
 	as_shader_binary* frag_shader_bin = as_shader_read_code(shader_binary_pool, file_pool, shader->filename_fragment, AS_SHADER_TYPE_FRAGMENT);
 
@@ -2167,7 +2522,7 @@ void as_shader_create_graphics_pipeline(as_shader* shader)
 	{
 		as_shader_destroy_binary(shader_binary_pool, frag_shader_bin, true);
 		as_shader_destroy_binary(shader_binary_pool, vert_shader_bin, true);
-		AS_FREE(shader_binary_pool);
+		as_arena_rewind(frame_arena, frame_mark);
 		return;
 	}
 
@@ -2192,7 +2547,7 @@ void as_shader_create_graphics_pipeline(as_shader* shader)
 	vertex_input_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
 	VkVertexInputBindingDescription binding_description = as_get_binding_description();
-	VkVertexInputAttributeDescription* attribute_descriptions = (VkVertexInputAttributeDescription*)AS_MALLOC(sizeof(VkVertexInputAttributeDescription) * AS_VERTEX_VAR_COUNT);
+	VkVertexInputAttributeDescription attribute_descriptions[AS_VERTEX_VAR_COUNT] = { 0 };
 	as_get_attribute_descriptions(attribute_descriptions);
 	vertex_input_info.vertexBindingDescriptionCount = 1;
 	vertex_input_info.vertexAttributeDescriptionCount = AS_VERTEX_VAR_COUNT;
@@ -2292,9 +2647,7 @@ void as_shader_create_graphics_pipeline(as_shader* shader)
 	as_shader_destroy_binary(shader_binary_pool, frag_shader_bin, true);
 	as_shader_destroy_binary(shader_binary_pool, vert_shader_bin, true);
 
-	AS_FREE(attribute_descriptions);
-	AS_FREE(shader_binary_pool);
-	AS_FREE(file_pool);
+	as_arena_rewind(frame_arena, frame_mark);
 }
 
 sz as_shader_add_uniform_float(as_shader_uniforms* uniforms, f32* value)
@@ -2306,7 +2659,7 @@ sz as_shader_add_uniform_float(as_shader_uniforms* uniforms, f32* value)
 	AS_ARRAY_INSERT_AT((*uniforms), uniforms->size, shader_uniform);
 	const sz index = uniforms->size - 1;
 	uniforms->data[index].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-	uniforms->data[index].data = AS_MALLOC(sizeof(f32));
+	uniforms->data[index].data = AS_MALLOC_TAGGED(sizeof(f32), "f32", AS_MEMORY_TAG_SHADER);
 	uniforms->data[index].data = value;
 
 	return index;
@@ -2342,22 +2695,31 @@ sz as_shader_add_scene_gpu(as_shader_uniforms* uniforms, as_scene_gpu_buffer* sc
     return index;
 }
 
+as_slab as_shaders_slab = AS_SLAB_INITIALIZER(as_shader, AS_MEMORY_TAG_SHADER);
+as_handle_table as_shaders_table = AS_HANDLE_TABLE_INITIALIZER("as_shaders_table");
+
 as_shader* as_shader_make(as_render* render, const char* vertex_shader_path, const char* fragment_shader_path)
 {
 	AS_ASSERT(render, "Trying to create shader, but render is NULL");
 	AS_ASSERT(vertex_shader_path, "Trying to create shader, but vertex_shader_path is NULL");
 	AS_ASSERT(fragment_shader_path, "Trying to create shader, but fragment_shader_path is NULL");
 
-	as_shader* shader = AS_MALLOC_SINGLE(as_shader);
+	as_shader* shader = AS_SLAB_ALLOC_SINGLE(&as_shaders_slab, as_shader);
 	shader->device = &render->device;
 	shader->render_pass = &render->render_pass;
 	strcpy(shader->filename_fragment, fragment_shader_path);
 	strcpy(shader->filename_vertex, vertex_shader_path);
+	shader->handle = as_handle_table_add(&as_shaders_table, shader);
 
 	AS_SET_VALID(shader);
 	return shader;
 }
 
+as_shader* as_shader_get(const as_handle handle)
+{
+	return AS_HANDLE_TABLE_GET(&as_shaders_table, as_shader, handle);
+}
+
 extern void as_shader_set_uniforms(as_render* render, as_shader* shader, as_shader_uniforms* uniforms)
 {
 	AS_ASSERT(render, "Trying to set shader uniforms, but render is NULL");
@@ -2394,8 +2756,9 @@ void as_shader_destroy(as_render* render, as_shader* shader)
 
 	AS_FLOG(LV_LOG, "Destroying shader %p", shader);
 
-	vkDestroyPipeline(render->device, shader->graphics_pipeline, NULL);
-	vkDestroyPipelineLayout(render->device, shader->graphics_pipeline_layout, NULL);
+	// frames in flight may still use its pipeline and uniform buffers
+	AS_RETIRE(render, AS_RETIRED_PIPELINE, pipeline, shader->graphics_pipeline);
+	AS_RETIRE(render, AS_RETIRED_PIPELINE_LAYOUT, pipeline_layout, shader->graphics_pipeline_layout);
 
 	//for (sz i = 0; i < shader->uniforms.size; i++)
 	//{
@@ -2410,15 +2773,26 @@ void as_shader_destroy(as_render* render, as_shader* shader)
 
 	for (sz i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
 	{
-		vkDestroyBuffer(render->device, shader->uniform_buffers.buffers.data[i], NULL);
-		vkFreeMemory(render->device, shader->uniform_buffers.memories.data[i], NULL);
+		AS_RETIRE(render, AS_RETIRED_BUFFER, buffer, shader->uniform_buffers.buffers.data[i]);
+		AS_RETIRE(render, AS_RETIRED_MEMORY, memory, shader->uniform_buffers.memories.data[i]);
 	}
 
-	vkDestroyDescriptorPool(render->device, shader->descriptor_pool, NULL);
-	vkDestroyDescriptorSetLayout(render->device, shader->descriptor_set_layout, NULL);
+	AS_RETIRE(render, AS_RETIRED_DESCRIPTOR_POOL, descriptor_pool, shader->descriptor_pool); // frees its descriptor sets too
+	AS_RETIRE(render, AS_RETIRED_DESCRIPTOR_SET_LAYOUT, descriptor_set_layout, shader->descriptor_set_layout);
 
 	AS_SET_INVALID(shader);
-	AS_FREE(shader);
+	as_shader_free(shader);
+}
+
+void as_shader_free(as_shader* shader)
+{
+	if (!shader) { return; }
+	if (as_shader_get(shader->handle) == shader)
+	{
+		as_handle_table_remove(&as_shaders_table, shader->handle, NULL);
+	}
+	shader->handle = AS_HANDLE_INVALID;
+	as_slab_free(&as_shaders_slab, shader);
 }
 
 void as_camera_update_direction(as_camera* camera)
@@ -2487,11 +2861,15 @@ void as_camera_set_target(as_camera* camera, const as_vec3* target)
 	as_camera_update_direction(camera);
 }
 
+as_slab as_objects_slab = AS_SLAB_INITIALIZER(as_object, AS_MEMORY_TAG_SCENE);
+
 as_object* as_object_consturct(as_render* render, as_scene* scene)	
 {
 	AS_ASSERT(scene, "Trying to construct object, but scene is NULL");
 
-	as_object* object = AS_ARRAY_INCREMENT(scene->objects);
+	as_object* object = AS_SLAB_ALLOC_SINGLE(&as_objects_slab, as_object);
+	object->handle = as_handle_table_add(&scene->objects, object);
+	object->scene_gpu_index = (i32)as_handle_table_get_dense_index(&scene->objects, object->handle);
 	as_mat4_set_identity(&object->transform);
 	object->instance_count = 1;
 
@@ -2499,6 +2877,12 @@ as_object* as_object_consturct(as_render* render, as_scene* scene)
 	return object;
 }
 
+as_object* as_object_get(as_scene* scene, const as_handle handle)
+{
+	AS_ASSERT(scene, "Trying to get object, but scene is NULL");
+	return AS_HANDLE_TABLE_GET(&scene->objects, as_object, handle);
+}
+
 void as_object_update(as_render* render, as_object* object, as_shape* shape, as_shader* shader)
 {
 	AS_ASSERT(render, "Trying to update object, but render is NULL");
@@ -2632,15 +3016,42 @@ void as_object_destroy(as_render* render, as_object* object)
 
 	as_shader_destroy(render, object->shader);
 
-	vkDestroyBuffer(render->device, object->index_buffer, NULL);
-	vkFreeMemory(render->device, object->index_buffer_memory, NULL);
+	// frames in flight may still draw it
+	AS_RETIRE(render, AS_RETIRED_BUFFER, buffer, object->index_buffer);
+	AS_RETIRE(render, AS_RETIRED_MEMORY, memory, object->index_buffer_memory);
 
-	vkDestroyBuffer(render->device, object->vertex_buffer, NULL);
-	vkFreeMemory(render->device, object->vertex_buffer_memory, NULL);
+	AS_RETIRE(render, AS_RETIRED_BUFFER, buffer, object->vertex_buffer);
+	AS_RETIRE(render, AS_RETIRED_MEMORY, memory, object->vertex_buffer_memory);
 
 	AS_SET_INVALID(object);
 }
 
+void as_object_remove(as_render* render, as_scene* scene, as_object* object)
+{
+	AS_ASSERT(scene, "Trying to remove object, but scene is NULL");
+	AS_WARNING_RETURN_IF_FALSE((object && as_object_get(scene, object->handle) == object), "Trying to remove object %p, but it is not in the scene", object);
+
+	as_object_destroy(render, object);
+
+	AS_WAIT_AND_LOCK(scene);
+	void* moved = NULL;
+	as_handle_table_remove(&scene->objects, object->handle, &moved);
+	as_object* moved_object = (as_object*)moved;
+	if (moved_object) // the last object took the removed slot, it is the only GPU index that changes
+	{
+		moved_object->scene_gpu_index = object->scene_gpu_index;
+		if (moved_object->scene_gpu_index < AS_MAX_GPU_OBJECT_TRANSFORMS_SIZE)
+		{
+			scene->gpu_data.objects_transforms[moved_object->scene_gpu_index] = moved_object->transform;
+		}
+	}
+	scene->gpu_data.info.m[0][0] = (f32)AS_HANDLE_TABLE_GET_SIZE(scene->objects);
+	AS_UNLOCK(scene);
+
+	object->handle = AS_HANDLE_INVALID;
+	as_slab_free(&as_objects_slab, object);
+}
+
 void as_scene_gpu_create_descriptor(as_render* render, as_scene* scene)
 {
 	AS_ASSERT(render, TEXT("Trying to create scene gpu descriptor, but render is NULL"));
@@ -2657,8 +3068,9 @@ VkDeviceSize as_scene_get_size(as_render* render)
 
 as_scene* as_scene_create(as_render* render, const char* scene_path)
 {
-	as_scene* scene = AS_MALLOC_SINGLE(as_scene);
+	as_scene* scene = AS_MALLOC_SINGLE_TAGGED(as_scene, AS_MEMORY_TAG_SCENE);
 	strcpy(scene->path, scene_path);
+	scene->objects.name = "scene_objects";
 	VkDeviceSize size = as_scene_get_size(render);
 	//create_buffer(render, size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &scene->gpu_buffer.buffer, &scene->gpu_buffer.memory);
 	as_scene_gpu_update_data(scene);
@@ -2697,6 +3109,11 @@ as_scene* as_scene_load(as_render* render, const char* scene_path)
 	//return scene;
 }
 
+static void as_object_set_scene_gpu_index(void* object, const sz dense_index)
+{
+	((as_object*)object)->scene_gpu_index = (i32)dense_index;
+}
+
 static as_vec3 cached_camera_position = { 0 }; // used for compare by distance to camera
 i32 compare_objects_by_distance_to_camera(const void* a, const void* b)
 {
@@ -2722,8 +3139,7 @@ void as_order_scene_objects_by_distance_to_camera(as_scene* scene)
 		cached_camera_position = main_camera->position;
 	}
 
-	qsort(scene->objects.data, scene->objects.size, sizeof(as_object),
-		compare_objects_by_distance_to_camera);
+	as_handle_table_sort(&scene->objects, compare_objects_by_distance_to_camera, as_object_set_scene_gpu_index);
 }
 
 void as_scene_gpu_update_data(as_scene* scene)
@@ -2734,23 +3150,68 @@ void as_scene_gpu_update_data(as_scene* scene)
 	// AS_ARRAY_CLEAR(scene->gpu_data.objects_transforms);
 
 	// info
-	scene->gpu_data.info.m[0][0] = (f32)AS_ARRAY_GET_SIZE(scene->objects);
+	scene->gpu_data.info.m[0][0] = (f32)AS_HANDLE_TABLE_GET_SIZE(scene->objects);
 	
 	//as_order_scene_objects_by_distance_to_camera(scene);
 
-	// assign
-	for (sz i = 0; i < AS_ARRAY_GET_SIZE(scene->objects); i++)
+	// assign, scene_gpu_index is the dense index and is kept up to date on construct and remove
+	for (sz i = 0; i < AS_HANDLE_TABLE_GET_SIZE(scene->objects); i++)
 	{
 		if (i >= AS_MAX_GPU_OBJECT_TRANSFORMS_SIZE)
 		{
 			break;
 		}
-		as_object* object = AS_ARRAY_GET(scene->objects, i);
-		object->scene_gpu_index = i;
+		const as_object* object = AS_HANDLE_TABLE_GET_AT(scene->objects, as_object, i);
 		scene->gpu_data.objects_transforms[i] = object->transform;
 	}
 }
 
+void as_render_snapshot_capture(as_render_snapshot* snapshot, as_camera* camera, as_scene* scene, as_screen_objects_group* screen_objects_group)
+{
+	AS_ASSERT(snapshot, "Cannot capture render snapshot, invalid snapshot");
+	snapshot->objects_size = 0;
+	snapshot->ui_size = 0;
+	if (camera)
+	{
+		snapshot->camera = *camera;
+	}
+
+	if (scene)
+	{
+		AS_WAIT_AND_LOCK(scene);
+		sz objects_size = AS_HANDLE_TABLE_GET_SIZE(scene->objects);
+		if (objects_size > AS_RENDER_SNAPSHOT_MAX_OBJECTS)
+		{
+			AS_FLOG(LV_WARNING, "Scene has %zu objects, only the first %d are drawn", objects_size, AS_RENDER_SNAPSHOT_MAX_OBJECTS);
+			objects_size = AS_RENDER_SNAPSHOT_MAX_OBJECTS;
+		}
+		for (sz i = 0; i < objects_size; i++)
+		{
+			as_object* object = AS_HANDLE_TABLE_GET_AT(scene->objects, as_object, i);
+			snapshot->objects[i] = object;
+			snapshot->objects_handles[i] = object->handle;
+			if (i < AS_MAX_GPU_OBJECT_TRANSFORMS_SIZE)
+			{
+				snapshot->objects_transforms[i] = object->transform;
+			}
+		}
+		snapshot->objects_size = objects_size;
+		AS_UNLOCK(scene);
+	}
+
+	if (screen_objects_group)
+	{
+		for (sz i = 0; i < AS_ARRAY_GET_SIZE(*screen_objects_group); i++)
+		{
+			as_screen_object* screen_object = AS_ARRAY_GET(*screen_objects_group, i);
+			snapshot->ui_objects[i] = screen_object;
+			snapshot->ui_data[i] = screen_object->data;
+			memcpy(snapshot->ui_custom_data[i], screen_object->custom_data, sizeof(snapshot->ui_custom_data[i]));
+		}
+		snapshot->ui_size = AS_ARRAY_GET_SIZE(*screen_objects_group);
+	}
+}
+
 void as_scene_gpu_update_buffer(as_render* render, as_scene* scene)
 {
 	AS_ASSERT(render, "Cannot make GPU scene buffer, invalid render");
@@ -2771,10 +3232,13 @@ void as_scene_destroy(as_render *render, as_scene *scene)
 
 	vkDeviceWaitIdle(render->device);
 
-	for (sz i = 0; i < scene->objects.size; i++)
+	AS_HANDLE_TABLE_FOR_EACH(scene->objects, as_object, object,
 	{
-		as_object_destroy(render, &scene->objects.data[i]);
-	}
+		as_object_destroy(render, object);
+		as_slab_free(&as_objects_slab, object);
+	});
+	as_handle_table_destroy(&scene->objects);
+	release_retired_list(render, true); // the device is idle since the wait above
 
 	//vkFreeMemory(render->device, scene->gpu_buffer.memory, NULL);
 	//vkDestroyBuffer(render->device, scene->gpu_buffer.buffer, NULL);
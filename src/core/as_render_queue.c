@@ -3,49 +3,308 @@
 #include "core/as_render_queue.h"
 #include "as_memory.h"
 
+// the waiters count themselves before checking their condition, so either they see the progress or the queue sees them
+static void as_rq_signal_progress(as_render_queue* queue, const as_render_lane lane)
+{
+	const b8 has_room_waiters = AS_ATOMIC_LOAD_I64(&queue->room_waiters) > 0;
+	const b8 has_drain_waiters = AS_ATOMIC_LOAD_I64(&queue->drain_waiters) > 0 && as_rq_get_lane_size(queue, lane) == 0;
+	const b8 has_ticket_waiters = AS_ATOMIC_LOAD_I64(&queue->ticket_waiters) > 0;
+	if (has_room_waiters || has_drain_waiters || has_ticket_waiters)
+	{
+		AS_ATOMIC_ADD_I32(&queue->progress_epoch, 1);
+		as_wake_address_all(&queue->progress_epoch);
+	}
+}
+
+static void as_rq_signal_work(as_render_queue* queue)
+{
+	if (AS_ATOMIC_LOAD_I64(&queue->is_consumer_sleeping))
+	{
+		AS_ATOMIC_ADD_I32(&queue->work_epoch, 1);
+		as_wake_address_one(&queue->work_epoch);
+	}
+}
+
+// sleeps on progress_epoch until is_done or the deadline, waiter_count is the drain or room counter
+static b8 as_rq_wait_for_progress(as_render_queue* queue, volatile i64* waiter_count, b8 is_done(as_render_queue*, void*), void* arg)
+{
+	const f64 start_time = get_monotonic_time();
+	const f64 deadline = start_time + AS_RENDER_QUEUE_MAX_WAIT_TIME;
+	b8 result = false;
+	AS_ATOMIC_ADD_I64(waiter_count, 1);
+	for (;;)
+	{
+		const u32 epoch = AS_ATOMIC_LOAD_ACQUIRE_I32(&queue->progress_epoch);
+		if (is_done(queue, arg)) { result = true; break; }
+		const f64 remaining = deadline - get_monotonic_time();
+		if (remaining <= 0.) { break; }
+		as_wait_on_address_for(&queue->progress_epoch, epoch, remaining);
+	}
+	AS_ATOMIC_ADD_I64(waiter_count, -1);
+	as_histogram_record(&queue->stats.producer_wait, (u64)((get_monotonic_time() - start_time) * 1e9));
+	return result;
+}
+
+static sz as_rq_command_stats_index(void func_ptr(void*))
+{
+	return (sz)(((u64)(uintptr_t)func_ptr * 0x9E3779B97F4A7C15ull) >> 32) & (AS_RENDER_QUEUE_STATS_COMMANDS_SIZE - 1);
+}
+
+// only the queue thread adds, the histograms of a new slot are still zero when other threads find it
+static as_rq_command_stats* as_rq_find_command_stats(as_render_queue* queue, void func_ptr(void*), const b8 is_adding)
+{
+	sz index = as_rq_command_stats_index(func_ptr);
+	for (sz probe = 0; probe < AS_RENDER_QUEUE_STATS_COMMANDS_SIZE; probe++, index = (index + 1) & (AS_RENDER_QUEUE_STATS_COMMANDS_SIZE - 1))
+	{
+		as_rq_command_stats* command_stats = &queue->stats.commands[index];
+		if (command_stats->func_ptr == func_ptr) { return command_stats; }
+		if (!command_stats->func_ptr)
+		{
+			if (!is_adding) { return NULL; }
+			command_stats->func_ptr = func_ptr;
+			return command_stats;
+		}
+	}
+	return NULL;
+}
+
+static sz as_rq_key_index(void func_ptr(void*), void* target)
+{
+	u64 hash = (u64)(uintptr_t)target ^ ((u64)(uintptr_t)func_ptr * 0x9E3779B97F4A7C15ull);
+	hash ^= hash >> 29;
+	return (sz)(hash & (AS_RENDER_QUEUE_KEYS_SIZE - 1));
+}
+
+// keys_lock held, the slot of the key or the empty slot ending its probe, NULL when the table is full
+static as_render_command_key* as_rq_find_key(as_render_queue* queue, void func_ptr(void*), void* target)
+{
+	sz index = as_rq_key_index(func_ptr, target);
+	for (sz probe = 0; probe < AS_RENDER_QUEUE_KEYS_SIZE; probe++, index = (index + 1) & (AS_RENDER_QUEUE_KEYS_SIZE - 1))
+	{
+		as_render_command_key* key = &queue->keys[index];
+		if (!key->func_ptr || (key->func_ptr == func_ptr && key->target == target)) { return key; }
+	}
+	return NULL;
+}
+
+// false when the table is too full, the command is then submitted without a key
+static b8 as_rq_acquire_key(as_render_queue* queue, void func_ptr(void*), void* target)
+{
+	as_spinlock_lock(&queue->keys_lock);
+	as_render_command_key* key = as_rq_find_key(queue, func_ptr, target);
+	if (key && !key->func_ptr)
+	{
+		// kept under three quarters full so the probes stay short
+		if (queue->key_count >= AS_RENDER_QUEUE_KEYS_SIZE / 4 * 3)
+		{
+			key = NULL;
+		}
+		else
+		{
+			key->func_ptr = func_ptr;
+			key->target = target;
+			queue->key_count++;
+		}
+	}
+	if (key)
+	{
+		key->pending_count++;
+	}
+	as_spinlock_unlock(&queue->keys_lock);
+	return key != NULL;
+}
+
+// returns whether a newer command of the key is pending, every command in front of this one already ran so it can only be behind
+static b8 as_rq_release_key(as_render_queue* queue, void func_ptr(void*), void* target)
+{
+	as_spinlock_lock(&queue->keys_lock);
+	as_render_command_key* key = as_rq_find_key(queue, func_ptr, target);
+	if (!key || !key->func_ptr)
+	{
+		as_spinlock_unlock(&queue->keys_lock);
+		AS_LOG(LV_WARNING, "Released a render command key that was never acquired");
+		return false;
+	}
+	const b8 is_superseded = key->pending_count > 1;
+	if (--key->pending_count == 0)
+	{
+		// backward shift so probes never stop early at the freed slot
+		sz hole = (sz)(key - queue->keys);
+		memset(key, 0, sizeof(as_render_command_key));
+		for (sz index = (hole + 1) & (AS_RENDER_QUEUE_KEYS_SIZE - 1); queue->keys[index].func_ptr; index = (index + 1) & (AS_RENDER_QUEUE_KEYS_SIZE - 1))
+		{
+			const sz home = as_rq_key_index(queue->keys[index].func_ptr, queue->keys[index].target);
+			if (((index - home) & (AS_RENDER_QUEUE_KEYS_SIZE - 1)) >= ((index - hole) & (AS_RENDER_QUEUE_KEYS_SIZE - 1)))
+			{
+				queue->keys[hole] = queue->keys[index];
+				memset(&queue->keys[index], 0, sizeof(as_render_command_key));
+				hole = index;
+			}
+		}
+		queue->key_count--;
+	}
+	as_spinlock_unlock(&queue->keys_lock);
+	return is_superseded;
+}
+
+// consumer only, the budget is refilled by every frame command and only applies while frames keep coming
+static b8 as_rq_is_background_allowed(as_render_queue* queue)
+{
+	return queue->background_time < AS_RENDER_QUEUE_BACKGROUND_BUDGET
+		|| get_monotonic_time() - queue->last_frame_time >= AS_RENDER_QUEUE_BACKGROUND_IDLE_TIME;
+}
+
+// the front command of the first lane that may run, NULL when nothing can run now
+static as_render_command* as_rq_next_command(as_render_queue* queue, as_render_lane* out_lane)
+{
+	for (i32 lane = AS_RENDER_LANE_FRAME; lane < AS_RENDER_LANE_COUNT; lane++)
+	{
+		if (lane == AS_RENDER_LANE_BACKGROUND && !as_rq_is_background_allowed(queue)) { return NULL; }
+		as_render_command* command = as_mpsc_byte_ring_front(&queue->lanes[lane], NULL);
+		if (command)
+		{
+			*out_lane = (as_render_lane)lane;
+			return command;
+		}
+	}
+	return NULL;
+}
+
+// from the counts, so commands that are submitted but not committed yet keep the queue thread awake
+static b8 as_rq_has_runnable_commands(as_render_queue* queue)
+{
+	return as_rq_get_lane_size(queue, AS_RENDER_LANE_FRAME) > 0
+		|| as_rq_get_lane_size(queue, AS_RENDER_LANE_NORMAL) > 0
+		|| (as_rq_get_lane_size(queue, AS_RENDER_LANE_BACKGROUND) > 0 && as_rq_is_background_allowed(queue));
+}
+
+static void as_rq_execute_command(as_render_queue* queue, const as_render_lane lane, as_render_command* command)
+{
+	const f64 start_time = get_monotonic_time();
+	void (*func_ptr)(void*) = command->func_ptr;
+	const f64 latency = start_time - command->submit_time;
+	const b8 is_superseded = command->key_target && as_rq_release_key(queue, command->func_ptr, command->key_target);
+	if (is_superseded)
+	{
+		AS_ATOMIC_ADD_I64(&queue->coalesced_count, 1);
+	}
+	else if (command->func_ptr)
+	{
+		command->func_ptr(AS_RENDER_COMMAND_GET_ARG(command));
+	}
+	if (command->future)
+	{
+		as_future_complete(command->future, command->future_result);
+		as_future_release(command->future);
+	}
+	as_mpsc_byte_ring_pop_front(&queue->lanes[lane]);
+	AS_ATOMIC_ADD_I64(&queue->executed_counts[lane], 1); // counted after running so the queue size covers the command in flight
+
+	const f64 end_time = get_monotonic_time();
+	if (lane == AS_RENDER_LANE_BACKGROUND)
+	{
+		queue->background_time += end_time - start_time;
+	}
+	else if (lane == AS_RENDER_LANE_FRAME)
+	{
+		queue->background_time = 0.;
+		queue->last_frame_time = end_time;
+	}
+	as_rq_signal_progress(queue, lane);
+
+	as_rq_command_stats* command_stats = (func_ptr && !is_superseded) ? as_rq_find_command_stats(queue, func_ptr, true) : NULL;
+	if (command_stats)
+	{
+		as_histogram_record(&command_stats->execution_time, (u64)((end_time - start_time) * 1e9));
+		as_histogram_record(&command_stats->latency, (u64)(latency * 1e9));
+	}
+}
+
 void* as_render_queue_thread_run(as_render_queue* queue)
 {
 	if (AS_IS_INVALID(queue)) { return NULL; }
+	u32 idle_count = 0;
 	while (queue->is_running)
 	{
-		sz queue_size = 0;
-		AS_STATIC_ARRAY_VALID_SIZE(queue->commands, queue_size);
-		//const sz command_index = queue->commands.size - 1;
-		if (queue_size > 0)
+		as_render_lane lane = AS_RENDER_LANE_NORMAL;
+		as_render_command* command = as_rq_next_command(queue, &lane);
+		if (command)
 		{
+			idle_count = 0;
 			AS_WAIT_AND_LOCK(queue);
-			for (sz command_index = 0; command_index < AS_STATIC_ARRAY_SIZE(queue->commands); command_index++)
+			// bounded so producers that keep submitting cannot hold the thread in one batch, the lanes are checked again after each command
+			for (sz processed = 0; command && processed < AS_RENDER_QUEUE_SIZE; processed++, command = as_rq_next_command(queue, &lane))
 			{
-				//as_render_command* command = &queue->commands.data[command_index];
-				as_render_command* command = AS_STATIC_ARRAY_GET(queue->commands, command_index);
-				if (command && AS_STATIC_ARRAY_IS_VALID(queue->commands, command_index))
-				{
-					if (!command->executed && command->func_ptr)
-					{
-						command->executed = true;
-						command->func_ptr(command->arg);
-					}
-					AS_STATIC_ARRAY_REMOVE(queue->commands, command_index);
-				}
+				as_rq_execute_command(queue, lane, command);
 			}
 			AS_UNLOCK(queue);
+			if (queue->stats.log_period > 0. && get_monotonic_time() - queue->stats.last_log_time >= queue->stats.log_period)
+			{
+				queue->stats.last_log_time = get_monotonic_time();
+				as_rq_log_stats(queue);
+			}
+		}
+		else if (++idle_count < AS_RENDER_QUEUE_IDLE_SPIN_COUNT)
+		{
+			// woken for one command, going back to sleep right away would cost a wake for each of the next ones
+			if (idle_count < AS_RENDER_QUEUE_IDLE_PAUSE_COUNT) { AS_CPU_PAUSE(); }
+			else { as_thread_yield(); }
 		}
 		else
 		{
-			sleep_seconds(AS_RENDER_QUEUE_REST_TIME);
+			// checked again after announcing the sleep, a submit in between sees the flag and wakes us.
+			// counted but not found means a producer reserved its command and was preempted before committing it, let it run
+			const u32 epoch = AS_ATOMIC_LOAD_ACQUIRE_I32(&queue->work_epoch);
+			AS_ATOMIC_STORE_I64(&queue->is_consumer_sleeping, 1);
+			if (queue->is_running && !as_rq_has_runnable_commands(queue))
+			{
+				if (as_rq_get_lane_size(queue, AS_RENDER_LANE_BACKGROUND) > 0) // out of budget, until the next frame or the frames stop
+				{
+					as_wait_on_address_for(&queue->work_epoch, epoch, queue->last_frame_time + AS_RENDER_QUEUE_BACKGROUND_IDLE_TIME - get_monotonic_time());
+				}
+				else
+				{
+					as_wait_on_address(&queue->work_epoch, epoch);
+				}
+			}
+			else if (queue->is_running)
+			{
+				as_thread_yield();
+			}
+			AS_ATOMIC_STORE_I64(&queue->is_consumer_sleeping, 0);
+			idle_count = 0;
 		}
 	}
+	as_arena_destroy_frame();
 	return NULL;
 }
 
 as_render_queue* as_rq_create(as_render* render)
 {
-	as_render_queue* queue = AS_MALLOC_SINGLE(as_render_queue);
+	as_render_queue* queue = AS_MALLOC_SINGLE_TAGGED(as_render_queue, AS_MEMORY_TAG_QUEUE);
 	AS_SET_VALID(queue);
 	queue->render = render;
 	queue->is_running = true;
+	queue->stats.log_period = AS_RENDER_QUEUE_STATS_LOG_PERIOD;
+	queue->stats.last_log_time = get_monotonic_time();
+	as_mutex_init(&queue->capture_mutex);
+	as_mpsc_byte_ring_init(&queue->lanes[AS_RENDER_LANE_FRAME], AS_RENDER_QUEUE_FRAME_BYTES);
+	as_mpsc_byte_ring_init(&queue->lanes[AS_RENDER_LANE_NORMAL], AS_RENDER_QUEUE_BYTES);
+	as_mpsc_byte_ring_init(&queue->lanes[AS_RENDER_LANE_BACKGROUND], AS_RENDER_QUEUE_BYTES);
 	queue->thread = as_thread_create(&as_render_queue_thread_run, queue);
-	as_thread_set_priority(queue->thread, 2);
+	as_thread_set_name(queue->thread, "as_render");
+	if (AS_RENDER_THREAD_POLICY != AS_THREAD_POLICY_DEFAULT)
+	{
+		as_thread_set_policy(queue->thread, AS_RENDER_THREAD_POLICY, AS_RENDER_THREAD_PRIORITY);
+	}
+	else
+	{
+		as_thread_set_priority(queue->thread, AS_RENDER_THREAD_PRIORITY);
+	}
+	if (AS_RENDER_THREAD_CORE_MASK)
+	{
+		as_thread_set_affinity(queue->thread, AS_RENDER_THREAD_CORE_MASK);
+	}
 	AS_LOG(LV_LOG, "Created render queue");
 	return queue;
 }
@@ -56,53 +315,665 @@ void as_rq_destroy(as_render_queue* render_queue)
 	as_rq_wait_queue(render_queue);
 	render_queue->is_running = false;
 	render_queue->render = NULL;
+	AS_ATOMIC_ADD_I32(&render_queue->work_epoch, 1);
+	as_wake_address_one(&render_queue->work_epoch);
 	as_thread_join(render_queue->thread);
-	AS_LOG(LV_LOG, "Destroyed render queue");
+	as_rq_capture_stop(render_queue);
+	as_mutex_destroy(&render_queue->capture_mutex);
+	for (i32 lane = 0; lane < AS_RENDER_LANE_COUNT; lane++)
+	{
+		as_mpsc_byte_ring_destroy(&render_queue->lanes[lane]);
+	}
+	AS_FLOG(LV_LOG, "Destroyed render queue, %lld commands were coalesced", (long long)render_queue->coalesced_count);
 	AS_FREE(render_queue);
 }
 
-sz as_rq_get_queue_size(as_render_queue* render_queue)
+sz as_rq_get_lane_size(as_render_queue* render_queue, const as_render_lane lane)
 {
 	if (AS_IS_INVALID(render_queue)) { return 0; }
-	//return render_queue->commands.size;
-	sz current_size = 0;
-	AS_STATIC_ARRAY_VALID_SIZE(render_queue->commands, current_size);
-	return current_size;
+	const i64 size = AS_ATOMIC_LOAD_I64(&render_queue->submitted_counts[lane]) - AS_ATOMIC_LOAD_I64(&render_queue->executed_counts[lane]);
+	return size > 0 ? (sz)size : 0;
+}
+
+sz as_rq_get_queue_size(as_render_queue* render_queue)
+{
+	sz size = 0;
+	for (i32 lane = 0; lane < AS_RENDER_LANE_COUNT; lane++)
+	{
+		size += as_rq_get_lane_size(render_queue, (as_render_lane)lane);
+	}
+	return size;
+}
+
+// arg is the lane, or NULL for the whole queue
+static b8 as_rq_is_drained(as_render_queue* render_queue, void* arg)
+{
+	return arg ? as_rq_get_lane_size(render_queue, *(as_render_lane*)arg) == 0 : as_rq_get_queue_size(render_queue) == 0;
 }
 
 void as_rq_wait_queue(as_render_queue* render_queue)
 {
-	u32 iteration_counter = 0;
-	while (as_rq_get_queue_size(render_queue) > 0 && iteration_counter < AS_RENDER_QUEUE_MAX_WAIT_ITERATION)
+	if (AS_IS_INVALID(render_queue) || as_rq_get_queue_size(render_queue) == 0) { return; }
+	if (!as_rq_wait_for_progress(render_queue, &render_queue->drain_waiters, as_rq_is_drained, NULL))
 	{
-		sleep_seconds(AS_RENDER_QUEUE_WAIT_TIME);
-		iteration_counter++;
-		// wait for queue to be empty
+		AS_LOG(LV_WARNING, "Render queue did not drain in time, stopped waiting.");
 	}
 }
 
-void as_rq_submit(as_render_queue* render_queue, void func_ptr(void*), void* arg, const u64 arg_size)
+void as_rq_wait_lane(as_render_queue* render_queue, as_render_lane lane)
+{
+	if (AS_IS_INVALID(render_queue) || as_rq_get_lane_size(render_queue, lane) == 0) { return; }
+	if (!as_rq_wait_for_progress(render_queue, &render_queue->drain_waiters, as_rq_is_drained, &lane))
+	{
+		AS_FLOG(LV_WARNING, "Render queue lane %d did not drain in time, stopped waiting.", lane);
+	}
+}
+
+as_rq_ticket as_rq_get_last_ticket(as_render_queue* render_queue, const as_render_lane lane)
+{
+	if (AS_IS_INVALID(render_queue) || lane < 0 || lane >= AS_RENDER_LANE_COUNT) { return 0; }
+	return AS_RQ_TICKET_MAKE(lane, AS_ATOMIC_LOAD_ACQUIRE_I64(&render_queue->lanes[lane].head));
+}
+
+b8 as_rq_is_ticket_retired(as_render_queue* render_queue, const as_rq_ticket ticket)
+{
+	if (AS_IS_INVALID(render_queue) || ticket == 0) { return true; }
+	const as_render_lane lane = AS_RQ_TICKET_GET_LANE(ticket);
+	AS_WARNING_RETURN_VAL_IF_FALSE((lane < AS_RENDER_LANE_COUNT), true, "Invalid render queue ticket %llu", (unsigned long long)ticket);
+	// the tail moves past a command after it ran and its future completed
+	return AS_ATOMIC_LOAD_ACQUIRE_I64(&render_queue->lanes[lane].tail) >= AS_RQ_TICKET_GET_POSITION(ticket);
+}
+
+static b8 as_rq_is_ticket_retired_at(as_render_queue* render_queue, void* arg)
+{
+	return as_rq_is_ticket_retired(render_queue, *(as_rq_ticket*)arg);
+}
+
+b8 as_rq_wait_ticket(as_render_queue* render_queue, const as_rq_ticket ticket)
+{
+	if (as_rq_is_ticket_retired(render_queue, ticket)) { return true; }
+	as_rq_ticket waited_ticket = ticket;
+	if (!as_rq_wait_for_progress(render_queue, &render_queue->ticket_waiters, as_rq_is_ticket_retired_at, &waited_ticket))
+	{
+		AS_FLOG(LV_WARNING, "Render queue ticket %llu did not retire in time, stopped waiting.", (unsigned long long)ticket);
+		return false;
+	}
+	return true;
+}
+
+// what the pointers of a command argument stand for, the arguments of the named commands are structs of pointers
+typedef enum as_rq_binding_kind
+{
+	AS_RQ_BINDING_NONE			= 0x00, // written as 0, replayed as NULL
+	AS_RQ_BINDING_RENDER		= 0x01, // replayed as the render of the replaying queue
+	AS_RQ_BINDING_DISPLAY		= 0x02, // replayed as the display context given to as_rq_replay
+	AS_RQ_BINDING_SCENE			= 0x03, // replayed as the scene made for the replay
+	AS_RQ_BINDING_UI_GROUP		= 0x04, // replayed as the screen objects group made for the replay
+	AS_RQ_BINDING_TEXTURE		= 0x05, // written once, by its path
+	AS_RQ_BINDING_SHADER		= 0x06, // written once, by its paths and its textures
+	AS_RQ_BINDING_SHAPE			= 0x07, // written once, by its vertices and indices
+	AS_RQ_BINDING_OBJECT		= 0x08, // written once, by its shape, shader and transform
+	AS_RQ_BINDING_SCREEN_OBJECT	= 0x09, // written once, by its fragment path, data and textures
+	AS_RQ_BINDING_CAMERA		= 0x0A, // written by value with each command
+	AS_RQ_BINDING_SNAPSHOT		= 0x0B, // written by value with each command, its objects and screen objects as ids
+	AS_RQ_BINDING_UNIFORMS		= 0x0C, // written by value with each command, its textures as ids
+	AS_RQ_BINDING_COUNT			= 0x0D
+} as_rq_binding_kind;
+#define AS_RQ_MAX_ARG_POINTERS 8
+
+typedef struct as_rq_command_name
+{
+	void (*func_ptr)(void*);
+	const char* name;
+	b8 is_replayable; // false for the commands destroying what they point to, a replay destroys what it made once done
+	u32 pointer_count; // in the argument
+	u8 pointer_kinds[AS_RQ_MAX_ARG_POINTERS]; // as_rq_binding_kind of each pointer of the argument
+} as_rq_command_name;
+static const as_rq_command_name* as_rq_find_command(void func_ptr(void*));
+
+typedef enum as_rq_capture_record_type
+{
+	AS_RQ_CAPTURE_RECORD_COMMAND	= 0x00, // followed by its name and its argument
+	AS_RQ_CAPTURE_RECORD_BINDING	= 0x01, // followed by what its id stands for, before the first command using it
+} as_rq_capture_record_type;
+
+// a capture file is AS_RENDER_QUEUE_CAPTURE_MAGIC, then records each followed by name_size then data_size bytes.
+// the data of a command is a u32 id per pointer of its argument, then the values of its cameras, snapshots and uniforms
+typedef struct as_rq_capture_record
+{
+	u32 type; // as_rq_capture_record_type
+	u32 name_size; // commands, without terminator, 0 for commands as_rq_get_command_name does not know
+	u64 time; // commands, nanoseconds since the capture started
+	u32 lane; // commands
+	u32 pointer_count; // commands, 0 when not replayable
+	u32 key_index; // commands, pointer of the argument that is the coalescing key + 1, 0 when not keyed
+	u32 kind; // bindings, as_rq_binding_kind
+	u32 id; // bindings, from 1, the ids of this kind hold it from there on
+	u32 padding;
+	u64 data_size;
+} as_rq_capture_record;
+
+b8 as_rq_capture_start(as_render_queue* render_queue, const char* path)
+{
+	AS_WARNING_RETURN_VAL_IF_FALSE(!AS_IS_INVALID(render_queue), false, "Cannot capture render queue, invalid render queue %p", render_queue);
+	AS_WARNING_RETURN_VAL_IF_FALSE(path, false, "Cannot capture render queue, invalid path %p", path);
+	as_mutex_lock(&render_queue->capture_mutex);
+	if (render_queue->capture_file)
+	{
+		as_mutex_unlock(&render_queue->capture_mutex);
+		AS_LOG(LV_WARNING, "Cannot capture render queue, a capture is already running");
+		return false;
+	}
+	FILE* file = fopen(path, "wb");
+	if (!file)
+	{
+		as_mutex_unlock(&render_queue->capture_mutex);
+		AS_FLOG(LV_WARNING, "Cannot capture render queue, could not open %s", path);
+		return false;
+	}
+	fwrite(AS_RENDER_QUEUE_CAPTURE_MAGIC, 1, 8, file);
+	render_queue->capture_start_time = get_monotonic_time();
+	render_queue->capture_count = 0;
+	render_queue->capture_binding_count = 0;
+	render_queue->capture_file = file;
+	as_mutex_unlock(&render_queue->capture_mutex);
+	AS_FLOG(LV_LOG, "Capturing render queue to %s", path);
+	return true;
+}
+
+void as_rq_capture_stop(as_render_queue* render_queue)
+{
+	if (AS_IS_INVALID(render_queue)) { return; }
+	as_mutex_lock(&render_queue->capture_mutex);
+	if (render_queue->capture_file)
+	{
+		fclose(render_queue->capture_file);
+		render_queue->capture_file = NULL;
+		AS_FLOG(LV_LOG, "Stopped render queue capture, %zu commands and %u bindings captured", render_queue->capture_count, render_queue->capture_binding_count);
+	}
+	AS_VECTOR_FREE(render_queue->capture_bindings);
+	AS_VECTOR_FREE(render_queue->capture_bytes);
+	as_mutex_unlock(&render_queue->capture_mutex);
+}
+
+static void as_rq_capture_write(as_rq_capture_bytes* bytes, const void* data, const sz size)
+{
+	if (size == 0 || !AS_VECTOR_RESERVE(*bytes, bytes->size + size)) { return; }
+	memcpy(bytes->data + bytes->size, data, size);
+	bytes->size += size;
+}
+#define AS_RQ_CAPTURE_WRITE_VALUE(_bytes, _type, _value) { const _type _written = (_value); as_rq_capture_write((_bytes), &_written, sizeof(_type)); }
+
+static void as_rq_capture_write_string(as_rq_capture_bytes* bytes, const char* string)
+{
+	const u32 size = (u32)strnlen(string, AS_MAX_PATH_SIZE - 1);
+	as_rq_capture_write(bytes, &size, sizeof(size));
+	as_rq_capture_write(bytes, string, size);
+}
+
+// capture_mutex held, writes the record with the bytes appended since start, then cuts them off
+static void as_rq_capture_write_record(as_render_queue* render_queue, as_rq_capture_record* record, const char* name, const sz start)
+{
+	as_rq_capture_bytes* bytes = &render_queue->capture_bytes;
+	record->data_size = bytes->size - start;
+	fwrite(record, sizeof(as_rq_capture_record), 1, render_queue->capture_file);
+	if (record->name_size > 0) { fwrite(name, 1, record->name_size, render_queue->capture_file); }
+	if (record->data_size > 0) { fwrite(bytes->data + start, 1, record->data_size, render_queue->capture_file); }
+	bytes->size = start;
+}
+
+static sz as_rq_binding_index(const void* ptr, const u32 kind, const sz capacity)
+{
+	const u64 hash = ((u64)(uintptr_t)ptr ^ kind) * 0x9E3779B97F4A7C15ull;
+	return (sz)(hash >> 32) & (capacity - 1);
+}
+
+// the slot of (ptr, kind) or the empty slot ending its probe, the table is never full
+static as_rq_capture_binding* as_rq_find_binding(as_rq_capture_bindings* bindings, const void* ptr, const u32 kind)
+{
+	for (sz index = as_rq_binding_index(ptr, kind, bindings->capacity); ; index = (index + 1) & (bindings->capacity - 1))
+	{
+		as_rq_capture_binding* binding = &bindings->data[index];
+		if (!binding->ptr || (binding->ptr == ptr && binding->kind == kind)) { return binding; }
+	}
+}
+
+// rehashed into twice the slots past three quarters, so the probes stay short
+static b8 as_rq_reserve_binding(as_rq_capture_bindings* bindings)
+{
+	if (bindings->capacity > 0 && bindings->size < bindings->capacity / 4 * 3) { return true; }
+	as_rq_capture_bindings grown = { 0 };
+	grown.capacity = bindings->capacity > 0 ? bindings->capacity * 2 : AS_RENDER_QUEUE_CAPTURE_BINDINGS_SIZE;
+	grown.data = (as_rq_capture_binding*)AS_MALLOC_TAGGED(grown.capacity * sizeof(as_rq_capture_binding), "as_rq_capture_binding", AS_MEMORY_TAG_QUEUE);
+	if (!grown.data) { return false; }
+	for (sz i = 0; i < bindings->capacity; i++)
+	{
+		if (!bindings->data[i].ptr) { continue; }
+		*as_rq_find_binding(&grown, bindings->data[i].ptr, bindings->data[i].kind) = bindings->data[i];
+	}
+	grown.size = bindings->size;
+	AS_FREE(bindings->data);
+	*bindings = grown;
+	return true;
+}
+
+static u32 as_rq_capture_bind(as_render_queue* render_queue, const void* ptr, const as_rq_binding_kind kind);
+
+// textures as ids, the other uniform types are not added anywhere yet and are left out
+static void as_rq_capture_write_uniforms(as_render_queue* render_queue, const as_shader_uniforms* uniforms)
+{
+	as_rq_capture_bytes* bytes = &render_queue->capture_bytes;
+	u32 texture_count = 0;
+	for (sz i = 0; i < uniforms->size; i++)
+	{
+		texture_count += uniforms->data[i].type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	}
+	as_rq_capture_write(bytes, &texture_count, sizeof(texture_count));
+	for (sz i = 0; i < uniforms->size; i++)
+	{
+		if (uniforms->data[i].type != VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER) { continue; }
+		AS_RQ_CAPTURE_WRITE_VALUE(bytes, u32, (u32)uniforms->data[i].stage);
+		AS_RQ_CAPTURE_WRITE_VALUE(bytes, u32, as_rq_capture_bind(render_queue, uniforms->data[i].data, AS_RQ_BINDING_TEXTURE));
+	}
+}
+
+// the objects removed since the snapshot was taken are written as 0, like the render skips them
+static void as_rq_capture_write_snapshot(as_render_queue* render_queue, const as_render_snapshot* snapshot)
+{
+	as_rq_capture_bytes* bytes = &render_queue->capture_bytes;
+	const u64 objects_size = snapshot->objects_size < AS_RENDER_SNAPSHOT_MAX_OBJECTS ? snapshot->objects_size : AS_RENDER_SNAPSHOT_MAX_OBJECTS;
+	as_rq_capture_write(bytes, &objects_size, sizeof(objects_size));
+	for (sz i = 0; i < objects_size; i++)
+	{
+		const as_object* object = snapshot->objects[i];
+		const b8 is_current = !AS_IS_INVALID(object) && object->handle.index == snapshot->objects_handles[i].index && object->handle.generation == snapshot->objects_handles[i].generation;
+		AS_RQ_CAPTURE_WRITE_VALUE(bytes, u32, is_current ? as_rq_capture_bind(render_queue, object, AS_RQ_BINDING_OBJECT) : 0);
+	}
+	as_rq_capture_write(bytes, snapshot->objects_transforms, sizeof(as_mat4) * (objects_size < AS_MAX_GPU_OBJECT_TRANSFORMS_SIZE ? objects_size : AS_MAX_GPU_OBJECT_TRANSFORMS_SIZE));
+	as_rq_capture_write(bytes, &snapshot->camera, sizeof(as_camera));
+	const u64 ui_size = snapshot->ui_size < AS_MAX_SCREEN_OBJECTS ? snapshot->ui_size : AS_MAX_SCREEN_OBJECTS;
+	as_rq_capture_write(bytes, &ui_size, sizeof(ui_size));
+	for (sz i = 0; i < ui_size; i++)
+	{
+		AS_RQ_CAPTURE_WRITE_VALUE(bytes, u32, as_rq_capture_bind(render_queue, snapshot->ui_objects[i], AS_RQ_BINDING_SCREEN_OBJECT));
+	}
+	as_rq_capture_write(bytes, snapshot->ui_data, sizeof(as_mat4) * ui_size);
+	as_rq_capture_write(bytes, snapshot->ui_custom_data, sizeof(snapshot->ui_custom_data[0]) * ui_size);
+	as_rq_capture_write(bytes, &snapshot->frame_index, sizeof(snapshot->frame_index));
+}
+
+// capture_mutex held, what ptr stands for, the bindings it needs are written before it
+static void as_rq_capture_write_binding(as_render_queue* render_queue, const void* ptr, const as_rq_binding_kind kind, const u32 id)
+{
+	as_rq_capture_bytes* bytes = &render_queue->capture_bytes;
+	const sz start = bytes->size;
+	switch (kind)
+	{
+	case AS_RQ_BINDING_TEXTURE:
+	{
+		const as_texture* texture = (const as_texture*)ptr;
+		as_rq_capture_write_string(bytes, texture->filename);
+		AS_RQ_CAPTURE_WRITE_VALUE(bytes, u8, texture->image_view != VK_NULL_HANDLE);
+		break;
+	}
+	case AS_RQ_BINDING_SHADER:
+	{
+		const as_shader* shader = (const as_shader*)ptr;
+		as_rq_capture_write_string(bytes, shader->filename_vertex);
+		as_rq_capture_write_string(bytes, shader->filename_fragment);
+		as_rq_capture_write_uniforms(render_queue, &shader->uniforms);
+		AS_RQ_CAPTURE_WRITE_VALUE(bytes, u8, shader->graphics_pipeline != VK_NULL_HANDLE);
+		break;
+	}
+	case AS_RQ_BINDING_SHAPE:
+	{
+		const as_shape* shape = (const as_shape*)ptr;
+		const u64 vertices_size = shape->vertices_size < AS_MAX_VERTICES_SIZE ? shape->vertices_size : AS_MAX_VERTICES_SIZE;
+		const u64 indices_size = shape->indices_size < AS_MAX_INDICES_SIZE ? shape->indices_size : AS_MAX_INDICES_SIZE;
+		as_rq_capture_write(bytes, &vertices_size, sizeof(vertices_size));
+		as_rq_capture_write(bytes, &indices_size, sizeof(indices_size));
+		as_rq_capture_write(bytes, shape->vertices, sizeof(as_vertex) * vertices_size);
+		as_rq_capture_write(bytes, shape->indices, sizeof(u16) * indices_size);
+		break;
+	}
+	case AS_RQ_BINDING_OBJECT:
+	{
+		// the shape and shader are only set once uploaded, the command uploading it names them otherwise
+		const as_object* object = (const as_object*)ptr;
+		AS_RQ_CAPTURE_WRITE_VALUE(bytes, u32, as_rq_capture_bind(render_queue, object->shape, AS_RQ_BINDING_SHAPE));
+		AS_RQ_CAPTURE_WRITE_VALUE(bytes, u32, as_rq_capture_bind(render_queue, object->shader, AS_RQ_BINDING_SHADER));
+		as_rq_capture_write(bytes, &object->transform, sizeof(as_transform));
+		as_rq_capture_write(bytes, &object->instance_count, sizeof(object->instance_count));
+		AS_RQ_CAPTURE_WRITE_VALUE(bytes, u8, object->vertex_buffer != VK_NULL_HANDLE);
+		break;
+	}
+	case AS_RQ_BINDING_SCREEN_OBJECT:
+	{
+		const as_screen_object* screen_object = (const as_screen_object*)ptr;
+		as_rq_capture_write_string(bytes, screen_object->filename_fragment);
+		AS_RQ_CAPTURE_WRITE_VALUE(bytes, u32, (u32)screen_object->type);
+		as_rq_capture_write(bytes, &screen_object->data, sizeof(as_mat4));
+		as_rq_capture_write(bytes, screen_object->custom_data, sizeof(screen_object->custom_data));
+		as_rq_capture_write_uniforms(render_queue, &screen_object->uniforms);
+		AS_RQ_CAPTURE_WRITE_VALUE(bytes, u8, screen_object->pipeline != VK_NULL_HANDLE);
+		break;
+	}
+	default:
+		break;
+	}
+	as_rq_capture_record record = { 0 };
+	record.type = AS_RQ_CAPTURE_RECORD_BINDING;
+	record.kind = (u32)kind;
+	record.id = id;
+	as_rq_capture_write_record(render_queue, &record, NULL, start);
+}
+
+static as_handle as_rq_get_binding_handle(const void* ptr, const as_rq_binding_kind kind)
+{
+	switch (kind)
+	{
+	case AS_RQ_BINDING_TEXTURE: return ((const as_texture*)ptr)->handle;
+	case AS_RQ_BINDING_SHADER: return ((const as_shader*)ptr)->handle;
+	case AS_RQ_BINDING_OBJECT: return ((const as_object*)ptr)->handle;
+	default: return AS_HANDLE_INVALID;
+	}
+}
+
+// capture_mutex held, the id written for ptr. the first time, what it stands for is written before
+static u32 as_rq_capture_bind(as_render_queue* render_queue, const void* ptr, const as_rq_binding_kind kind)
+{
+	if (!ptr || kind == AS_RQ_BINDING_NONE) { return 0; }
+	if (kind < AS_RQ_BINDING_TEXTURE || kind > AS_RQ_BINDING_SCREEN_OBJECT) { return 1; } // the replay has its own, or the value follows
+	if (!as_rq_reserve_binding(&render_queue->capture_bindings)) { return 0; }
+	const as_handle handle = as_rq_get_binding_handle(ptr, kind);
+	as_rq_capture_binding* binding = as_rq_find_binding(&render_queue->capture_bindings, ptr, kind);
+	if (binding->ptr && binding->handle.index == handle.index && binding->handle.generation == handle.generation)
+	{
+		return binding->id;
+	}
+	// new, or a new one at the address of a destroyed one
+	render_queue->capture_bindings.size += binding->ptr ? 0 : 1;
+	binding->ptr = ptr;
+	binding->kind = (u32)kind;
+	binding->id = ++render_queue->capture_binding_count;
+	binding->handle = handle;
+	const u32 id = binding->id; // the slot may move while the bindings it needs are added
+	as_rq_capture_write_binding(render_queue, ptr, kind, id);
+	return id;
+}
+
+static void as_rq_capture_command(as_render_queue* render_queue, const as_render_lane lane, void func_ptr(void*), void* key_target, void* arg, const u64 arg_size, const f64 submit_time)
+{
+	const as_rq_command_name* command = as_rq_find_command(func_ptr);
+	as_rq_capture_record record = { 0 };
+	record.type = AS_RQ_CAPTURE_RECORD_COMMAND;
+	record.lane = (u32)lane;
+	record.name_size = command ? (u32)strlen(command->name) : 0;
+	as_mutex_lock(&render_queue->capture_mutex);
+	if (render_queue->capture_file)
+	{
+		record.time = submit_time > render_queue->capture_start_time ? (u64)((submit_time - render_queue->capture_start_time) * 1e9) : 0;
+		as_rq_capture_bytes* bytes = &render_queue->capture_bytes;
+		const sz start = bytes->size;
+		if (command && command->is_replayable && arg_size == command->pointer_count * sizeof(void*))
+		{
+			void* const* pointers = (void* const*)arg;
+			record.pointer_count = command->pointer_count;
+			for (u32 i = 0; i < command->pointer_count; i++)
+			{
+				AS_RQ_CAPTURE_WRITE_VALUE(bytes, u32, as_rq_capture_bind(render_queue, pointers[i], (as_rq_binding_kind)command->pointer_kinds[i]));
+				if (key_target && pointers[i] == key_target && record.key_index == 0) { record.key_index = i + 1; }
+			}
+			for (u32 i = 0; i < command->pointer_count; i++)
+			{
+				if (!pointers[i]) { continue; }
+				switch (command->pointer_kinds[i])
+				{
+				case AS_RQ_BINDING_CAMERA: as_rq_capture_write(bytes, pointers[i], sizeof(as_camera)); break;
+				case AS_RQ_BINDING_SNAPSHOT: as_rq_capture_write_snapshot(render_queue, (const as_render_snapshot*)pointers[i]); break;
+				case AS_RQ_BINDING_UNIFORMS: as_rq_capture_write_uniforms(render_queue, (const as_shader_uniforms*)pointers[i]); break;
+				default: break;
+				}
+			}
+		}
+		as_rq_capture_write_record(render_queue, &record, command ? command->name : NULL, start);
+		render_queue->capture_count++;
+	}
+	as_mutex_unlock(&render_queue->capture_mutex);
+}
+
+typedef struct as_rq_reservation
+{
+	as_render_lane lane;
+	u64 size;
+	as_render_command* command;
+	i64 end_position;
+} as_rq_reservation;
+
+static b8 as_rq_try_reserve(as_render_queue* render_queue, void* arg)
+{
+	as_rq_reservation* reservation = (as_rq_reservation*)arg;
+	reservation->command = as_mpsc_byte_ring_reserve(&render_queue->lanes[reservation->lane], reservation->size, &reservation->end_position);
+	return reservation->command != NULL;
+}
+
+// returns the ticket of the command, 0 when it was dropped
+static as_rq_ticket as_rq_push_command(as_render_queue* render_queue, as_render_lane lane, void func_ptr(void*), void* key_target, void* arg, const u64 arg_size, as_future* future, void* future_result)
+{
+	AS_WARNING_RETURN_VAL_IF_FALSE((lane >= 0 && lane < AS_RENDER_LANE_COUNT), 0, "Cannot submit to renderer queue, invalid lane %d", lane);
+	AS_WARNING_RETURN_VAL_IF_FALSE((arg_size <= AS_RENDER_QUEUE_MAX_ARG_SIZE), 0, "Cannot submit to renderer queue, argument too big");
+	// callers of a synchronous upload expect what they submit next to see it, so that follows it while it is pending
+	const b8 is_following = lane == AS_RENDER_LANE_NORMAL && !as_rq_is_ticket_retired(render_queue, (as_rq_ticket)AS_ATOMIC_LOAD_I64(&render_queue->follow_ticket));
+	if (is_following)
+	{
+		lane = AS_RENDER_LANE_BACKGROUND;
+	}
+	// counted before the command is in the ring, so the queue thread sees it as pending when it reaches an older one
+	if (key_target && !as_rq_acquire_key(render_queue, func_ptr, key_target))
+	{
+		key_target = NULL;
+	}
+	as_rq_reservation reservation = { lane, sizeof(as_render_command) + arg_size, NULL, 0 };
+	if (!as_rq_try_reserve(render_queue, &reservation))
+	{
+		AS_LOG(LV_WARNING, "Render queue is full, please check your update/submission rates, waiting for it to drain.");
+		if (!as_rq_wait_for_progress(render_queue, &render_queue->room_waiters, as_rq_try_reserve, &reservation))
+		{
+			if (key_target)
+			{
+				as_rq_release_key(render_queue, func_ptr, key_target);
+			}
+			AS_LOG(LV_ERROR, "Dropped a render command, the render queue did not drain.");
+			return 0;
+		}
+	}
+	as_render_command* command = reservation.command;
+	command->func_ptr = func_ptr;
+	command->future = future;
+	command->future_result = future_result;
+	command->key_target = key_target;
+	command->arg_size = arg_size;
+	command->submit_time = get_monotonic_time();
+	if (arg_size > 0)
+	{
+		memcpy(AS_RENDER_COMMAND_GET_ARG(command), arg, arg_size);
+	}
+	if (render_queue->capture_file) // checked again under the capture lock
+	{
+		as_rq_capture_command(render_queue, lane, func_ptr, key_target, arg, arg_size, command->submit_time);
+	}
+	AS_ATOMIC_ADD_I64(&render_queue->submitted_counts[lane], 1); // before the commit so the consumer never counts more than was submitted
+	as_mpsc_byte_ring_commit(command);
+	as_rq_signal_work(render_queue); // after the count, the queue thread checks it again after announcing its sleep
+	as_histogram_record(&render_queue->stats.queue_depth, as_rq_get_queue_size(render_queue));
+	const as_rq_ticket ticket = AS_RQ_TICKET_MAKE(lane, reservation.end_position);
+	if (is_following)
+	{
+		AS_ATOMIC_STORE_I64(&render_queue->follow_ticket, (i64)ticket);
+	}
+	return ticket;
+}
+
+// a synchronous upload, in the background lane so a burst of them does not hold the frames back
+static void as_rq_push_upload(as_render_queue* render_queue, void func_ptr(void*), void* key_target, void* arg, const u64 arg_size)
+{
+	AS_ASSERT(render_queue, "Cannot submit to renderer queue, render_queue is null");
+	const as_rq_ticket ticket = as_rq_push_command(render_queue, AS_RENDER_LANE_BACKGROUND, func_ptr, key_target, arg, arg_size, NULL, NULL);
+	if (ticket)
+	{
+		AS_ATOMIC_STORE_I64(&render_queue->follow_ticket, (i64)ticket);
+	}
+}
+
+as_rq_ticket as_rq_submit(as_render_queue* render_queue, void func_ptr(void*), void* arg, const u64 arg_size)
+{
+	return as_rq_submit_to_lane(render_queue, AS_RENDER_LANE_NORMAL, func_ptr, arg, arg_size);
+}
+
+as_rq_ticket as_rq_submit_to_lane(as_render_queue* render_queue, const as_render_lane lane, void func_ptr(void*), void* arg, const u64 arg_size)
+{
+	AS_ASSERT(render_queue, "Cannot submit to renderer queue, render_queue is null");
+	AS_ASSERT(func_ptr, "Cannot submit to renderer queue, func_ptr is null");
+	return as_rq_push_command(render_queue, lane, func_ptr, NULL, arg, arg_size, NULL, NULL);
+}
+
+void as_rq_submit_keyed(as_render_queue* render_queue, void func_ptr(void*), void* key_target, void* arg, const u64 arg_size)
 {
 	AS_ASSERT(render_queue, "Cannot submit to renderer queue, render_queue is null");
 	AS_ASSERT(func_ptr, "Cannot submit to renderer queue, func_ptr is null");
+	as_rq_push_command(render_queue, AS_RENDER_LANE_NORMAL, func_ptr, key_target, arg, arg_size, NULL, NULL);
+}
+
+sz as_rq_get_coalesced_count(as_render_queue* render_queue)
+{
+	if (AS_IS_INVALID(render_queue)) { return 0; }
+	return (sz)AS_ATOMIC_LOAD_I64(&render_queue->coalesced_count);
+}
+
+as_rq_stats* as_rq_get_stats(as_render_queue* render_queue)
+{
+	if (AS_IS_INVALID(render_queue)) { return NULL; }
+	return &render_queue->stats;
+}
+
+as_rq_command_stats* as_rq_get_command_stats(as_render_queue* render_queue, void func_ptr(void*))
+{
+	if (AS_IS_INVALID(render_queue) || !func_ptr) { return NULL; }
+	return as_rq_find_command_stats(render_queue, func_ptr, false);
+}
+
+void as_rq_reset_stats(as_render_queue* render_queue)
+{
+	if (AS_IS_INVALID(render_queue)) { return; }
+	for (sz i = 0; i < AS_RENDER_QUEUE_STATS_COMMANDS_SIZE; i++)
+	{
+		as_histogram_reset(&render_queue->stats.commands[i].execution_time);
+		as_histogram_reset(&render_queue->stats.commands[i].latency);
+	}
+	as_histogram_reset(&render_queue->stats.queue_depth);
+	as_histogram_reset(&render_queue->stats.producer_wait);
+}
+
+void as_rq_set_stats_log_period(as_render_queue* render_queue, const f64 seconds)
+{
+	if (AS_IS_INVALID(render_queue)) { return; }
+	render_queue->stats.log_period = seconds;
+}
+
+void as_rq_log_stats(as_render_queue* render_queue)
+{
+	if (AS_IS_INVALID(render_queue)) { return; }
+	const as_histogram_summary depth = as_histogram_summarize(&render_queue->stats.queue_depth);
+	const as_histogram_summary wait = as_histogram_summarize(&render_queue->stats.producer_wait);
+	AS_FLOG(LV_LOG, "Render queue depth: p50=%llu p95=%llu p99=%llu max=%llu over %lld submissions",
+		(unsigned long long)depth.p50, (unsigned long long)depth.p95, (unsigned long long)depth.p99, (unsigned long long)depth.max, (long long)depth.count);
+	AS_FLOG(LV_LOG, "Render queue producer wait (us): p50=%.1f p95=%.1f p99=%.1f max=%.1f over %lld waits",
+		wait.p50 / 1e3, wait.p95 / 1e3, wait.p99 / 1e3, wait.max / 1e3, (long long)wait.count);
+	for (sz i = 0; i < AS_RENDER_QUEUE_STATS_COMMANDS_SIZE; i++)
+	{
+		as_rq_command_stats* command_stats = &render_queue->stats.commands[i];
+		if (!command_stats->func_ptr) { continue; }
+		const as_histogram_summary execution = as_histogram_summarize(&command_stats->execution_time);
+		const as_histogram_summary latency = as_histogram_summarize(&command_stats->latency);
+		const char* name = as_rq_get_command_name(command_stats->func_ptr);
+		AS_FLOG(LV_LOG, "Render command %s (%p), %lld runs, execution (us): p50=%.1f p95=%.1f p99=%.1f max=%.1f, latency (us): p50=%.1f p95=%.1f p99=%.1f max=%.1f",
+			name ? name : "unknown", (void*)command_stats->func_ptr, (long long)execution.count,
+			execution.p50 / 1e3, execution.p95 / 1e3, execution.p99 / 1e3, execution.max / 1e3,
+			latency.p50 / 1e3, latency.p95 / 1e3, latency.p99 / 1e3, latency.max / 1e3);
+	}
+}
 
-	AS_WAIT_AND_LOCK(render_queue);
+static void as_rq_dump_histogram(FILE* file, const char* name, const char* metric, as_histogram* histogram, const as_memory_dump_format format)
+{
+	const as_histogram_summary summary = as_histogram_summarize(histogram);
+	if (format == AS_MEMORY_DUMP_CSV)
+	{
+		fprintf(file, "%s,%s,%lld,%llu,%llu,%llu,%llu\n", name, metric, (long long)summary.count,
+			(unsigned long long)summary.p50, (unsigned long long)summary.p95, (unsigned long long)summary.p99, (unsigned long long)summary.max);
+	}
+	else
+	{
+		fprintf(file, "\t\t{ \"name\": \"%s\", \"metric\": \"%s\", \"count\": %lld, \"p50\": %llu, \"p95\": %llu, \"p99\": %llu, \"max\": %llu },\n", name, metric, (long long)summary.count,
+			(unsigned long long)summary.p50, (unsigned long long)summary.p95, (unsigned long long)summary.p99, (unsigned long long)summary.max);
+	}
+}
+
+b8 as_rq_dump_stats(as_render_queue* render_queue, const char* path, const as_memory_dump_format format)
+{
+	AS_WARNING_RETURN_VAL_IF_FALSE(!AS_IS_INVALID(render_queue), false, "Cannot dump render queue stats, invalid render queue %p", render_queue);
+	AS_WARNING_RETURN_VAL_IF_FALSE(path, false, "Cannot dump render queue stats, invalid path %p", path);
+	FILE* file = fopen(path, "w");
+	AS_WARNING_RETURN_VAL_IF_FALSE(file, false, "Cannot dump render queue stats, could not open %s", path);
+
+	// durations in nanoseconds, depth in commands
+	fprintf(file, format == AS_MEMORY_DUMP_CSV ? "name,metric,count,p50,p95,p99,max\n" : "{\n\t\"histograms\": [\n");
+	as_rq_dump_histogram(file, "render_queue", "depth", &render_queue->stats.queue_depth, format);
+	as_rq_dump_histogram(file, "render_queue", "producer_wait_ns", &render_queue->stats.producer_wait, format);
+	for (sz i = 0; i < AS_RENDER_QUEUE_STATS_COMMANDS_SIZE; i++)
+	{
+		as_rq_command_stats* command_stats = &render_queue->stats.commands[i];
+		if (!command_stats->func_ptr) { continue; }
+		const char* name = as_rq_get_command_name(command_stats->func_ptr);
+		char unknown_name[32] = { 0 };
+		if (!name)
+		{
+			snprintf(unknown_name, sizeof(unknown_name), "%p", (void*)command_stats->func_ptr);
+			name = unknown_name;
+		}
+		as_rq_dump_histogram(file, name, "execution_ns", &command_stats->execution_time, format);
+		as_rq_dump_histogram(file, name, "latency_ns", &command_stats->latency, format);
+	}
+	if (format == AS_MEMORY_DUMP_JSON)
+	{
+		// closes the list, every entry above ends with a comma
+		fprintf(file, "\t\t{ \"name\": \"render_queue\", \"metric\": \"coalesced\", \"count\": %lld }\n\t]\n}\n", (long long)as_rq_get_coalesced_count(render_queue));
+	}
+	fclose(file);
+	return true;
+}
+
+as_future* as_rq_submit_async(as_render_queue* render_queue, void func_ptr(void*), void* arg, const u64 arg_size, void* result)
+{
+	return as_rq_submit_async_to_lane(render_queue, AS_RENDER_LANE_NORMAL, func_ptr, arg, arg_size, result);
+}
+
+as_future* as_rq_submit_async_to_lane(as_render_queue* render_queue, const as_render_lane lane, void func_ptr(void*), void* arg, const u64 arg_size, void* result)
+{
+	AS_ASSERT(render_queue, "Cannot submit to renderer queue, render_queue is null");
+	AS_ASSERT(func_ptr, "Cannot submit to renderer queue, func_ptr is null");
 
-	as_render_command command = { 0 };
-	command.func_ptr = func_ptr;
-	memcpy(command.arg, arg, arg_size);
-	sz command_index = -1;
-	//AS_STATIC_ARRAY_ADD(render_queue->commands, command_index);
-	//AS_STATIC_ARRAY_GET(queue)
-	AS_STATIC_ARRAY_ADD_DATA(render_queue->commands, &command, sizeof(command), command_index);
-	
-	if (as_rq_get_queue_size(render_queue) > AS_RENDER_QUEUE_SIZE)
+	as_future* future = as_future_create();
+	as_future_retain(future); // released by the render thread
+	// not keyed, a skipped command would complete its future before the work was done
+	if (!as_rq_push_command(render_queue, lane, func_ptr, NULL, arg, arg_size, future, result))
 	{
-		AS_LOG(LV_ERROR, "Overflowing render queue, please check your update/submission rates, potential crash.");
+		as_future_complete(future, NULL);
+		as_future_release(future);
 	}
-	AS_UNLOCK(render_queue);
+	return future;
 }
 
+
 void as_render_start_draw_loop_func(as_render* render) 
 { 
 	AS_WAIT_AND_LOCK(render);
@@ -132,24 +1003,34 @@ typedef struct as_render_draw_frame_arg
 	as_camera* camera;
 	as_scene* scene;
 	as_screen_objects_group* ui_objects_group;
+	const as_render_snapshot* snapshot;
 } as_render_draw_frame_arg;
 void as_render_draw_frame_func(as_render_draw_frame_arg* draw_frame_arg)
 {
 	AS_WAIT_AND_LOCK(draw_frame_arg->render);
-	as_render_draw_frame(draw_frame_arg->render, draw_frame_arg->display_context, draw_frame_arg->camera, draw_frame_arg->scene, draw_frame_arg->ui_objects_group);
+	as_render_draw_frame(draw_frame_arg->render, draw_frame_arg->display_context, draw_frame_arg->camera, draw_frame_arg->scene, draw_frame_arg->ui_objects_group, draw_frame_arg->snapshot);
 	AS_UNLOCK(draw_frame_arg->render);
+	as_arena_reset(as_arena_get_frame()); // the frame arena of this thread, where the render code allocates
 }
-void as_rq_render_draw_frame(as_render_queue* render_queue, as_render* render, void* display_context, as_camera* camera,  as_scene* scene, as_screen_objects_group* ui_objects_group)
+as_rq_ticket as_rq_render_draw_frame(as_render_queue* render_queue, as_render* render, void* display_context, as_camera* camera,  as_scene* scene, as_screen_objects_group* ui_objects_group)
 {
-	AS_WAIT_AND_LOCK(render);
 	as_render_draw_frame_arg draw_frame_arg = { 0 };
 	draw_frame_arg.render = render;
 	draw_frame_arg.display_context = display_context;
 	draw_frame_arg.scene = scene;
 	draw_frame_arg.camera = camera;
 	draw_frame_arg.ui_objects_group = ui_objects_group;
-	as_rq_submit(render_queue, &as_render_draw_frame_func, &draw_frame_arg, sizeof(draw_frame_arg));
-	AS_UNLOCK(render);
+	return as_rq_submit_to_lane(render_queue, AS_RENDER_LANE_FRAME, &as_render_draw_frame_func, &draw_frame_arg, sizeof(draw_frame_arg));
+}
+as_future* as_rq_render_draw_frame_snapshot(as_render_queue* render_queue, as_render* render, void* display_context, as_scene* scene, as_screen_objects_group* ui_objects_group, const as_render_snapshot* snapshot)
+{
+	as_render_draw_frame_arg draw_frame_arg = { 0 };
+	draw_frame_arg.render = render;
+	draw_frame_arg.display_context = display_context;
+	draw_frame_arg.scene = scene;
+	draw_frame_arg.ui_objects_group = ui_objects_group;
+	draw_frame_arg.snapshot = snapshot;
+	return as_rq_submit_async_to_lane(render_queue, AS_RENDER_LANE_FRAME, &as_render_draw_frame_func, &draw_frame_arg, sizeof(draw_frame_arg), (void*)snapshot);
 }
 
 void as_render_destroy_func(as_render* render)
@@ -178,7 +1059,7 @@ void as_rq_screen_object_update(as_render_queue* render_queue, as_screen_object*
 	as_screen_object_update_arg arg = { 0 };
 	arg.render = render_queue->render;
 	arg.screen_object = screen_object;
-	as_rq_submit(render_queue, &as_screen_object_update_func, &arg, sizeof(arg));
+	as_rq_submit_keyed(render_queue, &as_screen_object_update_func, screen_object, &arg, sizeof(arg));
 }
 
 typedef struct as_screen_object_recompile_arg
@@ -197,7 +1078,7 @@ void as_rq_screen_object_recompile(as_render_queue* render_queue, as_screen_obje
 	{
 		as_screen_object_update_arg arg = { 0 };
 		arg.screen_object = screen_object;
-		as_rq_submit(render_queue, &as_screen_object_recompile_func, &arg, sizeof(arg));
+		as_rq_submit_keyed(render_queue, &as_screen_object_recompile_func, screen_object, &arg, sizeof(arg));
 	}
 	else if (render_queue->render)
 	{
@@ -221,7 +1102,14 @@ void as_rq_texture_update(as_render_queue* render_queue, as_texture* texture, as
 	as_texture_update_arg texture_update_arg = { 0 };
 	texture_update_arg.render = render;
 	texture_update_arg.texture = texture;
-	as_rq_submit(render_queue, &as_texture_update_func, &texture_update_arg, sizeof(texture_update_arg));
+	as_rq_push_upload(render_queue, &as_texture_update_func, texture, &texture_update_arg, sizeof(texture_update_arg));
+}
+as_future* as_rq_texture_update_async(as_render_queue* render_queue, as_texture* texture, as_render* render)
+{
+	as_texture_update_arg texture_update_arg = { 0 };
+	texture_update_arg.render = render;
+	texture_update_arg.texture = texture;
+	return as_rq_submit_async_to_lane(render_queue, AS_RENDER_LANE_BACKGROUND, &as_texture_update_func, &texture_update_arg, sizeof(texture_update_arg), texture);
 }
 
  typedef struct as_texture_destroy_arg
@@ -276,7 +1164,14 @@ void as_rq_texture_update(as_render_queue* render_queue, as_texture* texture, as
 	 as_shader_update_arg shader_update_arg = { 0 };
 	 shader_update_arg.render = render;
 	 shader_update_arg.shader = shader;
-	 as_rq_submit(render_queue, &as_shader_update_func, &shader_update_arg, sizeof(shader_update_arg));
+	 as_rq_submit_keyed(render_queue, &as_shader_update_func, shader, &shader_update_arg, sizeof(shader_update_arg));
+}
+ as_future* as_rq_shader_update_async(as_render_queue* render_queue, as_render* render, as_shader* shader)
+{
+	 as_shader_update_arg shader_update_arg = { 0 };
+	 shader_update_arg.render = render;
+	 shader_update_arg.shader = shader;
+	 return as_rq_submit_async_to_lane(render_queue, AS_RENDER_LANE_BACKGROUND, &as_shader_update_func, &shader_update_arg, sizeof(shader_update_arg), shader);
 }
 
  typedef struct as_shader_create_graphics_pipeline_arg
@@ -295,7 +1190,7 @@ void as_rq_texture_update(as_render_queue* render_queue, as_texture* texture, as
 	 {
 		 as_shader_create_graphics_pipeline_arg shader_create_graphics_pipeline_arg = { 0 };
 		 shader_create_graphics_pipeline_arg.shader = shader;
-		 as_rq_submit(render_queue, &as_shader_create_graphics_pipeline_func, &shader_create_graphics_pipeline_arg, sizeof(shader_create_graphics_pipeline_arg));
+		 as_rq_submit_keyed(render_queue, &as_shader_create_graphics_pipeline_func, shader, &shader_create_graphics_pipeline_arg, sizeof(shader_create_graphics_pipeline_arg));
 	 }
 	 else if (AS_IS_VALID(render_queue->render))
 	 {
@@ -341,7 +1236,38 @@ void as_rq_texture_update(as_render_queue* render_queue, as_texture* texture, as
 	 object_update_arg.shape = shape;
 	 object_update_arg.shader = shader;
 
-	 as_rq_submit(render_queue, &as_object_update_func, &object_update_arg, sizeof(object_update_arg));
+	 as_rq_push_upload(render_queue, &as_object_update_func, object, &object_update_arg, sizeof(object_update_arg));
+ }
+ as_future* as_rq_object_update_async(as_render_queue* render_queue, as_render* render, as_object* object, as_shape* shape, as_shader* shader)
+ {
+	 as_object_update_arg object_update_arg = { 0 };
+	 object_update_arg.render = render;
+	 object_update_arg.object = object;
+	 object_update_arg.shape = shape;
+	 object_update_arg.shader = shader;
+
+	 return as_rq_submit_async_to_lane(render_queue, AS_RENDER_LANE_BACKGROUND, &as_object_update_func, &object_update_arg, sizeof(object_update_arg), object);
+ }
+
+ typedef struct as_object_remove_arg
+ {
+	 as_render* render;
+	 as_scene* scene;
+	 as_object* object;
+ } as_object_remove_arg;
+ void as_object_remove_func(as_object_remove_arg* object_remove_arg)
+ {
+	 AS_WAIT_AND_LOCK(object_remove_arg->render);
+	 as_object_remove(object_remove_arg->render, object_remove_arg->scene, object_remove_arg->object);
+	 AS_UNLOCK(object_remove_arg->render);
+ }
+ void as_rq_object_remove(as_render_queue* render_queue, as_render* render, as_scene* scene, as_object* object)
+ {
+	 as_object_remove_arg object_remove_arg = { 0 };
+	 object_remove_arg.render = render;
+	 object_remove_arg.scene = scene;
+	 object_remove_arg.object = object;
+	 as_rq_submit(render_queue, &as_object_remove_func, &object_remove_arg, sizeof(object_remove_arg));
  }
 
  typedef struct as_scene_destroy_arg
@@ -362,3 +1288,438 @@ void as_rq_scene_destroy(as_render_queue* render_queue, as_render* render, as_sc
 	scene_destroy_arg.scene = scene;
 	as_rq_submit(render_queue, &as_scene_destroy_func, &scene_destroy_arg, sizeof(scene_destroy_arg));
 }
+
+#define AS_RQ_COMMAND_NAME(_func, _arg_type, _is_replayable, ...) { (void (*)(void*))&(_func), #_func, _is_replayable, sizeof(_arg_type) / sizeof(void*), { __VA_ARGS__ } }
+static const as_rq_command_name as_rq_command_names[] =
+{
+	AS_RQ_COMMAND_NAME(as_render_start_draw_loop_func, as_render*, true, AS_RQ_BINDING_RENDER),
+	AS_RQ_COMMAND_NAME(as_render_end_draw_loop_func, as_render*, true, AS_RQ_BINDING_RENDER),
+	AS_RQ_COMMAND_NAME(as_render_draw_frame_func, as_render_draw_frame_arg, true,
+		AS_RQ_BINDING_RENDER, AS_RQ_BINDING_DISPLAY, AS_RQ_BINDING_CAMERA, AS_RQ_BINDING_SCENE, AS_RQ_BINDING_UI_GROUP, AS_RQ_BINDING_SNAPSHOT),
+	AS_RQ_COMMAND_NAME(as_render_destroy_func, as_render*, false, AS_RQ_BINDING_RENDER),
+	AS_RQ_COMMAND_NAME(as_screen_object_update_func, as_screen_object_update_arg, true, AS_RQ_BINDING_RENDER, AS_RQ_BINDING_SCREEN_OBJECT),
+	AS_RQ_COMMAND_NAME(as_screen_object_recompile_func, as_screen_object_update_arg, true, AS_RQ_BINDING_RENDER, AS_RQ_BINDING_SCREEN_OBJECT),
+	AS_RQ_COMMAND_NAME(as_texture_update_func, as_texture_update_arg, true, AS_RQ_BINDING_RENDER, AS_RQ_BINDING_TEXTURE),
+	AS_RQ_COMMAND_NAME(as_texture_destroy_func, as_texture_destroy_arg, false, AS_RQ_BINDING_TEXTURE),
+	AS_RQ_COMMAND_NAME(as_shader_set_uniforms_func, as_shader_set_uniforms_arg, true, AS_RQ_BINDING_RENDER, AS_RQ_BINDING_SHADER, AS_RQ_BINDING_UNIFORMS),
+	AS_RQ_COMMAND_NAME(as_shader_update_func, as_shader_update_arg, true, AS_RQ_BINDING_RENDER, AS_RQ_BINDING_SHADER),
+	AS_RQ_COMMAND_NAME(as_shader_create_graphics_pipeline_func, as_shader_create_graphics_pipeline_arg, true, AS_RQ_BINDING_SHADER),
+	AS_RQ_COMMAND_NAME(as_shader_destroy_func, as_shader_destroy_arg, false, AS_RQ_BINDING_RENDER, AS_RQ_BINDING_SHADER),
+	AS_RQ_COMMAND_NAME(as_object_update_func, as_object_update_arg, true, AS_RQ_BINDING_RENDER, AS_RQ_BINDING_OBJECT, AS_RQ_BINDING_SHAPE, AS_RQ_BINDING_SHADER),
+	AS_RQ_COMMAND_NAME(as_object_remove_func, as_object_remove_arg, false, AS_RQ_BINDING_RENDER, AS_RQ_BINDING_SCENE, AS_RQ_BINDING_OBJECT),
+	AS_RQ_COMMAND_NAME(as_scene_destroy_func, as_scene_destroy_arg, false, AS_RQ_BINDING_RENDER, AS_RQ_BINDING_SCENE),
+};
+#define AS_RQ_COMMAND_NAMES_COUNT (sizeof(as_rq_command_names) / sizeof(as_rq_command_names[0]))
+
+static const as_rq_command_name* as_rq_find_command(void func_ptr(void*))
+{
+	for (sz i = 0; i < AS_RQ_COMMAND_NAMES_COUNT; i++)
+	{
+		if (as_rq_command_names[i].func_ptr == func_ptr) { return &as_rq_command_names[i]; }
+	}
+	return NULL;
+}
+
+const char* as_rq_get_command_name(void func_ptr(void*))
+{
+	const as_rq_command_name* command = as_rq_find_command(func_ptr);
+	return command ? command->name : NULL;
+}
+
+static const as_rq_command_name* as_rq_find_command_name(const char* name, const sz name_size)
+{
+	for (sz i = 0; i < AS_RQ_COMMAND_NAMES_COUNT; i++)
+	{
+		if (strlen(as_rq_command_names[i].name) == name_size && strncmp(as_rq_command_names[i].name, name, name_size) == 0) { return &as_rq_command_names[i]; }
+	}
+	return NULL;
+}
+
+typedef struct as_rq_replay_binding
+{
+	as_rq_binding_kind kind;
+	void* ptr;
+} as_rq_replay_binding;
+AS_VECTOR_DECLARE(as_rq_replay_bindings, as_rq_replay_binding); // by id - 1
+
+// the values of a command, the slot is reused once that command retired
+typedef struct as_rq_replay_values
+{
+	as_render_snapshot snapshot;
+	as_camera camera;
+	as_shader_uniforms uniforms;
+	as_rq_ticket ticket;
+} as_rq_replay_values;
+#define AS_RQ_REPLAY_VALUES_COUNT AS_RENDER_SNAPSHOTS_COUNT
+
+// what a replay made, destroyed on the render thread once it is done
+typedef struct as_rq_replay_state
+{
+	as_render_queue* render_queue;
+	as_render* render;
+	void* display_context;
+	as_scene* scene; // every captured scene, objects do not know theirs
+	as_screen_objects_group* ui_objects_group;
+	as_rq_replay_bindings bindings;
+	as_rq_replay_values* values;
+	sz values_index;
+} as_rq_replay_state;
+
+typedef struct as_rq_replay_reader
+{
+	const u8* data;
+	sz size;
+	sz offset;
+	b8 is_valid; // false once a read went past the end, the reads return zeroes from there
+} as_rq_replay_reader;
+
+static void as_rq_replay_read(as_rq_replay_reader* reader, void* out, const sz size)
+{
+	if (!reader->is_valid || size > reader->size - reader->offset)
+	{
+		reader->is_valid = false;
+		memset(out, 0, size);
+		return;
+	}
+	memcpy(out, reader->data + reader->offset, size);
+	reader->offset += size;
+}
+
+static u8 as_rq_replay_read_u8(as_rq_replay_reader* reader) { u8 value; as_rq_replay_read(reader, &value, sizeof(value)); return value; }
+static u32 as_rq_replay_read_u32(as_rq_replay_reader* reader) { u32 value; as_rq_replay_read(reader, &value, sizeof(value)); return value; }
+static u64 as_rq_replay_read_u64(as_rq_replay_reader* reader) { u64 value; as_rq_replay_read(reader, &value, sizeof(value)); return value; }
+
+static void as_rq_replay_read_string(as_rq_replay_reader* reader, char out[AS_MAX_PATH_SIZE])
+{
+	const u32 size = as_rq_replay_read_u32(reader);
+	if (size >= AS_MAX_PATH_SIZE) { reader->is_valid = false; }
+	as_rq_replay_read(reader, out, reader->is_valid ? size : 0);
+	out[reader->is_valid ? size : 0] = '\0';
+}
+
+static void* as_rq_replay_get(as_rq_replay_state* state, const u32 id, const as_rq_binding_kind kind)
+{
+	if (id == 0 || id > state->bindings.size) { return NULL; }
+	const as_rq_replay_binding* binding = &state->bindings.data[id - 1];
+	return binding->kind == kind ? binding->ptr : NULL;
+}
+
+static void as_rq_replay_read_uniforms(as_rq_replay_state* state, as_rq_replay_reader* reader, as_shader_uniforms* uniforms)
+{
+	AS_ARRAY_CLEAR(*uniforms);
+	const u32 texture_count = as_rq_replay_read_u32(reader);
+	for (u32 i = 0; i < texture_count && reader->is_valid; i++)
+	{
+		const u32 stage = as_rq_replay_read_u32(reader);
+		as_texture* texture = (as_texture*)as_rq_replay_get(state, as_rq_replay_read_u32(reader), AS_RQ_BINDING_TEXTURE);
+		as_shader_uniform* uniform = AS_ARRAY_INCREMENT(*uniforms);
+		if (!uniform) { continue; }
+		uniform->type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		uniform->stage = (VkShaderStageFlagBits)stage;
+		uniform->data = texture;
+	}
+}
+
+// the objects point to the replay ones, the screen objects that were not captured are left out
+static void as_rq_replay_read_snapshot(as_rq_replay_state* state, as_rq_replay_reader* reader, as_render_snapshot* snapshot)
+{
+	snapshot->objects_size = (sz)as_rq_replay_read_u64(reader);
+	if (snapshot->objects_size > AS_RENDER_SNAPSHOT_MAX_OBJECTS) { reader->is_valid = false; snapshot->objects_size = 0; }
+	for (sz i = 0; i < snapshot->objects_size; i++)
+	{
+		as_object* object = (as_object*)as_rq_replay_get(state, as_rq_replay_read_u32(reader), AS_RQ_BINDING_OBJECT);
+		snapshot->objects[i] = object;
+		snapshot->objects_handles[i] = object ? object->handle : AS_HANDLE_INVALID;
+	}
+	as_rq_replay_read(reader, snapshot->objects_transforms, sizeof(as_mat4) * (snapshot->objects_size < AS_MAX_GPU_OBJECT_TRANSFORMS_SIZE ? snapshot->objects_size : AS_MAX_GPU_OBJECT_TRANSFORMS_SIZE));
+	as_rq_replay_read(reader, &snapshot->camera, sizeof(as_camera));
+	const u64 ui_size = as_rq_replay_read_u64(reader);
+	if (ui_size > AS_MAX_SCREEN_OBJECTS) { reader->is_valid = false; }
+	as_screen_object* ui_objects[AS_MAX_SCREEN_OBJECTS] = { 0 };
+	for (sz i = 0; i < ui_size && reader->is_valid; i++)
+	{
+		ui_objects[i] = (as_screen_object*)as_rq_replay_get(state, as_rq_replay_read_u32(reader), AS_RQ_BINDING_SCREEN_OBJECT);
+	}
+	snapshot->ui_size = 0;
+	for (sz i = 0; i < ui_size && reader->is_valid; i++)
+	{
+		as_rq_replay_read(reader, &snapshot->ui_data[snapshot->ui_size], sizeof(as_mat4));
+		as_rq_replay_read(reader, snapshot->ui_custom_data[snapshot->ui_size], sizeof(snapshot->ui_custom_data[0]));
+		snapshot->ui_objects[snapshot->ui_size] = ui_objects[i];
+		snapshot->ui_size += ui_objects[i] ? 1 : 0;
+	}
+	snapshot->frame_index = as_rq_replay_read_u64(reader);
+}
+
+// makes what the id stands for, uploads go to the normal lane so the commands after them see them
+static void as_rq_replay_bind(as_rq_replay_state* state, const as_rq_capture_record* record, as_rq_replay_reader* reader)
+{
+	as_render_queue* render_queue = state->render_queue;
+	as_render* render = state->render;
+	char path[AS_MAX_PATH_SIZE];
+	void* ptr = NULL;
+	switch (record->kind)
+	{
+	case AS_RQ_BINDING_TEXTURE:
+	{
+		as_rq_replay_read_string(reader, path);
+		const b8 is_uploaded = as_rq_replay_read_u8(reader);
+		if (!reader->is_valid) { break; }
+		as_texture* texture = as_texture_make(path);
+		if (is_uploaded)
+		{
+			as_texture_update_arg texture_update_arg = { render, texture };
+			as_rq_push_command(render_queue, AS_RENDER_LANE_NORMAL, &as_texture_update_func, texture, &texture_update_arg, sizeof(texture_update_arg), NULL, NULL);
+		}
+		ptr = texture;
+		break;
+	}
+	case AS_RQ_BINDING_SHADER:
+	{
+		char fragment_path[AS_MAX_PATH_SIZE];
+		as_rq_replay_read_string(reader, path);
+		as_rq_replay_read_string(reader, fragment_path);
+		as_shader_uniforms uniforms = { 0 };
+		as_rq_replay_read_uniforms(state, reader, &uniforms);
+		const b8 is_uploaded = as_rq_replay_read_u8(reader);
+		if (!reader->is_valid) { break; }
+		as_shader* shader = as_shader_make(render, path, fragment_path);
+		shader->uniforms = uniforms;
+		if (is_uploaded)
+		{
+			as_shader_update_arg shader_update_arg = { render, shader };
+			as_rq_push_command(render_queue, AS_RENDER_LANE_NORMAL, &as_shader_update_func, shader, &shader_update_arg, sizeof(shader_update_arg), NULL, NULL);
+		}
+		ptr = shader;
+		break;
+	}
+	case AS_RQ_BINDING_SHAPE:
+	{
+		const u64 vertices_size = as_rq_replay_read_u64(reader);
+		const u64 indices_size = as_rq_replay_read_u64(reader);
+		if (vertices_size > AS_MAX_VERTICES_SIZE || indices_size > AS_MAX_INDICES_SIZE) { reader->is_valid = false; }
+		if (!reader->is_valid) { break; }
+		as_shape* shape = AS_SLAB_ALLOC_SINGLE(&as_shapes_slab, as_shape);
+		shape->vertices_size = (sz)vertices_size;
+		shape->indices_size = (sz)indices_size;
+		as_rq_replay_read(reader, shape->vertices, sizeof(as_vertex) * vertices_size);
+		as_rq_replay_read(reader, shape->indices, sizeof(u16) * indices_size);
+		ptr = shape;
+		break;
+	}
+	case AS_RQ_BINDING_OBJECT:
+	{
+		as_shape* shape = (as_shape*)as_rq_replay_get(state, as_rq_replay_read_u32(reader), AS_RQ_BINDING_SHAPE);
+		as_shader* shader = (as_shader*)as_rq_replay_get(state, as_rq_replay_read_u32(reader), AS_RQ_BINDING_SHADER);
+		as_transform transform;
+		as_rq_replay_read(reader, &transform, sizeof(transform));
+		const u32 instance_count = as_rq_replay_read_u32(reader);
+		const b8 is_uploaded = as_rq_replay_read_u8(reader);
+		if (!reader->is_valid) { break; }
+		as_object* object = as_object_consturct(render, state->scene);
+		object->transform = transform;
+		object->instance_count = instance_count;
+		if (is_uploaded && shape && shader)
+		{
+			as_object_update_arg object_update_arg = { render, object, shape, shader };
+			as_rq_push_command(render_queue, AS_RENDER_LANE_NORMAL, &as_object_update_func, object, &object_update_arg, sizeof(object_update_arg), NULL, NULL);
+		}
+		ptr = object;
+		break;
+	}
+	case AS_RQ_BINDING_SCREEN_OBJECT:
+	{
+		as_rq_replay_read_string(reader, path);
+		const u32 type = as_rq_replay_read_u32(reader);
+		as_mat4 data;
+		as_rq_replay_read(reader, &data, sizeof(data));
+		u32 custom_data[AS_MAX_GPU_SCREEN_OBJECT_CUSTOM_DATA_SIZE];
+		as_rq_replay_read(reader, custom_data, sizeof(custom_data));
+		as_shader_uniforms uniforms = { 0 };
+		as_rq_replay_read_uniforms(state, reader, &uniforms);
+		const b8 is_uploaded = as_rq_replay_read_u8(reader);
+		as_screen_object* screen_object = reader->is_valid ? AS_ARRAY_INCREMENT(*state->ui_objects_group) : NULL;
+		if (!screen_object) { break; }
+		as_screen_object_init(render, screen_object, path);
+		screen_object->type = (as_screen_object_type)type;
+		screen_object->data = data;
+		memcpy(screen_object->custom_data, custom_data, sizeof(custom_data));
+		screen_object->uniforms = uniforms;
+		if (is_uploaded)
+		{
+			as_screen_object_update_arg screen_object_update_arg = { render, screen_object };
+			as_rq_push_command(render_queue, AS_RENDER_LANE_NORMAL, &as_screen_object_update_func, screen_object, &screen_object_update_arg, sizeof(screen_object_update_arg), NULL, NULL);
+		}
+		ptr = screen_object;
+		break;
+	}
+	default:
+		break;
+	}
+	if (!ptr || record->id == 0) { return; }
+	const sz old_size = state->bindings.size;
+	if (record->id > old_size)
+	{
+		if (!AS_VECTOR_RESERVE(state->bindings, record->id)) { return; }
+		memset(state->bindings.data + old_size, 0, sizeof(as_rq_replay_binding) * (record->id - old_size));
+		state->bindings.size = record->id;
+	}
+	state->bindings.data[record->id - 1].kind = (as_rq_binding_kind)record->kind;
+	state->bindings.data[record->id - 1].ptr = ptr;
+}
+
+// the next values slot, once the command that last used it retired
+static as_rq_replay_values* as_rq_replay_get_values(as_rq_replay_state* state)
+{
+	as_rq_replay_values* values = &state->values[state->values_index++ % AS_RQ_REPLAY_VALUES_COUNT];
+	as_rq_wait_ticket(state->render_queue, values->ticket);
+	values->ticket = 0;
+	return values;
+}
+
+static as_rq_ticket as_rq_replay_command(as_rq_replay_state* state, const as_rq_command_name* command, const as_rq_capture_record* record, as_rq_replay_reader* reader)
+{
+	u32 ids[AS_RQ_MAX_ARG_POINTERS] = { 0 };
+	void* pointers[AS_RQ_MAX_ARG_POINTERS] = { 0 };
+	as_rq_replay_values* values = NULL;
+	as_rq_replay_read(reader, ids, sizeof(u32) * command->pointer_count);
+	for (u32 i = 0; i < command->pointer_count && reader->is_valid; i++)
+	{
+		const as_rq_binding_kind kind = (as_rq_binding_kind)command->pointer_kinds[i];
+		if (ids[i] == 0) { continue; }
+		switch (kind)
+		{
+		case AS_RQ_BINDING_RENDER: pointers[i] = state->render; break;
+		case AS_RQ_BINDING_DISPLAY: pointers[i] = state->display_context; break;
+		case AS_RQ_BINDING_SCENE: pointers[i] = state->scene; break;
+		case AS_RQ_BINDING_UI_GROUP: pointers[i] = state->ui_objects_group; break;
+		case AS_RQ_BINDING_CAMERA:
+			values = values ? values : as_rq_replay_get_values(state);
+			as_rq_replay_read(reader, &values->camera, sizeof(as_camera));
+			pointers[i] = &values->camera;
+			break;
+		case AS_RQ_BINDING_SNAPSHOT:
+			values = values ? values : as_rq_replay_get_values(state);
+			as_rq_replay_read_snapshot(state, reader, &values->snapshot);
+			pointers[i] = &values->snapshot;
+			break;
+		case AS_RQ_BINDING_UNIFORMS:
+			values = values ? values : as_rq_replay_get_values(state);
+			as_rq_replay_read_uniforms(state, reader, &values->uniforms);
+			pointers[i] = &values->uniforms;
+			break;
+		default:
+			pointers[i] = as_rq_replay_get(state, ids[i], kind);
+			break;
+		}
+	}
+	if (!reader->is_valid) { return 0; }
+	void* key_target = record->key_index > 0 && record->key_index <= command->pointer_count ? pointers[record->key_index - 1] : NULL;
+	const as_rq_ticket ticket = as_rq_push_command(state->render_queue, (as_render_lane)record->lane, command->func_ptr, key_target, pointers, sizeof(void*) * command->pointer_count, NULL, NULL);
+	if (values) { values->ticket = ticket; }
+	return ticket;
+}
+
+typedef struct as_rq_replay_release_arg
+{
+	as_rq_replay_state* state;
+} as_rq_replay_release_arg;
+static void as_rq_replay_release_func(as_rq_replay_release_arg* arg)
+{
+	as_rq_replay_state* state = arg->state;
+	// objects destroy their shader, these are shared so they are destroyed once below instead
+	AS_VECTOR_FOR_EACH(state->bindings, as_rq_replay_binding, binding,
+	{
+		if (binding->kind == AS_RQ_BINDING_OBJECT) { ((as_object*)binding->ptr)->shader = NULL; }
+	});
+	as_scene_destroy(state->render, state->scene); // waits for the device idle
+	as_screen_objects_group_destroy(state->ui_objects_group);
+	AS_VECTOR_FOR_EACH(state->bindings, as_rq_replay_binding, binding,
+	{
+		switch (binding->kind)
+		{
+		case AS_RQ_BINDING_TEXTURE: as_texture_free((as_texture*)binding->ptr); break;
+		case AS_RQ_BINDING_SHADER:
+			if (AS_IS_INVALID((as_shader*)binding->ptr)) { as_shader_free((as_shader*)binding->ptr); }
+			else { as_shader_destroy(state->render, (as_shader*)binding->ptr); }
+			break;
+		case AS_RQ_BINDING_SHAPE: as_destroy_shape((as_shape*)binding->ptr); break;
+		default: break;
+		}
+	});
+}
+
+as_rq_replay_result as_rq_replay(as_render_queue* render_queue, void* display_context, const char* path, const as_rq_replay_timing timing)
+{
+	as_rq_replay_result result = { 0 };
+	AS_WARNING_RETURN_VAL_IF_FALSE(!AS_IS_INVALID(render_queue), result, "Cannot replay render queue capture, invalid render queue %p", render_queue);
+	AS_WARNING_RETURN_VAL_IF_FALSE(!AS_IS_INVALID(render_queue->render), result, "Cannot replay render queue capture, invalid render %p", render_queue->render);
+	AS_WARNING_RETURN_VAL_IF_FALSE(path, result, "Cannot replay render queue capture, invalid path %p", path);
+	sz size = 0;
+	u8* data = (u8*)as_util_read_file(path, &size);
+	AS_WARNING_RETURN_VAL_IF_FALSE(data, result, "Cannot replay render queue capture, could not read %s", path);
+	if (size < 8 || memcmp(data, AS_RENDER_QUEUE_CAPTURE_MAGIC, 8) != 0)
+	{
+		AS_FLOG(LV_WARNING, "Cannot replay render queue capture, %s is not a capture of this version", path);
+		AS_FREE(data);
+		return result;
+	}
+
+	as_rq_replay_state state = { 0 };
+	state.render_queue = render_queue;
+	state.render = render_queue->render;
+	state.display_context = display_context;
+	state.scene = as_scene_create(state.render, path);
+	state.ui_objects_group = as_screen_objects_group_create();
+	state.values = (as_rq_replay_values*)AS_MALLOC_TAGGED(sizeof(as_rq_replay_values) * AS_RQ_REPLAY_VALUES_COUNT, "as_rq_replay_values", AS_MEMORY_TAG_QUEUE);
+
+	const f64 start_time = get_monotonic_time();
+	sz offset = 8;
+	while (offset + sizeof(as_rq_capture_record) <= size)
+	{
+		as_rq_capture_record record;
+		memcpy(&record, data + offset, sizeof(record));
+		const char* name = (const char*)data + offset + sizeof(record);
+		if (record.pointer_count > AS_RQ_MAX_ARG_POINTERS || record.name_size > size || record.data_size > size || offset + sizeof(record) + record.name_size + record.data_size > size)
+		{
+			AS_FLOG(LV_WARNING, "Render queue capture %s is truncated or corrupted at byte %zu, replay stopped there", path, offset);
+			break;
+		}
+		as_rq_replay_reader reader = { (const u8*)name + record.name_size, (sz)record.data_size, 0, true };
+		offset += sizeof(record) + record.name_size + record.data_size;
+
+		if (record.type == AS_RQ_CAPTURE_RECORD_BINDING)
+		{
+			as_rq_replay_bind(&state, &record, &reader);
+			continue;
+		}
+		const as_rq_command_name* command = as_rq_find_command_name(name, record.name_size);
+		if (!command || !command->is_replayable || record.pointer_count != command->pointer_count || record.lane >= AS_RENDER_LANE_COUNT)
+		{
+			result.skipped_count++;
+			continue;
+		}
+		if (timing == AS_RQ_REPLAY_TIMING_RECORDED)
+		{
+			const f64 remaining = start_time + (f64)record.time * 1e-9 - get_monotonic_time();
+			if (remaining > 0.) { sleep_seconds(remaining); }
+		}
+		if (as_rq_replay_command(&state, command, &record, &reader))
+		{
+			result.command_count++;
+		}
+	}
+	as_rq_wait_queue(render_queue);
+	result.duration = get_monotonic_time() - start_time;
+	result.binding_count = state.bindings.size;
+
+	as_rq_replay_release_arg release_arg = { &state };
+	as_rq_submit(render_queue, &as_rq_replay_release_func, &release_arg, sizeof(release_arg));
+	as_rq_wait_queue(render_queue);
+	AS_VECTOR_FREE(state.bindings);
+	AS_FREE(state.values);
+	AS_FREE(data);
+	AS_FLOG(LV_LOG, "Replayed %zu render commands from %s in %.3f s (%.0f commands/s), skipped %zu, made %zu objects for it",
+		result.command_count, path, result.duration, result.duration > 0. ? (f64)result.command_count / result.duration : 0., result.skipped_count, result.binding_count);
+	return result;
+}
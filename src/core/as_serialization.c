@@ -49,7 +49,7 @@ void as_deserialize_object(as_object* object, as_serialized_object* serialized_o
 
 	object->transform = serialized_object->transform;
 	object->instance_count = serialized_object->instance_count;
-	object->shader = AS_MALLOC_SINGLE(as_shader);
+	object->shader = as_shader_make(render, "", "");
 	object->shape = &serialized_object->shape;
 	as_deserialize_shader(object->shader, &serialized_object->shader, render, render_queue);
 	AS_SET_VALID(object);
@@ -120,14 +120,17 @@ void as_serialize_scene(as_scene* scene, as_serialized_scene* serialized_scene)
 
 	strcpy(serialized_scene->path, scene->path);
 
-	for (sz i = 0; i < AS_ARRAY_GET_SIZE(scene->objects) ; i++)
+	for (sz i = 0; i < AS_HANDLE_TABLE_GET_SIZE(scene->objects) ; i++)
 	{
-		as_object* object = AS_ARRAY_GET(scene->objects, i);
+		as_object* object = AS_HANDLE_TABLE_GET_AT(scene->objects, as_object, i);
 		as_serialized_object* serialized_object = AS_ARRAY_INCREMENT(serialized_scene->objects);
+		if (!serialized_object)
+		{
+			AS_FLOG(LV_WARNING, "Serialized scene is full, skipping the last %zu objects", AS_HANDLE_TABLE_GET_SIZE(scene->objects) - i);
+			break;
+		}
 
-		AS_WAIT_AND_LOCK(object);
-		as_serialize_object(object, serialized_object);
-		AS_UNLOCK(object);
+		as_serialize_object(object, serialized_object); // locks the object itself
 	}
 
 	for (sz i = 0; i < AS_ARRAY_GET_SIZE(scene->cameras); i++)
@@ -135,9 +138,7 @@ void as_serialize_scene(as_scene* scene, as_serialized_scene* serialized_scene)
 		as_camera* camera = AS_ARRAY_GET(scene->cameras, i);
 		as_serialized_camera* serialized_camera = AS_ARRAY_INCREMENT(serialized_scene->cameras);
 
-		AS_WAIT_AND_LOCK(camera);
 		as_serialize_camera(camera, serialized_camera);
-		AS_UNLOCK(camera);
 	}
 
 	for (sz i = 0; i < AS_ARRAY_GET_SIZE(scene->lights); i++)
@@ -160,7 +161,7 @@ void as_deserialize_scene(as_scene* scene, as_serialized_scene* serialized_scene
 	for (sz i = 0; i < AS_ARRAY_GET_SIZE(serialized_scene->objects); i++)
 	{
 		as_serialized_object* serialized_object = AS_ARRAY_GET(serialized_scene->objects, i);
-		as_object* object = AS_ARRAY_INCREMENT(scene->objects);
+		as_object* object = as_object_consturct(render, scene);
 		as_deserialize_object(object, serialized_object, render, render_queue);
 	}
 
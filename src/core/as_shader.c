@@ -112,6 +112,7 @@ as_shader_binary* as_shader_read_code(as_shader_binary_pool* shader_binary_pool,
 	AS_STATIC_ARRAY_ADD(*shader_binary_pool, found_index);
 	as_shader_binary* ouput_binary = AS_STATIC_ARRAY_GET(*shader_binary_pool, found_index);
 	AS_ASSERT(ouput_binary, "Could not retrieve shader binary from shader binaries pool");
+	ouput_binary->binaries_size = 0; // the pool may live in recycled arena memory
 
 	i32 compile_result = as_shader_compile(ouput_binary, processed_source, "main", shader_type);
 	
@@ -138,9 +139,8 @@ void as_shader_destroy_binary(as_shader_binary_pool* shader_binary_pool, as_shad
 bool as_shader_has_changed(as_shader_binary_pool* shader_binary_pool, as_file_pool* file_pool, const char* path)
 {
 	AS_WARNING_RETURN_VAL_IF_FALSE(file_pool, false, "Cannot check shader, invalid file pool");
-	
-	AS_WAIT_AND_LOCK(file_pool);
-	
+	// the file pool locks itself for every handle, the binary pool belongs to the calling monitor thread
+
 	char proxy_path[AS_MAX_PATH_SIZE] = "";
 	strcpy(proxy_path, path);
 
@@ -163,7 +163,6 @@ bool as_shader_has_changed(as_shader_binary_pool* shader_binary_pool, as_file_po
 		AS_STATIC_ARRAY_REMOVE_PTR(*shader_binary_pool, cached_binary);
 	}
 
-	AS_UNLOCK(file_pool);
 	return !is_same;
 }
 
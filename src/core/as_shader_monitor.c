@@ -19,11 +19,11 @@ void* as_shader_monitor_thread_run(as_shader_monitor_thread* thread_data)
 		as_render_queue* render_queue = thread_data->render_queue;
 		if (shader && AS_IS_UNLOCKED(shader))
 		{
+			// the shader lock is not held while submitting, the render thread takes it to rebuild the pipeline
+			// and the submit can block for a while on a full queue
 			if (as_shader_has_changed(thread_data->shader_binary_pool, thread_data->file_pool, thread_data->file_path))
 			{
-				AS_WAIT_AND_LOCK(shader);
 				thread_data->shader_update_func(render_queue, shader);
-				AS_UNLOCK(shader);
 			}
 			sleep_seconds(1/100.);
 		}
@@ -36,7 +36,7 @@ as_shader_monitor* as_shader_monitor_create(u64* frame_count, as_render_queue* r
 {
 	AS_ASSERT(frame_count, "Cannot create shader monitor, frame_count is null");
 
-	as_shader_monitor* monitor = AS_MALLOC_SINGLE(as_shader_monitor);
+	as_shader_monitor* monitor = AS_MALLOC_SINGLE_TAGGED(as_shader_monitor, AS_MEMORY_TAG_SHADER);
 	monitor->is_running = true;
 	monitor->frame_count = frame_count;
 	monitor->render_queue = render_queue;
@@ -49,23 +49,27 @@ void as_shader_monitored_destroy(as_shader_monitor* monitor)
 {
 	if (!monitor || AS_IS_INVALID(monitor)) { return; }
 	as_mutex_destroy(&monitor->mutex);
-	for (sz i = 0; i < AS_STATIC_ARRAY_SIZE(monitor->threads); i++)
+	AS_STATIC_ARRAY_FOR_EACH_VALID(monitor->threads, i,
 	{
 		as_shader_monitor_thread* monitor_thread = AS_STATIC_ARRAY_GET(monitor->threads, i);
-		if (AS_STATIC_ARRAY_IS_VALID(monitor->threads, i))
-		{
-			AS_STATIC_ARRAY_REMOVE(monitor->threads, i);
-			AS_SET_INVALID(monitor_thread);
-			monitor_thread->is_running = false;
-			as_thread_join(monitor_thread->thread);
-			AS_FREE(monitor_thread->file_pool);
-			AS_FREE(monitor_thread->shader_binary_pool);
-		}
-	}
+		AS_STATIC_ARRAY_REMOVE(monitor->threads, i);
+		AS_SET_INVALID(monitor_thread);
+		monitor_thread->is_running = false;
+		as_thread_join(monitor_thread->thread);
+		AS_FREE(monitor_thread->file_pool);
+		AS_FREE(monitor_thread->shader_binary_pool);
+	});
 	//AS_ARRAY_CLEAR(monitor->threads);
+	as_string_map_destroy(&monitor->shaders_by_files);
 	AS_SET_INVALID(monitor);
 	AS_FREE(monitor);
 }
+#define AS_SHADER_MONITOR_KEY_SIZE (AS_MAX_PATH_SIZE * 2 + 2)
+void as_shader_monitor_make_key(char* output, const char* filename_vertex, const char* filename_fragment)
+{
+	snprintf(output, AS_SHADER_MONITOR_KEY_SIZE, "%s\n%s", filename_vertex, filename_fragment);
+}
+
 void as_shader_monitor_add(u64* frame_counter, as_shader_monitor* monitor, void* shader, const char* file_to_check, void shader_update_func(as_render_queue*, void*))
 {
 	AS_ASSERT(monitor, "cannot add shader to monitor, invalid monitor");
@@ -78,8 +82,8 @@ void as_shader_monitor_add(u64* frame_counter, as_shader_monitor* monitor, void*
 	as_shader_monitor_thread* thread = AS_STATIC_ARRAY_GET(monitor->threads, thread_index);
 	AS_WARNING_RETURN_IF_FALSE(thread, "Could not make a new shader monitor thread, could be a size issue");
 
-	thread->file_pool = AS_MALLOC_SINGLE(as_file_pool);
-	thread->shader_binary_pool = AS_MALLOC_SINGLE(as_shader_binary_pool);
+	thread->file_pool = AS_MALLOC_SINGLE_TAGGED(as_file_pool, AS_MEMORY_TAG_SHADER);
+	thread->shader_binary_pool = AS_MALLOC_SINGLE_TAGGED(as_shader_binary_pool, AS_MEMORY_TAG_SHADER);
 	thread->is_running = true;
 	thread->frame_count = frame_counter;
 	thread->shader_update_func = shader_update_func;
@@ -87,7 +91,15 @@ void as_shader_monitor_add(u64* frame_counter, as_shader_monitor* monitor, void*
 	thread->shader = shader;
 	strcpy(thread->file_path, file_to_check);
 	thread->thread = as_thread_create(as_shader_monitor_thread_run, thread);
+	as_thread_set_name(thread->thread, "as_shader_mon");
 	AS_SET_VALID(thread);
+
+	const as_shader* monitored_shader = shader;
+	char key[AS_SHADER_MONITOR_KEY_SIZE];
+	as_shader_monitor_make_key(key, monitored_shader->filename_vertex, monitored_shader->filename_fragment);
+	as_mutex_lock(&monitor->mutex);
+	as_string_map_set(&monitor->shaders_by_files, key, shader);
+	as_mutex_unlock(&monitor->mutex);
 	AS_FLOG(LV_LOG, "Created shader monitor thread %p", thread);
 }
 //
@@ -120,27 +132,18 @@ void as_shader_monitor_add(u64* frame_counter, as_shader_monitor* monitor, void*
 
 as_shader* as_shader_monitor_find_shader(as_shader_monitor* monitor, const char* filename_vertex, const char* filename_fragment)
 {
-	for (sz i = 0; i < AS_STATIC_ARRAY_SIZE(monitor->threads); i++)
+	AS_ASSERT(monitor, "Cannot find shader, invalid monitor");
+	char key[AS_SHADER_MONITOR_KEY_SIZE];
+	as_shader_monitor_make_key(key, filename_vertex, filename_fragment);
+
+	as_mutex_lock(&monitor->mutex);
+	as_shader* shader_found = as_string_map_get(&monitor->shaders_by_files, key);
+	if (shader_found && (as_shader_get(shader_found->handle) != shader_found || // destroyed since it was monitored
+		strcmp(shader_found->filename_vertex, filename_vertex) != 0 || strcmp(shader_found->filename_fragment, filename_fragment) != 0))
 	{
-		if (!AS_STATIC_ARRAY_IS_VALID(monitor->threads, i))
-		{
-			continue;
-		}
-		as_shader_monitor_thread* thread_found = AS_STATIC_ARRAY_GET(monitor->threads, i);
-		if (!thread_found)
-		{
-			continue;
-		}
-		as_shader* shader_found = thread_found->shader;
-		if (!shader_found)
-		{
-			continue;
-		}
-		if (strcmp(shader_found->filename_fragment, filename_fragment) == 0 &&
-			strcmp(shader_found->filename_vertex, filename_vertex) == 0)
-		{
-			return shader_found;
-		}
+		as_string_map_remove(&monitor->shaders_by_files, key);
+		shader_found = NULL;
 	}
-	return NULL;
+	as_mutex_unlock(&monitor->mutex);
+	return shader_found;
 }
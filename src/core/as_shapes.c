@@ -1,6 +1,8 @@
 #include "core/as_shapes.h"
 #include "as_memory.h"
 
+as_slab as_shapes_slab = AS_SLAB_INITIALIZER(as_shape, AS_MEMORY_TAG_SCENE);
+
 as_shape as_generate_triangle() 
 {
     as_shape triangle;
@@ -67,7 +69,7 @@ as_shape as_generate_quad()
 
 as_shape* as_generate_cube()
 {
-    as_shape* cube = AS_MALLOC_SINGLE(as_shape);
+    as_shape* cube = AS_SLAB_ALLOC_SINGLE(&as_shapes_slab, as_shape);
     cube->vertices_size = 24;
     cube->indices_size = 36;
 
@@ -119,7 +121,7 @@ as_shape* as_generate_cube()
 
 as_shape* as_generate_box(const f32 x_extent, const f32 y_extent, const f32 z_extent)
 {
-	as_shape* box = AS_MALLOC_SINGLE(as_shape);
+	as_shape* box = AS_SLAB_ALLOC_SINGLE(&as_shapes_slab, as_shape);
 	box->vertices_size = 24;
     box->indices_size = 36;
 
@@ -175,7 +177,7 @@ as_shape* as_generate_box(const f32 x_extent, const f32 y_extent, const f32 z_ex
 
 as_shape* as_generate_sphere(const f32 radius, const i32 latitude_divisions, const i32 longitude_divisions) 
 {
-    as_shape* sphere = AS_MALLOC_SINGLE(as_shape);
+    as_shape* sphere = AS_SLAB_ALLOC_SINGLE(&as_shapes_slab, as_shape);
     sz vertex_index = 0;
     sz index_index = 0;
 
@@ -241,7 +243,8 @@ as_shape* as_generate_sphere(const f32 radius, const i32 latitude_divisions, con
 void as_destroy_shape(as_shape* shape)
 {
     AS_ASSERT(shape, "Cannot destroy shape, already null");
-    AS_FREE(shape);
+    AS_SET_INVALID(shape);
+    as_slab_free(&as_shapes_slab, shape);
 }
 
 // TRIANGLE
@@ -7,7 +7,7 @@ as_tick_handle* as_tick_handle_create(as_tick_system* tick_system)
 {
     AS_ASSERT(tick_system, "Cannot add tick handle to system, invalid tick system");
     AS_WAIT_AND_LOCK(tick_system);
-    as_tick_handle* handle = AS_ARRAY_INCREMENT(tick_system->handles);
+    as_tick_handle* handle = AS_VECTOR_INCREMENT(tick_system->handles);
     AS_UNLOCK(tick_system);
     return handle;
 }
@@ -29,6 +29,7 @@ as_tick_system* as_tick_system_create()
 void as_tick_system_destroy(as_tick_system* tick_system)
 {
     if (AS_IS_INVALID(tick_system)) { return; }
+    AS_VECTOR_FREE(tick_system->handles);
     AS_FREE(tick_system);
 }
 
@@ -37,7 +38,7 @@ void as_tick_system_execute(const as_tick_system* tick_system, const f64 delta_t
     AS_ASSERT(tick_system, "Cannot execute tick system, invalid tick system");
     for (sz i = 0; i < tick_system->handles.size ; i++)
     {
-        const as_tick_handle* tick_handle = AS_ARRAY_GET(tick_system->handles, i );
+        const as_tick_handle* tick_handle = AS_VECTOR_GET(tick_system->handles, i);
         as_tick_handle_execute(tick_handle, delta_time);
     }
 }
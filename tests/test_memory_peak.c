@@ -0,0 +1,62 @@
+// Abstract Shader Engine - Jed Fakhfekh - https://github.com/ougi-washi
+
+// allocations freed inside the frame that made them must still raise the peak of their tag
+
+#include "as_memory.h"
+#include "as_threads.h"
+
+#define TEST_BLOCK_SIZE (64 * 1024)
+#define TEST_BLOCK_COUNT 16
+
+typedef struct test_memory_job
+{
+	as_memory_tag tag;
+} test_memory_job;
+
+static void* test_memory_peak_thread(void* arg)
+{
+	const test_memory_job* job = (const test_memory_job*)arg;
+	void* blocks[TEST_BLOCK_COUNT] = { 0 };
+	for (u32 i = 0; i < TEST_BLOCK_COUNT; i++)
+	{
+		blocks[i] = AS_MALLOC_TAGGED(TEST_BLOCK_SIZE, "test", job->tag);
+	}
+	for (u32 i = 0; i < TEST_BLOCK_COUNT; i++)
+	{
+		AS_FREE(blocks[i]);
+	}
+	return NULL;
+}
+
+static b8 test_memory_peak(const char* name, const as_memory_tag tag, const b8 is_other_thread)
+{
+	const as_memory_tag_stats before = as_memory_get_tag_stats(tag);
+	test_memory_job job = { tag };
+	if (is_other_thread)
+	{
+		as_thread thread = as_thread_create(test_memory_peak_thread, &job);
+		as_thread_join(thread);
+	}
+	else
+	{
+		test_memory_peak_thread(&job);
+	}
+	as_memory_end_frame();
+	const as_memory_tag_stats after = as_memory_get_tag_stats(tag);
+
+	const i64 expected_peak = before.current_bytes + TEST_BLOCK_SIZE * TEST_BLOCK_COUNT;
+	const b8 is_ok = after.peak_bytes > 0 && after.peak_bytes >= expected_peak && after.current_bytes == before.current_bytes
+		&& after.last_frame_allocated_bytes == TEST_BLOCK_SIZE * TEST_BLOCK_COUNT && after.last_frame_freed_bytes == TEST_BLOCK_SIZE * TEST_BLOCK_COUNT;
+	printf("%s %s: peak %lld (expected at least %lld), current %lld -> %lld, last frame +%lld/-%lld\n", is_ok ? "ok" : "FAILED", name,
+		(long long)after.peak_bytes, (long long)expected_peak, (long long)before.current_bytes, (long long)after.current_bytes,
+		(long long)after.last_frame_allocated_bytes, (long long)after.last_frame_freed_bytes);
+	return is_ok;
+}
+
+i32 main(i32 argc, char** argv)
+{
+	as_memory_end_frame(); // closes whatever ran before main
+	b8 is_ok = test_memory_peak("same thread", AS_MEMORY_TAG_IO, false);
+	is_ok = test_memory_peak("other thread", AS_MEMORY_TAG_SCENE, true) && is_ok;
+	return is_ok ? 0 : 1;
+}